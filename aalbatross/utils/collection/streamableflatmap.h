@@ -0,0 +1,485 @@
+#ifndef INCLUDED_STREAMS4CPP_STREAMEDFLATMAP_H
+#define INCLUDED_STREAMS4CPP_STREAMEDFLATMAP_H
+
+#include "aalbatross/utils/iterators/listiterator.h"
+#include "streamablecollection.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define STREAMS4CPP_FLATMAP_SSE2
+#endif
+
+namespace aalbatross::utils::collection {
+/**
+ * \class SFlatMap
+ * \brief Streamable Flat Map is an open addressing hash map storing its entries in one contiguous array, in the layout of SwissTable.
+ *
+ * Every slot has a control byte holding 7 bits of the hash of its key (or an empty / deleted marker). Lookups compare the control bytes of a group of 16 slots at once (with SSE2 when available) and only compare keys of slots whose control byte matches, so most probes touch a single cache line and no entry is a separate heap node.
+ * Entries move when the map grows, references and iterators are invalidated by insertion, use reserve() (or the expected size constructor) to insert without rehashing. Iteration order is unspecified.
+ * @tparam Key key type
+ * @tparam T value type
+ * @tparam Hash type of class calculating hash
+ * @tparam KeyEqual type of class calculating equal_to on key
+ */
+template<
+    typename Key,
+    typename T,
+    typename Hash = std::hash<Key>,
+    typename KeyEqual = std::equal_to<Key>>
+struct SFlatMap final : public SCollection<std::pair<const Key, T>> {
+  using key_type = Key;
+  using mapped_type = T;
+  using value_type = std::pair<const Key, T>;
+  using size_type = size_t;
+  using hasher = Hash;
+  using key_equal = KeyEqual;
+
+  template<bool Const>
+  struct FlatIterator {
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = SFlatMap::value_type;
+    using difference_type = std::ptrdiff_t;
+    using pointer = std::conditional_t<Const, const value_type *, value_type *>;
+    using reference = std::conditional_t<Const, const value_type &, value_type &>;
+
+    FlatIterator() = default;
+
+    FlatIterator(const int8_t *control, const int8_t *end, pointer slot) : dControl_(control), dEnd_(end), dSlot_(slot) {
+      skipFree();
+    }
+
+    template<bool OtherConst, typename = std::enable_if_t<Const && !OtherConst>>
+    FlatIterator(const FlatIterator<OtherConst> &other) : dControl_(other.dControl_), dEnd_(other.dEnd_), dSlot_(other.dSlot_) {}
+
+    reference operator*() const { return *dSlot_; }
+
+    pointer operator->() const { return dSlot_; }
+
+    FlatIterator &operator++() {
+      ++dControl_;
+      ++dSlot_;
+      skipFree();
+      return *this;
+    }
+
+    FlatIterator operator++(int) {
+      FlatIterator current = *this;
+      ++*this;
+      return current;
+    }
+
+    friend bool operator==(const FlatIterator &lhs, const FlatIterator &rhs) { return lhs.dControl_ == rhs.dControl_; }
+
+    friend bool operator!=(const FlatIterator &lhs, const FlatIterator &rhs) { return lhs.dControl_ != rhs.dControl_; }
+
+   private:
+    template<bool>
+    friend struct FlatIterator;
+    friend struct SFlatMap;
+
+    const int8_t *dControl_ = nullptr;
+    const int8_t *dEnd_ = nullptr;
+    pointer dSlot_ = nullptr;
+
+    void skipFree() {
+      while (dControl_ != dEnd_ && *dControl_ < 0) {
+        ++dControl_;
+        ++dSlot_;
+      }
+    }
+  };
+
+  using iterator = FlatIterator<false>;
+  using const_iterator = FlatIterator<true>;
+
+  explicit SFlatMap(size_t expectedSize = 0, const Hash &hash = Hash(), const KeyEqual &equal = KeyEqual()) : dHash_(hash), dKeyEqual_(equal) {
+    reserve(expectedSize);
+  }
+
+  SFlatMap(std::initializer_list<value_type> init, const Hash &hash = Hash(), const KeyEqual &equal = KeyEqual()) : SFlatMap(init.size(), hash, equal) {
+    for (const auto &entry : init) {
+      insert(entry);
+    }
+  }
+
+  SFlatMap(const SFlatMap &other) : SFlatMap(other.size(), other.dHash_, other.dKeyEqual_) {
+    for (const auto &entry : other) {
+      insert(entry);
+    }
+  }
+
+  SFlatMap(SFlatMap &&other) noexcept
+      : dHash_(std::move(other.dHash_)), dKeyEqual_(std::move(other.dKeyEqual_)), dControl_(std::move(other.dControl_)), dSlots_(std::exchange(other.dSlots_, nullptr)), dCapacity_(std::exchange(other.dCapacity_, 0)), dSize_(std::exchange(other.dSize_, 0)), dDeleted_(std::exchange(other.dDeleted_, 0)) {}
+
+  SFlatMap &operator=(const SFlatMap &other) {
+    if (this != &other) {
+      SFlatMap copy(other);
+      swap(copy);
+    }
+    return *this;
+  }
+
+  SFlatMap &operator=(SFlatMap &&other) noexcept {
+    if (this != &other) {
+      SFlatMap moved(std::move(other));
+      swap(moved);
+    }
+    return *this;
+  }
+
+  ~SFlatMap() override { release(); }
+
+  streams::Stream<std::pair<const Key, T>, std::pair<const Key, T>> stream() override {
+    return streams::Stream<std::pair<const Key, T>, std::pair<const Key, T>>(this->begin(), this->end());
+  }
+
+  iterator begin() { return iterator(dControl_.get(), dControl_.get() + dCapacity_, dSlots_); }
+  iterator end() { return iterator(dControl_.get() + dCapacity_, dControl_.get() + dCapacity_, dSlots_ + dCapacity_); }
+  const_iterator begin() const { return const_iterator(dControl_.get(), dControl_.get() + dCapacity_, dSlots_); }
+  const_iterator end() const { return const_iterator(dControl_.get() + dCapacity_, dControl_.get() + dCapacity_, dSlots_ + dCapacity_); }
+  const_iterator cbegin() const { return begin(); }
+  const_iterator cend() const { return end(); }
+
+  size_t size() const { return dSize_; }
+
+  bool empty() const { return dSize_ == 0; }
+
+  /**
+   * \fn size_t capacity()
+   * \brief number of slots, the map rehashes when more than 7/8 of them are in use.
+   * @return number of slots
+   */
+  size_t capacity() const { return dCapacity_; }
+
+  /**
+   * \fn void reserve(size_t count)
+   * \brief Allocates room for count entries so that inserting them does not rehash.
+   * @param count expected number of entries
+   */
+  void reserve(size_t count) {
+    size_t capacity = GROUP_WIDTH;
+    while (maxLoad(capacity) < count) {
+      capacity *= 2;
+    }
+    if (count > 0 && capacity > dCapacity_) {
+      rehash(capacity);
+    }
+  }
+
+  void clear() {
+    destroyAll();
+    if (dCapacity_ > 0) {
+      std::fill_n(dControl_.get(), dCapacity_, EMPTY);
+    }
+    dSize_ = 0;
+    dDeleted_ = 0;
+  }
+
+  iterator find(const Key &key) {
+    size_t index = findIndex(key, mix(dHash_(key)));
+    return index == NPOS ? end() : iteratorAt(index);
+  }
+
+  const_iterator find(const Key &key) const {
+    size_t index = findIndex(key, mix(dHash_(key)));
+    return index == NPOS ? end() : const_iterator(dControl_.get() + index, dControl_.get() + dCapacity_, dSlots_ + index);
+  }
+
+  bool contains(const Key &key) const { return findIndex(key, mix(dHash_(key))) != NPOS; }
+
+  size_t count(const Key &key) const { return contains(key) ? 1 : 0; }
+
+  T &at(const Key &key) {
+    size_t index = findIndex(key, mix(dHash_(key)));
+    if (index == NPOS) {
+      throw std::out_of_range("SFlatMap::at key not found");
+    }
+    return dSlots_[index].second;
+  }
+
+  const T &at(const Key &key) const {
+    size_t index = findIndex(key, mix(dHash_(key)));
+    if (index == NPOS) {
+      throw std::out_of_range("SFlatMap::at key not found");
+    }
+    return dSlots_[index].second;
+  }
+
+  T &operator[](const Key &key) { return try_emplace(key).first->second; }
+
+  T &operator[](Key &&key) { return try_emplace(std::move(key)).first->second; }
+
+  /**
+   * \fn std::pair<iterator, bool> try_emplace(K &&key, Args &&...args)
+   * \brief Inserts an entry constructing the value from args if the key does not exist, with a single probe of the table.
+   * @return iterator to the entry of key, and whether it was inserted
+   */
+  template<typename K, typename... Args>
+  std::pair<iterator, bool> try_emplace(K &&key, Args &&...args) {
+    size_t hash = mix(dHash_(key));
+    size_t index = findIndex(key, hash);
+    if (index != NPOS) {
+      return {iteratorAt(index), false};
+    }
+    growIfNeeded();
+    index = findFreeSlot(hash);
+    new (dSlots_ + index) value_type(std::piecewise_construct, std::forward_as_tuple(std::forward<K>(key)), std::forward_as_tuple(std::forward<Args>(args)...));
+    if (dControl_[index] == DELETED) {
+      dDeleted_--;
+    }
+    dControl_[index] = static_cast<int8_t>(hash & H2_MASK);
+    dSize_++;
+    return {iteratorAt(index), true};
+  }
+
+  template<typename K, typename... Args>
+  std::pair<iterator, bool> emplace(K &&key, Args &&...args) {
+    return try_emplace(std::forward<K>(key), std::forward<Args>(args)...);
+  }
+
+  std::pair<iterator, bool> insert(const value_type &entry) { return try_emplace(entry.first, entry.second); }
+
+  std::pair<iterator, bool> insert(value_type &&entry) { return try_emplace(entry.first, std::move(entry.second)); }
+
+  template<typename K, typename V>
+  std::pair<iterator, bool> insert_or_assign(K &&key, V &&value) {
+    auto result = try_emplace(std::forward<K>(key), std::forward<V>(value));
+    if (!result.second) {
+      result.first->second = std::forward<V>(value);
+    }
+    return result;
+  }
+
+  size_t erase(const Key &key) {
+    size_t index = findIndex(key, mix(dHash_(key)));
+    if (index == NPOS) {
+      return 0;
+    }
+    eraseAt(index);
+    return 1;
+  }
+
+  iterator erase(const_iterator position) {
+    size_t index = static_cast<size_t>(position.dControl_ - dControl_.get());
+    eraseAt(index);
+    return iterator(dControl_.get() + index + 1, dControl_.get() + dCapacity_, dSlots_ + index + 1);
+  }
+
+  void swap(SFlatMap &other) noexcept {
+    std::swap(dHash_, other.dHash_);
+    std::swap(dKeyEqual_, other.dKeyEqual_);
+    std::swap(dControl_, other.dControl_);
+    std::swap(dSlots_, other.dSlots_);
+    std::swap(dCapacity_, other.dCapacity_);
+    std::swap(dSize_, other.dSize_);
+    std::swap(dDeleted_, other.dDeleted_);
+  }
+
+  friend bool operator==(const SFlatMap &lhs, const SFlatMap &rhs) {
+    if (lhs.size() != rhs.size()) {
+      return false;
+    }
+    return std::all_of(lhs.begin(), lhs.end(), [&rhs](const value_type &entry) {
+      auto position = rhs.find(entry.first);
+      return position != rhs.end() && position->second == entry.second;
+    });
+  }
+
+  friend bool operator!=(const SFlatMap &lhs, const SFlatMap &rhs) { return !(lhs == rhs); }
+
+ private:
+  static constexpr int8_t EMPTY = -128;
+  static constexpr int8_t DELETED = -2;
+  static constexpr size_t GROUP_WIDTH = 16;
+  static constexpr size_t H2_MASK = 0x7F;
+  static constexpr size_t NPOS = static_cast<size_t>(-1);
+
+  /**
+   * \class Group
+   * \brief Control bytes of 16 consecutive slots, matched at once into a bit mask with one bit per slot.
+   */
+  struct Group {
+    uint32_t matchEmpty() const { return match(EMPTY); }
+
+#ifdef STREAMS4CPP_FLATMAP_SSE2
+    explicit Group(const int8_t *control) : dBytes_(_mm_loadu_si128(reinterpret_cast<const __m128i *>(control))) {}
+
+    uint32_t match(int8_t value) const { return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(value), dBytes_))); }
+
+    uint32_t matchFree() const { return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_set1_epi8(-1), dBytes_))); }
+
+   private:
+    __m128i dBytes_;
+#else
+    explicit Group(const int8_t *control) : dBytes_(control) {}
+
+    uint32_t match(int8_t value) const {
+      uint32_t mask = 0;
+      for (size_t i = 0; i < GROUP_WIDTH; i++) {
+        mask |= static_cast<uint32_t>(dBytes_[i] == value) << i;
+      }
+      return mask;
+    }
+
+    uint32_t matchFree() const {
+      uint32_t mask = 0;
+      for (size_t i = 0; i < GROUP_WIDTH; i++) {
+        mask |= static_cast<uint32_t>(dBytes_[i] < -1) << i;
+      }
+      return mask;
+    }
+
+   private:
+    const int8_t *dBytes_;
+#endif
+  };
+
+  Hash dHash_;
+  KeyEqual dKeyEqual_;
+  std::unique_ptr<int8_t[]> dControl_;
+  value_type *dSlots_ = nullptr;
+  size_t dCapacity_ = 0;
+  size_t dSize_ = 0;
+  size_t dDeleted_ = 0;
+
+  static size_t maxLoad(size_t capacity) { return capacity - capacity / 8; }
+
+  static size_t mix(size_t hash) {
+    uint64_t mixed = static_cast<uint64_t>(hash) * 0x9E3779B97F4A7C15ULL;
+    return static_cast<size_t>(mixed ^ (mixed >> 32U));
+  }
+
+  static size_t lowestBit(uint32_t mask) {
+#if defined(__GNUC__) || defined(__clang__)
+    return static_cast<size_t>(__builtin_ctz(mask));
+#else
+    size_t bit = 0;
+    while ((mask & 1U) == 0) {
+      mask >>= 1U;
+      bit++;
+    }
+    return bit;
+#endif
+  }
+
+  iterator iteratorAt(size_t index) {
+    return iterator(dControl_.get() + index, dControl_.get() + dCapacity_, dSlots_ + index);
+  }
+
+  size_t findIndex(const Key &key, size_t hash) const {
+    if (dCapacity_ == 0) {
+      return NPOS;
+    }
+    auto h2 = static_cast<int8_t>(hash & H2_MASK);
+    size_t groups = dCapacity_ / GROUP_WIDTH;
+    size_t group = (hash >> 7U) & (groups - 1);
+    for (size_t step = 1; step <= groups; step++) {
+      Group control(dControl_.get() + group * GROUP_WIDTH);
+      for (uint32_t mask = control.match(h2); mask != 0; mask &= mask - 1) {
+        size_t index = group * GROUP_WIDTH + lowestBit(mask);
+        if (dKeyEqual_(dSlots_[index].first, key)) {
+          return index;
+        }
+      }
+      if (control.matchEmpty() != 0) {
+        return NPOS;
+      }
+      group = (group + step) & (groups - 1);
+    }
+    return NPOS;
+  }
+
+  size_t findFreeSlot(size_t hash) const {
+    size_t groups = dCapacity_ / GROUP_WIDTH;
+    size_t group = (hash >> 7U) & (groups - 1);
+    for (size_t step = 1;; step++) {
+      if (uint32_t mask = Group(dControl_.get() + group * GROUP_WIDTH).matchFree(); mask != 0) {
+        return group * GROUP_WIDTH + lowestBit(mask);
+      }
+      group = (group + step) & (groups - 1);
+    }
+  }
+
+  void growIfNeeded() {
+    if (dSize_ + dDeleted_ + 1 <= maxLoad(dCapacity_)) {
+      return;
+    }
+    // mostly tombstones, rehash in place instead of growing
+    rehash(dSize_ + 1 > maxLoad(dCapacity_) / 2 ? std::max(GROUP_WIDTH, dCapacity_ * 2) : dCapacity_);
+  }
+
+  void rehash(size_t capacity) {
+    std::unique_ptr<int8_t[]> control(new int8_t[capacity]);
+    std::fill_n(control.get(), capacity, EMPTY);
+    value_type *slots = std::allocator<value_type>().allocate(capacity);
+
+    std::unique_ptr<int8_t[]> oldControl = std::exchange(dControl_, std::move(control));
+    value_type *oldSlots = std::exchange(dSlots_, slots);
+    size_t oldCapacity = std::exchange(dCapacity_, capacity);
+    dDeleted_ = 0;
+    for (size_t index = 0; index < oldCapacity; index++) {
+      if (oldControl[index] >= 0) {
+        value_type &entry = oldSlots[index];
+        size_t hash = mix(dHash_(entry.first));
+        size_t target = findFreeSlot(hash);
+        new (dSlots_ + target) value_type(std::move(entry));
+        dControl_[target] = static_cast<int8_t>(hash & H2_MASK);
+        entry.~value_type();
+      }
+    }
+    if (oldSlots != nullptr) {
+      std::allocator<value_type>().deallocate(oldSlots, oldCapacity);
+    }
+  }
+
+  void eraseAt(size_t index) {
+    dSlots_[index].~value_type();
+    dSize_--;
+    // a group which still has an empty slot never stopped a probe, so the slot can become empty again
+    size_t group = index / GROUP_WIDTH * GROUP_WIDTH;
+    if (Group(dControl_.get() + group).matchEmpty() != 0) {
+      dControl_[index] = EMPTY;
+    } else {
+      dControl_[index] = DELETED;
+      dDeleted_++;
+    }
+  }
+
+  void destroyAll() {
+    if constexpr (!std::is_trivially_destructible_v<value_type>) {
+      for (size_t index = 0; index < dCapacity_; index++) {
+        if (dControl_[index] >= 0) {
+          dSlots_[index].~value_type();
+        }
+      }
+    }
+  }
+
+  void release() {
+    destroyAll();
+    if (dSlots_ != nullptr) {
+      std::allocator<value_type>().deallocate(dSlots_, dCapacity_);
+    }
+    dSlots_ = nullptr;
+    dControl_.reset();
+    dCapacity_ = 0;
+    dSize_ = 0;
+    dDeleted_ = 0;
+  }
+};
+}// namespace aalbatross::utils::collection
+
+#endif//INCLUDED_STREAMS4CPP_STREAMEDFLATMAP_H
@@ -0,0 +1,71 @@
+#ifndef INCLUDED_STREAMS4CPP_STREAMEDWINDOW_H
+#define INCLUDED_STREAMS4CPP_STREAMEDWINDOW_H
+
+#include <cstddef>
+#include <vector>
+
+namespace aalbatross::utils::streams {
+template<typename T, typename S>
+struct Stream;
+}// namespace aalbatross::utils::streams
+
+namespace aalbatross::utils::collection {
+/**
+ * \class SWindow
+ * \brief Streamable Window is a non owning view over a contiguous window of stream elements.
+ *
+ * Windows produced by Stream::chunked and Stream::sliding point into a buffer which is reused for the next window, so a window is valid only until the next window is pulled from the stream. Copy the elements, for example with toVector(), to keep them longer.
+ * @tparam T element type
+ */
+template<typename T>
+struct SWindow final {
+  using value_type = T;
+  using const_iterator = const T *;
+
+  SWindow() = default;
+
+  SWindow(const T *data, size_t size) : dData_(data), dSize_(size) {}
+
+  SWindow(const SWindow &) = default;
+  SWindow(SWindow &&) noexcept = default;
+
+  SWindow &operator=(const SWindow &) = default;
+  SWindow &operator=(SWindow &&) noexcept = default;
+  ~SWindow() = default;
+
+  const T *begin() const { return dData_; }
+
+  const T *end() const { return dData_ + dSize_; }
+
+  size_t size() const { return dSize_; }
+
+  bool empty() const { return dSize_ == 0; }
+
+  const T &operator[](size_t index) const { return dData_[index]; }
+
+  const T &front() const { return dData_[0]; }
+
+  const T &back() const { return dData_[dSize_ - 1]; }
+
+  /**
+   * \fn std::vector<T> toVector()
+   * \brief Copies the elements of the window.
+   * @return owning copy of the window
+   */
+  std::vector<T> toVector() const { return std::vector<T>(begin(), end()); }
+
+  /**
+   * \fn streams::Stream<T, T> stream()
+   * \brief Create stream over the elements of the window.
+   * @return stream from the window.
+   */
+  streams::Stream<T, T> stream() const {
+    return streams::Stream<T, T>(begin(), end());
+  }
+
+ private:
+  const T *dData_ = nullptr;
+  size_t dSize_ = 0;
+};
+}// namespace aalbatross::utils::collection
+#endif//INCLUDED_STREAMS4CPP_STREAMEDWINDOW_H
@@ -2,6 +2,11 @@
 #define INCLUDED_STREAMS4CPP_ITERATOR_H
 
 #include "functional"
+
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <type_traits>
 namespace aalbatross::utils::iterators {
 /**
  * \class Iterator
@@ -26,12 +31,33 @@ struct Iterator {
    */
   virtual std::optional<T> next() = 0;
 
+  /**
+   * \fn std::optional<T> take()
+   * \brief next element, handed over to the caller. Iterators owning their current element (pipeline stages, buffers, consumable views) move it out instead of copying it, so the element must not be read again before the next call of hasNext().
+   * @return element
+   */
+  virtual std::optional<T> take() { return next(); }
+
   /**
    * \fn void reset()
    * \brief reset the source to start from beginning again.
    */
   virtual void reset() = 0;
 
+  /**
+   * \fn std::optional<size_t> size()
+   * \brief number of elements the source yields from the beginning, if it is known without traversing the source.
+   * @return element count for sized sources else empty optional
+   */
+  virtual std::optional<size_t> size() { return std::nullopt; }
+
+  /**
+   * \fn std::unique_ptr<Iterator<T>> reversed()
+   * \brief creates an iterator traversing the same elements from the end to the beginning, if the source can be traversed backwards without buffering.
+   * @return reverse iterator from the beginning of the reversed sequence, or nullptr if the source cannot be traversed backwards
+   */
+  virtual std::unique_ptr<Iterator<T>> reversed() { return nullptr; }
+
   /**
    * \fn void forEachRemaining(std::function<void(T)> consumer)
    * \brief iterate over each remaining element and apply consumer on them.
@@ -43,6 +69,22 @@ struct Iterator {
     }
   }
 };
+
+/**
+ * \fn std::optional<T> current(std::optional<T> &element)
+ * \brief current element held by an iterator, for next(). Copyable elements are copied, move-only elements are moved out since they cannot be shared, so they can be read once.
+ * @tparam T element type
+ * @param element current element
+ * @return element
+ */
+template<typename T>
+inline std::optional<T> current(std::optional<T> &element) {
+  if constexpr (std::is_copy_constructible_v<T>) {
+    return element;
+  } else {
+    return std::move(element);
+  }
+}
 }// namespace aalbatross::utils::iterators
 
 #endif// INCLUDED_STREAMS4CPP_ITERATOR_H
@@ -3,9 +3,17 @@
 
 #include "iterator.h"
 
+#include <iterator>
 #include <optional>
+#include <type_traits>
 
 namespace aalbatross::utils::iterators {
+template<typename Iter>
+struct IsReverseIterator : std::false_type {};
+
+template<typename Iter>
+struct IsReverseIterator<std::reverse_iterator<Iter>> : std::true_type {};
+
 /**
  * \class ListIterator
  * \brief Concrete Class implementation of Iterator to iterate over a sequential list of elements.
@@ -18,7 +26,7 @@ template<typename Iter,
          typename T = typename std::iterator_traits<Iter>::value_type>
 struct ListIterator : public Iterator<T> {
   ListIterator(Iter &&begin, Iter &&end)
-      : dBegin_(begin), dEnd_(end), dCurrent_(begin), dLast_(dBegin_ != dEnd_ ? std::optional<T>{*dBegin_} : std::optional<T>{}) {
+      : dBegin_(begin), dEnd_(end), dCurrent_(begin) {
   }
 
   ListIterator(ListIterator &) = default;
@@ -50,17 +58,59 @@ struct ListIterator : public Iterator<T> {
     return dLast_;
   }
 
+  /**
+   * \fn T take()
+   * \brief next element in the list, the list is not modified: the element is copied once from the list and that copy is handed over.
+   * @return element
+   */
+  inline std::optional<T> take() override {
+    return std::move(dLast_);
+  }
+
   /**
    * \fn void reset()
    * \brief reset the source to start from beginning again.
    */
   inline void reset() override { dCurrent_ = dBegin_; }
 
+  /**
+   * \fn std::optional<size_t> size()
+   * \brief number of elements in the list, constant time for random access ranges and computed once for other multi-pass ranges.
+   * @return element count, or empty optional for single pass ranges
+   */
+  inline std::optional<size_t> size() override {
+    using Category = typename std::iterator_traits<Iter>::iterator_category;
+    if constexpr (std::is_base_of_v<std::forward_iterator_tag, Category>) {
+      if (!dSize_.has_value()) {
+        dSize_.emplace(static_cast<size_t>(std::distance(dBegin_, dEnd_)));
+      }
+    }
+    return dSize_;
+  }
+
+  /**
+   * \fn std::unique_ptr<Iterator<T>> reversed()
+   * \brief creates an iterator over the same list from the last to the first element, the list is not copied.
+   * @return reverse iterator for bidirectional ranges else nullptr
+   */
+  inline std::unique_ptr<Iterator<T>> reversed() override {
+    using Category = typename std::iterator_traits<Iter>::iterator_category;
+    if constexpr (!std::is_base_of_v<std::bidirectional_iterator_tag, Category>) {
+      return nullptr;
+    } else if constexpr (IsReverseIterator<Iter>::value) {
+      using Base = decltype(dBegin_.base());
+      return std::make_unique<ListIterator<Base, T>>(dEnd_.base(), dBegin_.base());
+    } else {
+      return std::make_unique<ListIterator<std::reverse_iterator<Iter>, T>>(std::reverse_iterator<Iter>(dEnd_), std::reverse_iterator<Iter>(dBegin_));
+    }
+  }
+
  private:
   Iter dBegin_;
   Iter dEnd_;
   Iter dCurrent_;
   std::optional<T> dLast_;
+  std::optional<size_t> dSize_;
 };
 
 template<typename Iter,
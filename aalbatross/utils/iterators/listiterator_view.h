@@ -1,12 +1,17 @@
 #ifndef INCLUDED_STREAMS4CPP_LISTITERATOR_VIEW_H_
 #define INCLUDED_STREAMS4CPP_LISTITERATOR_VIEW_H_
 #include "iterator.h"
+
+#include <optional>
+#include <type_traits>
+#include <utility>
 namespace aalbatross::utils::iterators {
 /**
  * \class ListIteratorView
  * \brief Concrete Class implementation of Iterator to iterate over a sequential list of elements.
  *
- * The difference between ListIterator and ListIteratorView is, that ListIteratorView class maintains the copy of data locally hence the presence of source container in scope is not essential.
+ * The difference between ListIterator and ListIteratorView is, that ListIteratorView class owns the data, hence the presence of source container in scope is not essential. The container is copied when it is passed as an lvalue and moved when it is passed as an rvalue.
+ * A consumable view hands its elements over with take() by moving them out of the container, so it yields its elements once: after an element is taken, reset() leaves the view empty.
  *
  * @tparam Container Sequential Container type
  * @tparam T type of element
@@ -14,8 +19,8 @@ namespace aalbatross::utils::iterators {
 template<typename Container,
          typename T = typename Container::value_type>
 struct ListIteratorView : public Iterator<T> {
-  explicit ListIteratorView(Container &storage)
-      : dData_(storage), dBegin_(dData_.begin()), dEnd_(dData_.end()), dCurrent_(dData_.begin()), dLast_((dBegin_ != dEnd_) ? std::optional<T>{*(dData_.begin())} : std::optional<T>{}) {
+  explicit ListIteratorView(Container storage, bool consumable = false)
+      : dData_(std::move(storage)), dCurrent_(dData_.begin()), dPosition_(dData_.begin()), dConsumable_(consumable) {
   }
 
   ListIteratorView(ListIteratorView &) = default;
@@ -32,12 +37,11 @@ struct ListIteratorView : public Iterator<T> {
    * @return true if element exist else false
    */
   inline auto hasNext() -> bool override {
-    bool hasMore = dCurrent_ != dEnd_;
-    if (hasMore) {
-      dLast_.emplace(*dCurrent_);
-      std::advance(dCurrent_, 1);
+    if (dCurrent_ == dData_.end()) {
+      return false;
     }
-    return hasMore;
+    dPosition_ = dCurrent_++;
+    return true;
   }
 
   /**
@@ -46,33 +50,67 @@ struct ListIteratorView : public Iterator<T> {
    * @return element
    */
   inline std::optional<T> next() override {
-    return dLast_;
+    if (dPosition_ == dData_.end()) {
+      return std::nullopt;
+    }
+    if constexpr (std::is_copy_constructible_v<T>) {
+      return std::optional<T>{*dPosition_};
+    } else {
+      return take();
+    }
+  }
+
+  /**
+   * \fn T take()
+   * \brief next element in the list, moved out of the list if the view is consumable or the elements cannot be copied.
+   * @return element
+   */
+  inline std::optional<T> take() override {
+    if (dPosition_ == dData_.end()) {
+      return std::nullopt;
+    }
+    if constexpr (std::is_copy_constructible_v<T>) {
+      if (!dConsumable_) {
+        return std::optional<T>{*dPosition_};
+      }
+    }
+    dTaken_ = true;
+    return std::optional<T>{std::move(*dPosition_)};
   }
 
   /**
    * \fn void reset()
-   * \brief reset the source to start from beginning again.
+   * \brief reset the source to start from beginning again, or to the end if elements were moved out of it.
    */
   inline void reset() override {
-    dBegin_ = dData_.begin();
-    dCurrent_ = dData_.begin();
-    dEnd_ = dData_.end();
-    if (dBegin_ != dEnd_) {
-      dLast_.emplace(*(dData_.begin()));
-    }
+    dCurrent_ = dTaken_ ? dData_.end() : dData_.begin();
+    dPosition_ = dCurrent_;
+  }
+
+  /**
+   * \fn std::optional<size_t> size()
+   * \brief number of elements held by the view.
+   * @return element count
+   */
+  inline std::optional<size_t> size() override {
+    return dTaken_ ? 0 : dData_.size();
   }
 
  private:
   Container dData_;
-  decltype(dData_.begin()) dBegin_;
-  decltype(dData_.end()) dEnd_;
   decltype(dData_.begin()) dCurrent_;
-  std::optional<T> dLast_;
+  decltype(dData_.begin()) dPosition_;
+  bool dConsumable_;
+  bool dTaken_ = false;
 };
 
 template<typename Container,
          typename T = typename Container::value_type>
-ListIteratorView(Container &) -> ListIteratorView<Container, T>;
+ListIteratorView(Container) -> ListIteratorView<Container, T>;
+
+template<typename Container,
+         typename T = typename Container::value_type>
+ListIteratorView(Container, bool) -> ListIteratorView<Container, T>;
 }// namespace aalbatross::utils::iterators
 
 #endif//INCLUDED_STREAMS4CPP_LISTITERATOR_VIEW_H_
@@ -0,0 +1,511 @@
+#ifndef INCLUDED_STREAMS4CPP_PIPELINE_ITERATOR_H_
+#define INCLUDED_STREAMS4CPP_PIPELINE_ITERATOR_H_
+#include "aalbatross/utils/collection/streamablewindow.h"
+#include "iterator.h"
+
+#include <algorithm>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace aalbatross::utils::iterators {
+/**
+ * \class SourceIterator
+ * \brief Iterator forwarding to a source iterator, it is the head of a lazy Stream pipeline.
+ *
+ * The class uses the reference of the source iterator, ensure the source iterator is in the scope of call.
+ * @tparam T element type
+ */
+template<typename T>
+struct SourceIterator : public Iterator<T> {
+  explicit SourceIterator(Iterator<T> &source) : dSource_(source) {}
+
+  ~SourceIterator() override = default;
+
+  inline bool hasNext() override { return dSource_.hasNext(); }
+
+  inline std::optional<T> next() override { return dSource_.next(); }
+
+  inline std::optional<T> take() override { return dSource_.take(); }
+
+  inline void reset() override { dSource_.reset(); }
+
+  inline std::optional<size_t> size() override { return dSource_.size(); }
+
+  inline std::unique_ptr<Iterator<T>> reversed() override { return dSource_.reversed(); }
+
+ private:
+  Iterator<T> &dSource_;
+};
+
+/**
+ * \class MapIterator
+ * \brief Lazy pipeline stage applying a mapping function to every element of the upstream iterator. Elements are taken from the upstream and passed to the mapping function as rvalues, so a mapper taking its argument by value or by rvalue reference moves it instead of copying it.
+ * @tparam T upstream element type
+ * @tparam E mapped element type
+ * @tparam Mapper type of mapping function
+ */
+template<typename T, typename E, typename Mapper>
+struct MapIterator : public Iterator<E> {
+  MapIterator(std::unique_ptr<Iterator<T>> upstream, Mapper mapper) : dUpstream_(std::move(upstream)), dMapper_(std::move(mapper)) {}
+
+  ~MapIterator() override = default;
+
+  inline bool hasNext() override {
+    if (!dUpstream_->hasNext()) {
+      return false;
+    }
+    dLast_.emplace(dMapper_(dUpstream_->take().value()));
+    return true;
+  }
+
+  inline std::optional<E> next() override { return current(dLast_); }
+
+  inline std::optional<E> take() override { return std::move(dLast_); }
+
+  inline void reset() override {
+    dUpstream_->reset();
+    dLast_.reset();
+  }
+
+  inline std::optional<size_t> size() override { return dUpstream_->size(); }
+
+  inline std::unique_ptr<Iterator<E>> reversed() override {
+    auto upstream = dUpstream_->reversed();
+    return upstream ? std::make_unique<MapIterator<T, E, Mapper>>(std::move(upstream), dMapper_) : nullptr;
+  }
+
+ private:
+  std::unique_ptr<Iterator<T>> dUpstream_;
+  Mapper dMapper_;
+  std::optional<E> dLast_;
+};
+
+/**
+ * \class FilterIterator
+ * \brief Lazy pipeline stage yielding only the upstream elements which satisfy a predicate.
+ * @tparam T element type
+ * @tparam Predicate type of predicate function
+ */
+template<typename T, typename Predicate>
+struct FilterIterator : public Iterator<T> {
+  FilterIterator(std::unique_ptr<Iterator<T>> upstream, Predicate predicate) : dUpstream_(std::move(upstream)), dPredicate_(std::move(predicate)) {}
+
+  ~FilterIterator() override = default;
+
+  inline bool hasNext() override {
+    while (dUpstream_->hasNext()) {
+      auto element = dUpstream_->take();
+      if (dPredicate_(std::as_const(element.value()))) {
+        dLast_ = std::move(element);
+        return true;
+      }
+    }
+    return false;
+  }
+
+  inline std::optional<T> next() override { return current(dLast_); }
+
+  inline std::optional<T> take() override { return std::move(dLast_); }
+
+  inline void reset() override {
+    dUpstream_->reset();
+    dLast_.reset();
+  }
+
+  inline std::unique_ptr<Iterator<T>> reversed() override {
+    auto upstream = dUpstream_->reversed();
+    return upstream ? std::make_unique<FilterIterator<T, Predicate>>(std::move(upstream), dPredicate_) : nullptr;
+  }
+
+ private:
+  std::unique_ptr<Iterator<T>> dUpstream_;
+  Predicate dPredicate_;
+  std::optional<T> dLast_;
+};
+
+/**
+ * \class LimitIterator
+ * \brief Lazy pipeline stage truncating the upstream iterator after a given number of elements.
+ * @tparam T element type
+ */
+template<typename T>
+struct LimitIterator : public Iterator<T> {
+  LimitIterator(std::unique_ptr<Iterator<T>> upstream, size_t limit) : dUpstream_(std::move(upstream)), dLimit_(limit) {}
+
+  ~LimitIterator() override = default;
+
+  inline bool hasNext() override {
+    if (dCount_ >= dLimit_ || !dUpstream_->hasNext()) {
+      return false;
+    }
+    dCount_++;
+    dLast_ = dUpstream_->take();
+    return true;
+  }
+
+  inline std::optional<T> next() override { return current(dLast_); }
+
+  inline std::optional<T> take() override { return std::move(dLast_); }
+
+  inline void reset() override {
+    dUpstream_->reset();
+    dCount_ = 0;
+    dLast_.reset();
+  }
+
+  inline std::optional<size_t> size() override {
+    auto size = dUpstream_->size();
+    return size.has_value() ? std::optional<size_t>{std::min(size.value(), dLimit_)} : std::nullopt;
+  }
+
+ private:
+  std::unique_ptr<Iterator<T>> dUpstream_;
+  size_t dLimit_;
+  size_t dCount_ = 0;
+  std::optional<T> dLast_;
+};
+
+/**
+ * \class SkipIterator
+ * \brief Lazy pipeline stage discarding the first elements of the upstream iterator.
+ * @tparam T element type
+ */
+template<typename T>
+struct SkipIterator : public Iterator<T> {
+  SkipIterator(std::unique_ptr<Iterator<T>> upstream, size_t skip) : dUpstream_(std::move(upstream)), dSkip_(skip) {}
+
+  ~SkipIterator() override = default;
+
+  inline bool hasNext() override {
+    for (; dSkipped_ < dSkip_; dSkipped_++) {
+      if (!dUpstream_->hasNext()) {
+        return false;
+      }
+    }
+    if (!dUpstream_->hasNext()) {
+      return false;
+    }
+    dLast_ = dUpstream_->take();
+    return true;
+  }
+
+  inline std::optional<T> next() override { return current(dLast_); }
+
+  inline std::optional<T> take() override { return std::move(dLast_); }
+
+  inline void reset() override {
+    dUpstream_->reset();
+    dSkipped_ = 0;
+    dLast_.reset();
+  }
+
+  inline std::optional<size_t> size() override {
+    auto size = dUpstream_->size();
+    return size.has_value() ? std::optional<size_t>{size.value() > dSkip_ ? size.value() - dSkip_ : 0} : std::nullopt;
+  }
+
+ private:
+  std::unique_ptr<Iterator<T>> dUpstream_;
+  size_t dSkip_;
+  size_t dSkipped_ = 0;
+  std::optional<T> dLast_;
+};
+
+/**
+ * \class SortedIterator
+ * \brief Pipeline stage yielding the upstream elements in sorted order. The upstream is buffered and sorted on first access only, so the size of a sized upstream is known without sorting.
+ * @tparam T element type
+ * @tparam Comparator type of comparator
+ */
+template<typename T, typename Comparator>
+struct SortedIterator : public Iterator<T> {
+  SortedIterator(std::unique_ptr<Iterator<T>> upstream, Comparator comparator) : dUpstream_(std::move(upstream)), dComparator_(std::move(comparator)) {}
+
+  ~SortedIterator() override = default;
+
+  inline bool hasNext() override {
+    if (!dBuffered_) {
+      while (dUpstream_->hasNext()) {
+        dElements_.emplace_back(dUpstream_->take().value());
+      }
+      std::sort(dElements_.begin(), dElements_.end(), dComparator_);
+      dBuffered_ = true;
+    }
+    return dPosition_++ < dElements_.size();
+  }
+
+  inline std::optional<T> next() override {
+    if constexpr (!std::is_copy_constructible_v<T>) {
+      return take();
+    } else {
+      return dPosition_ > 0 && dPosition_ <= dElements_.size() ? std::optional<T>{dElements_[dPosition_ - 1]} : std::nullopt;
+    }
+  }
+
+  inline std::optional<T> take() override {
+    return dPosition_ > 0 && dPosition_ <= dElements_.size() ? std::optional<T>{std::move(dElements_[dPosition_ - 1])} : std::nullopt;
+  }
+
+  inline void reset() override {
+    dUpstream_->reset();
+    dElements_.clear();
+    dBuffered_ = false;
+    dPosition_ = 0;
+  }
+
+  inline std::optional<size_t> size() override { return dUpstream_->size(); }
+
+ private:
+  std::unique_ptr<Iterator<T>> dUpstream_;
+  Comparator dComparator_;
+  std::vector<T> dElements_;
+  bool dBuffered_ = false;
+  size_t dPosition_ = 0;
+};
+
+/**
+ * \class ReverseIterator
+ * \brief Pipeline stage yielding the upstream elements in reverse order. It is the fallback for upstreams which cannot be traversed backwards, the upstream is buffered on first access only, so the size of a sized upstream is known without buffering.
+ * @tparam T element type
+ */
+template<typename T>
+struct ReverseIterator : public Iterator<T> {
+  explicit ReverseIterator(std::unique_ptr<Iterator<T>> upstream) : dUpstream_(std::move(upstream)) {}
+
+  ~ReverseIterator() override = default;
+
+  inline bool hasNext() override {
+    if (!dBuffered_) {
+      while (dUpstream_->hasNext()) {
+        dElements_.emplace_back(dUpstream_->take().value());
+      }
+      dPosition_ = dElements_.size();
+      dBuffered_ = true;
+    }
+    if (dPosition_ == 0) {
+      return false;
+    }
+    dPosition_--;
+    return true;
+  }
+
+  inline std::optional<T> next() override {
+    if constexpr (!std::is_copy_constructible_v<T>) {
+      return take();
+    } else {
+      return dPosition_ < dElements_.size() ? std::optional<T>{dElements_[dPosition_]} : std::nullopt;
+    }
+  }
+
+  inline std::optional<T> take() override {
+    return dPosition_ < dElements_.size() ? std::optional<T>{std::move(dElements_[dPosition_])} : std::nullopt;
+  }
+
+  inline void reset() override {
+    dUpstream_->reset();
+    dElements_.clear();
+    dBuffered_ = false;
+    dPosition_ = 0;
+  }
+
+  inline std::optional<size_t> size() override { return dUpstream_->size(); }
+
+ private:
+  std::unique_ptr<Iterator<T>> dUpstream_;
+  std::vector<T> dElements_;
+  bool dBuffered_ = false;
+  size_t dPosition_ = 0;
+};
+
+/**
+ * \class BufferIterator
+ * \brief Iterator over a shared, immutable buffer of elements, it keeps the buffer alive while iterating so the owner may drop its reference at any time.
+ * @tparam T element type
+ */
+template<typename T>
+struct BufferIterator : public Iterator<T> {
+  explicit BufferIterator(std::shared_ptr<const std::vector<T>> buffer, bool backwards = false) : dBuffer_(std::move(buffer)), dBackwards_(backwards) {}
+
+  ~BufferIterator() override = default;
+
+  inline bool hasNext() override {
+    if (dPosition_ >= dBuffer_->size()) {
+      return false;
+    }
+    dPosition_++;
+    return true;
+  }
+
+  inline std::optional<T> next() override {
+    if (dPosition_ == 0) {
+      return std::nullopt;
+    }
+    return dBackwards_ ? (*dBuffer_)[dBuffer_->size() - dPosition_] : (*dBuffer_)[dPosition_ - 1];
+  }
+
+  inline void reset() override { dPosition_ = 0; }
+
+  inline std::optional<size_t> size() override { return dBuffer_->size(); }
+
+  inline std::unique_ptr<Iterator<T>> reversed() override { return std::make_unique<BufferIterator<T>>(dBuffer_, !dBackwards_); }
+
+ private:
+  std::shared_ptr<const std::vector<T>> dBuffer_;
+  bool dBackwards_;
+  size_t dPosition_ = 0;
+};
+
+/**
+ * \class WindowIterator
+ * \brief Pipeline stage grouping the upstream elements into windows of a given size, advancing by a given step.
+ *
+ * Windows are views into a single buffer holding at most twice the window size, which is compacted in place instead of being reallocated, so no allocation happens per window. A window is valid until the next call of hasNext().
+ * Only complete windows are emitted unless emitPartial is set, which is meant for tumbling windows (step equal to window size) to emit the trailing incomplete window.
+ * @tparam T element type
+ */
+template<typename T>
+struct WindowIterator : public Iterator<collection::SWindow<T>> {
+  WindowIterator(std::unique_ptr<Iterator<T>> upstream, size_t windowSize, size_t step, bool emitPartial)
+      : dUpstream_(std::move(upstream)), dWindowSize_(std::max<size_t>(windowSize, 1)), dStep_(std::max<size_t>(step, 1)), dEmitPartial_(emitPartial) {
+    dElements_.reserve(2 * dWindowSize_);
+  }
+
+  ~WindowIterator() override = default;
+
+  inline bool hasNext() override {
+    if (dStarted_) {
+      dStart_ += dStep_;
+      if (dStart_ >= dElements_.size()) {
+        for (size_t skip = dStart_ - dElements_.size(); skip > 0 && dUpstream_->hasNext(); skip--) {
+        }
+        dElements_.clear();
+        dStart_ = 0;
+      }
+    }
+    dStarted_ = true;
+    while (dElements_.size() - dStart_ < dWindowSize_) {
+      if (!dUpstream_->hasNext()) {
+        return dEmitPartial_ && dElements_.size() > dStart_;
+      }
+      if (dElements_.size() == dElements_.capacity()) {
+        std::move(dElements_.begin() + dStart_, dElements_.end(), dElements_.begin());
+        dElements_.erase(dElements_.end() - dStart_, dElements_.end());
+        dStart_ = 0;
+      }
+      dElements_.emplace_back(dUpstream_->take().value());
+    }
+    return true;
+  }
+
+  inline std::optional<collection::SWindow<T>> next() override {
+    return collection::SWindow<T>(dElements_.data() + dStart_, std::min(dWindowSize_, dElements_.size() - dStart_));
+  }
+
+  inline void reset() override {
+    dUpstream_->reset();
+    dElements_.clear();
+    dStart_ = 0;
+    dStarted_ = false;
+  }
+
+  inline std::optional<size_t> size() override {
+    auto size = dUpstream_->size();
+    if (!size.has_value()) {
+      return std::nullopt;
+    }
+    if (size.value() < dWindowSize_) {
+      return dEmitPartial_ && size.value() > 0 ? 1 : 0;
+    }
+    auto remaining = size.value() - dWindowSize_;
+    return remaining / dStep_ + 1 + (dEmitPartial_ && remaining % dStep_ != 0 ? 1 : 0);
+  }
+
+ private:
+  std::unique_ptr<Iterator<T>> dUpstream_;
+  size_t dWindowSize_;
+  size_t dStep_;
+  bool dEmitPartial_;
+  std::vector<T> dElements_;
+  size_t dStart_ = 0;
+  bool dStarted_ = false;
+};
+
+/**
+ * \class SortedGroupIterator
+ * \brief Pipeline stage grouping runs of upstream elements with equal keys, yielding the key and the result of a collector for every run as soon as the key changes.
+ *
+ * Only the group being collected and the first element of the next group are held, whatever the number of groups. The upstream is expected to be sorted by key: a key equal to an earlier but not the previous key starts a new run, and a key ordered before the previous key throws std::invalid_argument when validate is set.
+ * @tparam T upstream element type
+ * @tparam K key type
+ * @tparam R result type of the collector
+ * @tparam Classifier type of function mapping elements to keys
+ * @tparam Collector type of collector reducing the elements of a run
+ * @tparam Compare ordering of keys, keys are equal when neither is ordered before the other
+ */
+template<typename T, typename K, typename R, typename Classifier, typename Collector, typename Compare>
+struct SortedGroupIterator : public Iterator<std::pair<K, R>> {
+  using E = std::pair<K, R>;
+
+  SortedGroupIterator(std::unique_ptr<Iterator<T>> upstream, Classifier classifier, Collector collector, Compare cmp, bool validate)
+      : dUpstream_(std::move(upstream)), dClassifier_(std::move(classifier)), dCollector_(std::move(collector)), dCmp_(std::move(cmp)), dValidate_(validate) {}
+
+  ~SortedGroupIterator() override = default;
+
+  inline bool hasNext() override {
+    if (!dPending_) {
+      if (!dUpstream_->hasNext()) {
+        return false;
+      }
+      dPending_ = dUpstream_->take();
+      dPendingKey_.emplace(dClassifier_(std::as_const(*dPending_)));
+    }
+    K key = std::move(*dPendingKey_);
+    auto state = dCollector_.supply();
+    dCollector_.accumulate(state, std::move(*dPending_));
+    dPending_.reset();
+    dPendingKey_.reset();
+    while (dUpstream_->hasNext()) {
+      auto element = dUpstream_->take();
+      K next = dClassifier_(std::as_const(*element));
+      if (dCmp_(next, key) || dCmp_(key, next)) {
+        if (dValidate_ && dCmp_(next, key)) {
+          throw std::invalid_argument("groupingBySorted input is not sorted by key");
+        }
+        dPending_ = std::move(element);
+        dPendingKey_.emplace(std::move(next));
+        break;
+      }
+      dCollector_.accumulate(state, std::move(*element));
+    }
+    dLast_.emplace(std::move(key), dCollector_.finish(state));
+    return true;
+  }
+
+  inline std::optional<E> next() override { return current(dLast_); }
+
+  inline std::optional<E> take() override { return std::move(dLast_); }
+
+  inline void reset() override {
+    dUpstream_->reset();
+    dPending_.reset();
+    dPendingKey_.reset();
+    dLast_.reset();
+  }
+
+ private:
+  std::unique_ptr<Iterator<T>> dUpstream_;
+  Classifier dClassifier_;
+  Collector dCollector_;
+  Compare dCmp_;
+  bool dValidate_;
+  std::optional<T> dPending_;
+  std::optional<K> dPendingKey_;
+  std::optional<E> dLast_;
+};
+}// namespace aalbatross::utils::iterators
+
+#endif//INCLUDED_STREAMS4CPP_PIPELINE_ITERATOR_H_
@@ -0,0 +1,345 @@
+#ifndef INCLUDED_STREAMS4CPP_AGGREGATE_H_
+#define INCLUDED_STREAMS4CPP_AGGREGATE_H_
+#include "aalbatross/utils/collection/streamableflatmap.h"
+
+#include <cstddef>
+#include <functional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace aalbatross::utils::streams {
+/**
+ * \class AggregateTable
+ * \brief Result of Stream::aggregateBy() and Collectors::aggregatingBy(), one row per distinct key in order of first appearance, with one column per aggregate.
+ * @tparam K type of keys
+ * @tparam R types of the results of the aggregates
+ */
+template<typename K, typename... R>
+class AggregateTable {
+ public:
+  AggregateTable(std::vector<K> &&keys, std::tuple<std::vector<R>...> &&columns) : dKeys_(std::move(keys)), dColumns_(std::move(columns)) {}
+
+  size_t size() const { return dKeys_.size(); }
+
+  bool empty() const { return dKeys_.empty(); }
+
+  const std::vector<K> &keys() const { return dKeys_; }
+
+  /**
+   * \fn const auto &column()
+   * \brief Results of the aggregate at position I of aggregateBy(), indexed like keys().
+   * @tparam I position of the aggregate
+   * @return results of the aggregate for every key
+   */
+  template<size_t I>
+  const auto &column() const { return std::get<I>(dColumns_); }
+
+  /**
+   * \fn std::tuple<K, R...> row(size_t index)
+   * \brief Key and results of all aggregates of one group.
+   * @param index position of the group, less than size()
+   * @return key followed by the result of every aggregate
+   */
+  std::tuple<K, R...> row(size_t index) const {
+    return std::apply([this, index](const auto &...columns) { return std::tuple<K, R...>(dKeys_[index], columns[index]...); }, dColumns_);
+  }
+
+ private:
+  std::vector<K> dKeys_;
+  std::tuple<std::vector<R>...> dColumns_;
+};
+
+/**
+ * \class CountAggregate
+ * \brief Aggregate counting the elements of every group, see Aggregates::count().
+ */
+struct CountAggregate {
+  template<typename T>
+  std::vector<size_t> column() const { return {}; }
+
+  template<typename T>
+  void open(std::vector<size_t> &counts, const T & /*element*/) const { counts.push_back(1); }
+
+  template<typename T>
+  void update(std::vector<size_t> &counts, size_t group, const T & /*element*/) const { counts[group]++; }
+
+  void merge(std::vector<size_t> &counts, size_t group, const std::vector<size_t> &other, size_t otherGroup) const { counts[group] += other[otherGroup]; }
+
+  void append(std::vector<size_t> &counts, const std::vector<size_t> &other, size_t otherGroup) const { counts.push_back(other[otherGroup]); }
+
+  std::vector<size_t> finish(std::vector<size_t> &counts) const { return std::move(counts); }
+};
+
+/**
+ * \class SumAggregate
+ * \brief Aggregate summing a property of the elements of every group, see Aggregates::sum().
+ * @tparam Mapper type of function extracting the summed property
+ */
+template<typename Mapper>
+struct SumAggregate {
+  Mapper mapper;
+
+  template<typename T>
+  using Value = std::decay_t<std::invoke_result_t<const Mapper &, const T &>>;
+
+  template<typename T>
+  std::vector<Value<T>> column() const { return {}; }
+
+  template<typename V, typename T>
+  void open(std::vector<V> &sums, const T &element) const {
+    V sum{};
+    sum += mapper(element);
+    sums.push_back(std::move(sum));
+  }
+
+  template<typename V, typename T>
+  void update(std::vector<V> &sums, size_t group, const T &element) const { sums[group] += mapper(element); }
+
+  template<typename V>
+  void merge(std::vector<V> &sums, size_t group, const std::vector<V> &other, size_t otherGroup) const { sums[group] += other[otherGroup]; }
+
+  template<typename V>
+  void append(std::vector<V> &sums, const std::vector<V> &other, size_t otherGroup) const { sums.push_back(other[otherGroup]); }
+
+  template<typename V>
+  std::vector<V> finish(std::vector<V> &sums) const { return std::move(sums); }
+};
+
+/**
+ * \class ExtremeAggregate
+ * \brief Aggregate keeping the least property of the elements of every group according to Compare, see Aggregates::min() and Aggregates::max().
+ * @tparam Mapper type of function extracting the compared property
+ * @tparam Compare std::less for the minimum, std::greater for the maximum
+ */
+template<typename Mapper, typename Compare>
+struct ExtremeAggregate {
+  Mapper mapper;
+  Compare compare;
+
+  template<typename T>
+  using Value = std::decay_t<std::invoke_result_t<const Mapper &, const T &>>;
+
+  template<typename T>
+  std::vector<Value<T>> column() const { return {}; }
+
+  template<typename V, typename T>
+  void open(std::vector<V> &extremes, const T &element) const { extremes.push_back(mapper(element)); }
+
+  template<typename V, typename T>
+  void update(std::vector<V> &extremes, size_t group, const T &element) const {
+    auto value = mapper(element);
+    if (compare(value, extremes[group])) {
+      extremes[group] = std::move(value);
+    }
+  }
+
+  template<typename V>
+  void merge(std::vector<V> &extremes, size_t group, const std::vector<V> &other, size_t otherGroup) const {
+    if (compare(other[otherGroup], extremes[group])) {
+      extremes[group] = other[otherGroup];
+    }
+  }
+
+  template<typename V>
+  void append(std::vector<V> &extremes, const std::vector<V> &other, size_t otherGroup) const { extremes.push_back(other[otherGroup]); }
+
+  template<typename V>
+  std::vector<V> finish(std::vector<V> &extremes) const { return std::move(extremes); }
+};
+
+/**
+ * \class AverageAggregate
+ * \brief Aggregate averaging a double-valued property of the elements of every group, see Aggregates::average().
+ * @tparam Mapper type of function extracting the averaged property
+ */
+template<typename Mapper>
+struct AverageAggregate {
+  Mapper mapper;
+
+  struct Column {
+    std::vector<double> sums;
+    std::vector<size_t> counts;
+  };
+
+  template<typename T>
+  Column column() const { return {}; }
+
+  template<typename T>
+  void open(Column &column, const T &element) const {
+    column.sums.push_back(mapper(element));
+    column.counts.push_back(1);
+  }
+
+  template<typename T>
+  void update(Column &column, size_t group, const T &element) const {
+    column.sums[group] += mapper(element);
+    column.counts[group]++;
+  }
+
+  void merge(Column &column, size_t group, const Column &other, size_t otherGroup) const {
+    column.sums[group] += other.sums[otherGroup];
+    column.counts[group] += other.counts[otherGroup];
+  }
+
+  void append(Column &column, const Column &other, size_t otherGroup) const {
+    column.sums.push_back(other.sums[otherGroup]);
+    column.counts.push_back(other.counts[otherGroup]);
+  }
+
+  std::vector<double> finish(Column &column) const {
+    std::vector<double> averages(column.sums.size());
+    for (size_t i = 0; i < averages.size(); i++) {
+      averages[i] = column.sums[i] / static_cast<double>(column.counts[i]);
+    }
+    return averages;
+  }
+};
+
+/**
+ * \class Aggregates
+ * \brief Aggregates computed per group by Stream::aggregateBy() and Collectors::aggregatingBy().
+ *
+ * Every aggregate keeps its state of all groups in contiguous columns indexed by group id, and updates the column of the group of every element as it arrives, so elements are never stored.
+ */
+struct Aggregates final {
+  /**
+   * \fn CountAggregate count()
+   * \brief Counts the elements of every group.
+   * @return aggregate producing a size_t per group
+   */
+  static CountAggregate count() { return {}; }
+
+  /**
+   * \fn auto sum(Mapper &&mapper)
+   * \brief Sums a property of the elements of every group, starting from the value initialized property.
+   * @tparam Mapper type of function extracting the summed property
+   * @param mapper
+   * @return aggregate producing the sum of the property per group
+   */
+  template<typename Mapper>
+  static auto sum(Mapper &&mapper) { return SumAggregate<std::decay_t<Mapper>>{std::forward<Mapper>(mapper)}; }
+
+  /**
+   * \fn auto min(Mapper &&mapper)
+   * \brief Least property of the elements of every group.
+   * @tparam Mapper type of function extracting the compared property
+   * @param mapper
+   * @return aggregate producing the minimum of the property per group
+   */
+  template<typename Mapper>
+  static auto min(Mapper &&mapper) { return ExtremeAggregate<std::decay_t<Mapper>, std::less<>>{std::forward<Mapper>(mapper), std::less<>()}; }
+
+  /**
+   * \fn auto max(Mapper &&mapper)
+   * \brief Greatest property of the elements of every group.
+   * @tparam Mapper type of function extracting the compared property
+   * @param mapper
+   * @return aggregate producing the maximum of the property per group
+   */
+  template<typename Mapper>
+  static auto max(Mapper &&mapper) { return ExtremeAggregate<std::decay_t<Mapper>, std::greater<>>{std::forward<Mapper>(mapper), std::greater<>()}; }
+
+  /**
+   * \fn auto average(Mapper &&mapper)
+   * \brief Arithmetic mean of a double-valued property of the elements of every group.
+   * @tparam Mapper type of function extracting the averaged property
+   * @param mapper
+   * @return aggregate producing the mean of the property per group
+   */
+  template<typename Mapper>
+  static auto average(Mapper &&mapper) { return AverageAggregate<std::decay_t<Mapper>>{std::forward<Mapper>(mapper)}; }
+};
+
+/**
+ * \class AggregationState
+ * \brief State of Stream::aggregateBy() and Collectors::aggregatingBy().
+ *
+ * Keys are mapped to dense group ids by a collection::SFlatMap, with one lookup per element, then every aggregate updates its column at the group id of the element directly, without copying the element.
+ * The first element of a group opens the columns of the group and later elements update them, so every mapper is called once per element.
+ * @tparam T type of input elements
+ * @tparam KeyMapper type of function extracting the key of the group
+ * @tparam Aggregate types of the aggregates
+ */
+template<typename T, typename KeyMapper, typename... Aggregate>
+class AggregationState {
+ public:
+  template<typename A>
+  using Column = decltype(std::declval<const A &>().template column<T>());
+  template<typename A>
+  using Result = typename decltype(std::declval<const A &>().finish(std::declval<Column<A> &>()))::value_type;
+
+  using Key = std::decay_t<std::invoke_result_t<const KeyMapper &, const T &>>;
+  using Table = AggregateTable<Key, Result<Aggregate>...>;
+
+  AggregationState(const KeyMapper &keyMapper, const std::tuple<Aggregate...> &aggregates)
+      : dKeyMapper_(keyMapper), dAggregates_(aggregates), dColumns_(std::apply([](const auto &...aggregate) { return std::make_tuple(aggregate.template column<T>()...); }, aggregates)) {}
+
+  void add(const T &element) {
+    auto [position, inserted] = dGroupIds_.try_emplace(dKeyMapper_(element), dKeys_.size());
+    if (inserted) {
+      dKeys_.push_back(position->first);
+      forEachAggregate([&element](const auto &aggregate, auto &column) { aggregate.open(column, element); });
+      return;
+    }
+    size_t group = position->second;
+    forEachAggregate([group, &element](const auto &aggregate, auto &column) { aggregate.update(column, group, element); });
+  }
+
+  void merge(AggregationState &other) {
+    for (size_t otherGroup = 0; otherGroup < other.dKeys_.size(); otherGroup++) {
+      auto [position, inserted] = dGroupIds_.try_emplace(other.dKeys_[otherGroup], dKeys_.size());
+      if (inserted) {
+        dKeys_.push_back(position->first);
+      }
+      size_t group = position->second;
+      forEachAggregate(other, [inserted, group, otherGroup](const auto &aggregate, auto &column, const auto &otherColumn) {
+        if (inserted) {
+          aggregate.append(column, otherColumn, otherGroup);
+        } else {
+          aggregate.merge(column, group, otherColumn, otherGroup);
+        }
+      });
+    }
+  }
+
+  Table finish() {
+    auto columns = std::apply([this](auto &...column) { return finishColumns(std::index_sequence_for<Aggregate...>(), column...); }, dColumns_);
+    return Table(std::move(dKeys_), std::move(columns));
+  }
+
+ private:
+  KeyMapper dKeyMapper_;
+  std::tuple<Aggregate...> dAggregates_;
+  std::tuple<Column<Aggregate>...> dColumns_;
+  collection::SFlatMap<Key, size_t> dGroupIds_;
+  std::vector<Key> dKeys_;
+
+  template<typename Function>
+  void forEachAggregate(Function &&function) {
+    forEachAggregate(std::forward<Function>(function), std::index_sequence_for<Aggregate...>());
+  }
+
+  template<typename Function, size_t... I>
+  void forEachAggregate(Function &&function, std::index_sequence<I...> /*indices*/) {
+    (function(std::get<I>(dAggregates_), std::get<I>(dColumns_)), ...);
+  }
+
+  template<typename Function>
+  void forEachAggregate(AggregationState &other, Function &&function) {
+    forEachAggregate(other, std::forward<Function>(function), std::index_sequence_for<Aggregate...>());
+  }
+
+  template<typename Function, size_t... I>
+  void forEachAggregate(AggregationState &other, Function &&function, std::index_sequence<I...> /*indices*/) {
+    (function(std::get<I>(dAggregates_), std::get<I>(dColumns_), std::get<I>(other.dColumns_)), ...);
+  }
+
+  template<size_t... I, typename... Column>
+  auto finishColumns(std::index_sequence<I...> /*indices*/, Column &...column) {
+    return std::make_tuple(std::get<I>(dAggregates_).finish(column)...);
+  }
+};
+}// namespace aalbatross::utils::streams
+#endif
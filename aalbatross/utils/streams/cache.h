@@ -0,0 +1,90 @@
+#ifndef INCLUDED_STREAMS4CPP_CACHE_H_
+#define INCLUDED_STREAMS4CPP_CACHE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace aalbatross::utils::streams {
+/**
+ * \class CacheControl
+ * \brief Type independent handle of a stream cache, used to drop the cache and to account the memory it holds.
+ */
+struct CacheControl {
+  CacheControl() = default;
+  CacheControl(const CacheControl &) = delete;
+  CacheControl &operator=(const CacheControl &) = delete;
+  virtual ~CacheControl() = default;
+
+  /**
+   * \fn void invalidate()
+   * \brief Releases the cached elements, the next terminal operation recomputes them.
+   */
+  virtual void invalidate() = 0;
+
+  /**
+   * \fn size_t bytes()
+   * \brief Bytes held by the cached buffer (capacity times element size, memory owned by the elements themselves is not included).
+   * @return bytes held, 0 if nothing is cached
+   */
+  virtual size_t bytes() const = 0;
+
+  /**
+   * \fn std::atomic<size_t> &totalBytes()
+   * \brief Bytes held by all the stream caches of the process, to decide when caches should be invalidated under memory pressure.
+   * @return byte counter
+   */
+  static std::atomic<size_t> &totalBytes() {
+    static std::atomic<size_t> bytes{0};
+    return bytes;
+  }
+};
+
+/**
+ * \class StreamCache
+ * \brief Buffer memoizing the output of a stream pipeline, materialized by the first terminal operation and shared by the next ones.
+ * @tparam T element type
+ */
+template<typename T>
+struct StreamCache final : public CacheControl {
+  StreamCache() = default;
+
+  ~StreamCache() override { invalidate(); }
+
+  /**
+   * \fn std::shared_ptr<const std::vector<T>> load(Materializer &&materializer)
+   * \brief Returns the cached elements, materializing them on first use.
+   * @tparam Materializer type of function returning the elements as std::vector<T>
+   * @param materializer function computing the elements when nothing is cached
+   * @return buffer of elements, it stays valid even if the cache is invalidated meanwhile
+   */
+  template<typename Materializer>
+  std::shared_ptr<const std::vector<T>> load(Materializer &&materializer) {
+    if (!dBuffer_) {
+      auto elements = materializer();
+      elements.shrink_to_fit();
+      dBuffer_ = std::make_shared<const std::vector<T>>(std::move(elements));
+      dBytes_ = dBuffer_->capacity() * sizeof(T);
+      totalBytes().fetch_add(dBytes_, std::memory_order_relaxed);
+    }
+    return dBuffer_;
+  }
+
+  void invalidate() override {
+    if (dBuffer_) {
+      totalBytes().fetch_sub(dBytes_, std::memory_order_relaxed);
+      dBuffer_.reset();
+      dBytes_ = 0;
+    }
+  }
+
+  size_t bytes() const override { return dBytes_; }
+
+ private:
+  std::shared_ptr<const std::vector<T>> dBuffer_;
+  size_t dBytes_ = 0;
+};
+}// namespace aalbatross::utils::streams
+
+#endif//INCLUDED_STREAMS4CPP_CACHE_H_
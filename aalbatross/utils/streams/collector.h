@@ -1,35 +1,342 @@
 #ifndef INCLUDED_STREAMS4CPP_COLLECTOR_H_
 #define INCLUDED_STREAMS4CPP_COLLECTOR_H_
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
 #include <functional>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define STREAMS4CPP_COLLECTOR_SSE2
+#endif
 
 namespace aalbatross::utils::streams {
+/**
+ * \class CountingAccumulator
+ * \brief Accumulator of Collectors::counting(), it is a named type so that streams can recognise a counting reduction and answer it from the size of the stream.
+ */
+struct CountingAccumulator {
+  template<typename E>
+  void operator()(size_t &count, const E & /*element*/) const {
+    count++;
+  }
+};
+
+/**
+ * \class AveragingState
+ * \brief Fixed size state of Collectors::averaging(), the running sum and count of the input elements.
+ */
+struct AveragingState {
+  double sum = 0;
+  size_t count = 0;
+
+  void merge(const AveragingState &other) {
+    sum += other.sum;
+    count += other.count;
+  }
+
+  double average() const { return sum / count; }
+};
+
+/**
+ * \class KahanSum
+ * \brief Fixed size state of Collectors::summingDouble(), a compensated (Kahan-Babuska) sum which carries the low order bits lost by every addition.
+ */
+struct KahanSum {
+  double sum = 0;
+  double compensation = 0;
+
+  void add(double value) {
+    double total = sum + value;
+    compensation += std::abs(sum) >= std::abs(value) ? (sum - total) + value : (value - total) + sum;
+    sum = total;
+  }
+
+  void merge(const KahanSum &other) {
+    add(other.sum);
+    compensation += other.compensation;
+  }
+
+  double value() const { return sum + compensation; }
+};
+
+/**
+ * \class SummaryStatistics
+ * \brief Result of Collectors::summarizing(), count, sum, min, max, mean and variance of values computed in one pass.
+ *
+ * The mean and the sum of squared deviations are updated with Welford's method, blocks of values and partial results are merged with the parallel form of Welford's method (Chan et al.), which stays accurate when values are large compared to their spread. min() and max() are +inf and -inf, and mean() and variance() are 0, when no value was added.
+ */
+struct SummaryStatistics {
+  void add(double value) {
+    dCount_++;
+    dSum_ += value;
+    dMin_ = std::min(dMin_, value);
+    dMax_ = std::max(dMax_, value);
+    double delta = value - dMean_;
+    dMean_ += delta / static_cast<double>(dCount_);
+    dSquaredDeviations_ += delta * (value - dMean_);
+  }
+
+  /**
+   * \fn void addBlock(const double *values, size_t count)
+   * \brief Adds a contiguous block of values, min, max and sums of the block are computed with SSE2 when available.
+   * @param values
+   * @param count number of values
+   */
+  void addBlock(const double *values, size_t count) {
+    if (count == 0) {
+      return;
+    }
+    SummaryStatistics block;
+    block.dCount_ = count;
+    blockSumMinMax(values, count, block.dSum_, block.dMin_, block.dMax_);
+    block.dMean_ = block.dSum_ / static_cast<double>(count);
+    block.dSquaredDeviations_ = blockSquaredDeviations(values, count, block.dMean_);
+    merge(block);
+  }
+
+  void merge(const SummaryStatistics &other) {
+    if (other.dCount_ == 0) {
+      return;
+    }
+    if (dCount_ == 0) {
+      *this = other;
+      return;
+    }
+    auto count = static_cast<double>(dCount_);
+    auto otherCount = static_cast<double>(other.dCount_);
+    double delta = other.dMean_ - dMean_;
+    dMean_ += delta * otherCount / (count + otherCount);
+    dSquaredDeviations_ += other.dSquaredDeviations_ + delta * delta * count * otherCount / (count + otherCount);
+    dCount_ += other.dCount_;
+    dSum_ += other.dSum_;
+    dMin_ = std::min(dMin_, other.dMin_);
+    dMax_ = std::max(dMax_, other.dMax_);
+  }
+
+  size_t count() const { return dCount_; }
+
+  double sum() const { return dSum_; }
+
+  double min() const { return dMin_; }
+
+  double max() const { return dMax_; }
+
+  double mean() const { return dMean_; }
+
+  /**
+   * \fn double variance()
+   * \brief Population variance of the values.
+   * @return sum of squared deviations divided by count
+   */
+  double variance() const { return dCount_ == 0 ? 0 : dSquaredDeviations_ / static_cast<double>(dCount_); }
+
+  /**
+   * \fn double sampleVariance()
+   * \brief Unbiased sample variance of the values.
+   * @return sum of squared deviations divided by count - 1
+   */
+  double sampleVariance() const { return dCount_ < 2 ? 0 : dSquaredDeviations_ / static_cast<double>(dCount_ - 1); }
+
+  double standardDeviation() const { return std::sqrt(variance()); }
+
+ private:
+  size_t dCount_ = 0;
+  double dSum_ = 0;
+  double dMin_ = std::numeric_limits<double>::infinity();
+  double dMax_ = -std::numeric_limits<double>::infinity();
+  double dMean_ = 0;
+  double dSquaredDeviations_ = 0;
+
+  static void blockSumMinMax(const double *values, size_t count, double &sum, double &min, double &max) {
+    size_t i = 0;
+#ifdef STREAMS4CPP_COLLECTOR_SSE2
+    if (count >= 2) {
+      __m128d sums = _mm_setzero_pd();
+      __m128d mins = _mm_loadu_pd(values);
+      __m128d maxs = mins;
+      for (; i + 2 <= count; i += 2) {
+        __m128d pair = _mm_loadu_pd(values + i);
+        sums = _mm_add_pd(sums, pair);
+        mins = _mm_min_pd(mins, pair);
+        maxs = _mm_max_pd(maxs, pair);
+      }
+      double lanes[2];
+      _mm_storeu_pd(lanes, sums);
+      sum += lanes[0] + lanes[1];
+      _mm_storeu_pd(lanes, mins);
+      min = std::min({min, lanes[0], lanes[1]});
+      _mm_storeu_pd(lanes, maxs);
+      max = std::max({max, lanes[0], lanes[1]});
+    }
+#endif
+    for (; i < count; i++) {
+      sum += values[i];
+      min = std::min(min, values[i]);
+      max = std::max(max, values[i]);
+    }
+  }
+
+  static double blockSquaredDeviations(const double *values, size_t count, double mean) {
+    double squaredDeviations = 0;
+    size_t i = 0;
+#ifdef STREAMS4CPP_COLLECTOR_SSE2
+    __m128d means = _mm_set1_pd(mean);
+    __m128d sums = _mm_setzero_pd();
+    for (; i + 2 <= count; i += 2) {
+      __m128d deviations = _mm_sub_pd(_mm_loadu_pd(values + i), means);
+      sums = _mm_add_pd(sums, _mm_mul_pd(deviations, deviations));
+    }
+    double lanes[2];
+    _mm_storeu_pd(lanes, sums);
+    squaredDeviations = lanes[0] + lanes[1];
+#endif
+    for (; i < count; i++) {
+      squaredDeviations += (values[i] - mean) * (values[i] - mean);
+    }
+    return squaredDeviations;
+  }
+};
+
+/**
+ * \class SummarizingState
+ * \brief State of Collectors::summarizing(), values are buffered in a small fixed block which is added to the statistics with SummaryStatistics::addBlock when full.
+ */
+struct SummarizingState {
+  static constexpr size_t BLOCK = 64;
+
+  void add(double value) {
+    block[buffered++] = value;
+    if (buffered == BLOCK) {
+      flush();
+    }
+  }
+
+  void flush() {
+    statistics.addBlock(block, buffered);
+    buffered = 0;
+  }
+
+  SummaryStatistics statistics;
+  double block[BLOCK];
+  size_t buffered = 0;
+};
+
+/**
+ * \class JoiningState
+ * \brief State of Collectors::joining(), a rope of characters appended in chunks of growing capacity, together with the total length and the number of joined elements.
+ *
+ * Chunks are never reallocated once written, partial states are combined by moving chunks, and the joined string is written once into a buffer sized from the total length.
+ */
+struct JoiningState {
+  static constexpr size_t MIN_CHUNK = 64;
+  static constexpr size_t MAX_CHUNK = 1 << 16;
+
+  void add(std::string_view delimiter, std::string_view element) {
+    if (elements++ > 0) {
+      append(delimiter);
+    }
+    append(element);
+  }
+
+  void append(std::string_view characters) {
+    if (characters.empty()) {
+      return;
+    }
+    if (chunks.empty() || chunks.back().capacity() - chunks.back().size() < characters.size()) {
+      chunks.emplace_back().reserve(std::max(characters.size(), std::clamp(length, MIN_CHUNK, MAX_CHUNK)));
+    }
+    chunks.back().append(characters);
+    length += characters.size();
+  }
+
+  void merge(std::string_view delimiter, JoiningState &other) {
+    if (other.elements == 0) {
+      return;
+    }
+    if (elements > 0) {
+      append(delimiter);
+    }
+    chunks.insert(chunks.end(), std::make_move_iterator(other.chunks.begin()), std::make_move_iterator(other.chunks.end()));
+    length += other.length;
+    elements += other.elements;
+  }
+
+  std::string join(std::string_view prefix, std::string_view suffix) const {
+    std::string result;
+    result.reserve(prefix.size() + length + suffix.size());
+    result.append(prefix);
+    for (const auto &chunk : chunks) {
+      result.append(chunk);
+    }
+    result.append(suffix);
+    return result;
+  }
+
+  std::vector<std::string> chunks;
+  size_t length = 0;
+  size_t elements = 0;
+};
+
+/**
+ * \enum Characteristics
+ * \brief Properties of a Collector which let streams optimize the reduction, combined as bit flags.
+ */
+enum Characteristics : unsigned {
+  /// accumulator may be called concurrently on the same result container from multiple threads
+  CONCURRENT = 1U << 0U,
+  /// result does not depend on the encounter order of the input elements
+  UNORDERED = 1U << 1U,
+  /// finisher is the identity function and may be skipped
+  IDENTITY_FINISH = 1U << 2U
+};
+
+/**
+ * \class NoCombiner
+ * \brief Combiner of collectors which cannot merge partial result containers.
+ */
+struct NoCombiner {};
+
 /**
  * \class Collector
  * \brief A mutable reduction operation that accumulates input elements into a mutable result container, optionally transforming the accumulated result into a final representation after all input elements have been processed.
- * A Collector is specified by three functions that work together to accumulate entries into a mutable result container, and optionally perform a final transform on the result. They are:
+ * A Collector is specified by four functions that work together to accumulate entries into a mutable result container, and optionally perform a final transform on the result. They are:
  *
  * creation of a new result container (supplier())
  * incorporating a new data element into a result container (accumulator())
+ * merging a partial result container into another one (combiner()), so that input shards or threads can be collected separately
  * performing an optional final transform on the container (finisher())
  *
  *
  * @tparam Supplier Function for creation of a new result container
  * @tparam Accumulator Function for accumulating a new data element into a result container
  * @tparam Finisher Function performing an optional final transform on the container
+ * @tparam Combiner Function merging its second result container into the first one, NoCombiner if partial results cannot be merged
  */
-template<typename Supplier, typename Accumulator, typename Finisher>
+template<typename Supplier, typename Accumulator, typename Finisher, typename Combiner = NoCombiner>
 class Collector {
  private:
   Supplier dSupplier_;
   Accumulator dAccumulator_;
   Finisher dFinisher_;
+  Combiner dCombiner_;
+  unsigned dCharacteristics_;
 
  public:
   ~Collector() = default;
 
-  explicit Collector(Supplier &&supplier, Accumulator &&accumulator, Finisher &&finisher) : dSupplier_(supplier), dAccumulator_(accumulator), dFinisher_(finisher) {}
+  explicit Collector(Supplier &&supplier, Accumulator &&accumulator, Finisher &&finisher) : dSupplier_(supplier), dAccumulator_(accumulator), dFinisher_(finisher), dCombiner_(), dCharacteristics_(0) {}
+
+  explicit Collector(Supplier &&supplier, Accumulator &&accumulator, Finisher &&finisher, Combiner &&combiner, unsigned characteristics = 0) : dSupplier_(supplier), dAccumulator_(accumulator), dFinisher_(finisher), dCombiner_(combiner), dCharacteristics_(characteristics) {}
 
   Collector(Collector &) = default;
+  Collector(const Collector &) = default;
   Collector(Collector &&) noexcept = default;
 
   Collector &operator=(const Collector &) = default;
@@ -38,15 +345,97 @@ class Collector {
   Supplier supplier() const { return dSupplier_; }
   Finisher finisher() const { return dFinisher_; };
   Accumulator accumulator() const { return dAccumulator_; };
+  Combiner combiner() const { return dCombiner_; };
+
+  /**
+   * \fn unsigned characteristics()
+   * \brief Characteristics of this collector as a combination of Characteristics flags.
+   * @return characteristics flags
+   */
+  unsigned characteristics() const { return dCharacteristics_; }
+
+  /**
+   * \fn bool hasCharacteristics(unsigned characteristics)
+   * \brief Whether this collector has all the provided characteristics.
+   * @param characteristics combination of Characteristics flags
+   * @return true if every flag is set
+   */
+  bool hasCharacteristics(unsigned characteristics) const { return (dCharacteristics_ & characteristics) == characteristics; }
+
+  /**
+   * \fn bool combinable()
+   * \brief Whether partial result containers of this collector can be merged with combine().
+   * @return true if the collector has a combiner
+   */
+  static constexpr bool combinable() { return !std::is_same_v<Combiner, NoCombiner>; }
+
+  /**
+   * \fn auto supply()
+   * \brief Creates a new result container, the first step of a streaming reduction.
+   * @return empty result container
+   */
+  auto supply() const { return dSupplier_(); }
+
+  /**
+   * \fn void accumulate(Container &container, E &&element)
+   * \brief Incorporates one element into the result container, it is called for every element as it flows out of the stream pipeline so the input is never stored as a whole.
+   * @tparam Container type of result container
+   * @tparam E type of input element
+   * @param container result container created by supply()
+   * @param element input element
+   */
+  template<typename Container, typename E>
+  void accumulate(Container &container, E &&element) const {
+    dAccumulator_(container, std::forward<E>(element));
+  }
+
+  /**
+   * \fn void combine(Container &container, Container &other)
+   * \brief Merges the partial result container other into container, in time proportional to the size of the partial results rather than of the input. other is left in a valid but unspecified state.
+   * @tparam Container type of result container
+   * @param container result container receiving the partial result, it holds the elements preceding other in encounter order
+   * @param other partial result container
+   */
+  template<typename Container>
+  void combine(Container &container, Container &other) const {
+    static_assert(combinable(), "collector does not provide a combiner");
+    dCombiner_(container, other);
+  }
+
+  /**
+   * \fn auto finish(Container &container)
+   * \brief Performs the final transform of the result container, the last step of a streaming reduction.
+   * @tparam Container type of result container
+   * @param container result container holding every accumulated element
+   * @return result of the collector
+   */
+  template<typename Container>
+  auto finish(Container &container) const { return dFinisher_(container); }
 
   template<typename T>
   auto apply(std::vector<T> &input) const {
-    auto container = std::move(dSupplier_());
+    auto container = supply();
+    for (T &item : input) {
+      accumulate(container, item);
+    }
+    return finish(container);
+  }
+
+  /**
+   * \fn auto apply(std::vector<T> &&input)
+   * \brief Collects the elements of a vector which is not used afterwards, the elements are moved into the result container by the accumulators which store them.
+   * @tparam T type of input element
+   * @param input elements to collect
+   * @return result of the collector
+   */
+  template<typename T>
+  auto apply(std::vector<T> &&input) const {
+    auto container = supply();
     for (T &item : input) {
-      dAccumulator_(container, item);
+      accumulate(container, std::move(item));
     }
-    return dFinisher_(container);
+    return finish(container);
   }
 };
 }// namespace aalbatross::utils::streams
-#endif
\ No newline at end of file
+#endif
@@ -1,15 +1,25 @@
 #ifndef INCLUDED_STREAMS4CPP_COLLECTORS_H_
 #define INCLUDED_STREAMS4CPP_COLLECTORS_H_
+#include "aalbatross/utils/collection/streamableflatmap.h"
+#include "aggregate.h"
 #include "collector.h"
+#include "sketch.h"
+#include "strategy.h"
 
 #include <algorithm>
+#include <cmath>
+#include <iterator>
 #include <map>
+#include <memory>
 #include <numeric>
+#include <optional>
 #include <set>
-#include <sstream>
+#include <stdexcept>
+#include <tuple>
 #include <type_traits>
 #include <unordered_map>
 #include <unordered_set>
+#include <utility>
 #include <vector>
 namespace aalbatross::utils::streams {
 /**
@@ -63,17 +73,18 @@ struct Collectors final {
   */
   template<typename TypeToDouble>
   static auto averaging(TypeToDouble &&mapper) {
-    return streams::Collector{[] { return std::vector<double>(); },
-                              [mapper](std::vector<double> &intermediate, const auto &element) {
-                                intermediate.emplace_back(mapper(element));
-                              },
-                              [](std::vector<double> &intermediate) -> double {
-                                double sum = 0;
-                                for (const double &item : intermediate) {
-                                  sum += item;
-                                }
-                                return (sum / intermediate.size());
-                              }};
+    return streams::Collector{[] { return AveragingState(); },
+                              [mapper](AveragingState &state, const auto &element) {
+                                state.sum += mapper(element);
+                                state.count++;
+                              },
+                              [](AveragingState &state) -> double {
+                                return state.average();
+                              },
+                              [](AveragingState &state, AveragingState &other) {
+                                state.merge(other);
+                              },
+                              UNORDERED};
   }
 
   /**
@@ -87,17 +98,19 @@ struct Collectors final {
 
   /**
    * \fn auto counting()
-   * \brief Returns a Collector accepting elements of type T that counts the number of input elements.
+   * \brief Returns a Collector accepting elements of type T that counts the number of input elements. Streams answer this collector through Stream::count(), so sized pipelines are counted without visiting their elements.
    * @return a Collector that counts the input elements
    */
   static auto counting() {
-    return streams::Collector{[] { return std::vector<int>(); },
-                              [](std::vector<int> &intermediate, const auto &element) {
-                                intermediate.emplace_back(0);
+    return streams::Collector{[] { return size_t{0}; },
+                              CountingAccumulator{},
+                              [](size_t &count) -> size_t {
+                                return count;
                               },
-                              [](std::vector<int> &intermediate) -> size_t {
-                                return intermediate.size();
-                              }};
+                              [](size_t &count, size_t &other) {
+                                count += other;
+                              },
+                              UNORDERED | IDENTITY_FINISH};
   }
 
   /**
@@ -109,59 +122,457 @@ struct Collectors final {
    */
   template<typename TypeToLong>
   static auto summingLong(TypeToLong &&mapper) {
-    return streams::Collector{[] { return std::vector<long>(); },
-                              [mapper](std::vector<long> &intermediate, const auto &element) {
-                                intermediate.emplace_back(mapper(element));
-                              },
-                              [](std::vector<long> &intermediate) -> long {
-                                long sum = 0;
-                                for (const long &item : intermediate) {
-                                  sum += item;
-                                }
+    return streams::Collector{[] { return long{0}; },
+                              [mapper](long &sum, const auto &element) {
+                                sum += mapper(element);
+                              },
+                              [](long &sum) -> long {
                                 return sum;
-                              }};
+                              },
+                              [](long &sum, long &other) {
+                                sum += other;
+                              },
+                              UNORDERED | IDENTITY_FINISH};
   }
 
   /**
    * \fn auto summingDouble(TypeToDouble &&mapper)
-   * \brief Returns a Collector that produces the sum of a double-valued function applied to the input elements.
+   * \brief Returns a Collector that produces the sum of a double-valued function applied to the input elements. The sum is compensated, so the rounding error does not grow with the number of elements.
    * @tparam TypeToDouble Type of function extracting the property to be summed
    * @param mapper
    * @return a Collector that produces the sum of a derived property
    */
   template<typename TypeToDouble>
   static auto summingDouble(TypeToDouble &&mapper) {
-    return streams::Collector{[] { return std::vector<double>(); },
-                              [mapper](std::vector<double> &intermediate, const auto &element) {
-                                intermediate.emplace_back(mapper(element));
-                              },
-                              [](std::vector<double> &intermediate) -> double {
-                                double sum = 0;
-                                for (const double &item : intermediate) {
-                                  sum += item;
-                                }
-                                return sum;
+    return streams::Collector{[] { return KahanSum(); },
+                              [mapper](KahanSum &state, const auto &element) {
+                                state.add(mapper(element));
+                              },
+                              [](KahanSum &state) -> double {
+                                return state.value();
+                              },
+                              [](KahanSum &state, KahanSum &other) {
+                                state.merge(other);
+                              },
+                              UNORDERED};
+  }
+
+  /**
+   * \fn auto joining(std::string delimiter = " ", std::string prefix = "", std::string suffix = "")
+   * Returns a Collector that concatenates the input elements, separated by the specified delimiter, with the specified prefix and suffix, in encounter order.
+   *
+   * Elements may be of any type convertible to std::string_view (std::string, std::string_view, const char *...), their characters are appended to a JoiningState and the result is written once into a buffer of the final length.
+   * @param delimiter the delimiter to be used between each element
+   * @param prefix the sequence of characters to be used at the beginning of the joined result
+   * @param suffix the sequence of characters to be used at the end of the joined result
+   * @return A Collector which concatenates CharSequence elements, separated by the specified delimiter, in encounter order
+   */
+  static auto joining(std::string delimiter = " ", std::string prefix = "", std::string suffix = "") {
+    return streams::Collector{[] { return JoiningState(); },
+                              [delimiter](JoiningState &state, const auto &element) {
+                                state.add(delimiter, std::string_view(element));
+                              },
+                              [prefix, suffix](JoiningState &state) -> std::string {
+                                return state.join(prefix, suffix);
+                              },
+                              [delimiter](JoiningState &state, JoiningState &other) {
+                                state.merge(delimiter, other);
                               }};
   }
 
   /**
-   * \fn auto collectingAndThen(Collector<Supplier, Accumulator, Finisher> &&collector, Mapper &&mapper)
+   * \fn auto joiningChunked(std::string delimiter = " ")
+   * \brief Returns a Collector that concatenates the input elements, separated by the specified delimiter, in encounter order, into a JoiningState instead of a single string.
+   *
+   * Use it when the joined result is too large to be held in one buffer, its chunks can be written out one after the other. Combining partial results moves chunks and does not copy characters.
+   * @param delimiter the delimiter to be used between each element
+   * @return A Collector which concatenates elements into the chunks of a JoiningState
+   */
+  static auto joiningChunked(std::string delimiter = " ") {
+    return streams::Collector{[] { return JoiningState(); },
+                              [delimiter](JoiningState &state, const auto &element) {
+                                state.add(delimiter, std::string_view(element));
+                              },
+                              [](JoiningState &state) -> JoiningState {
+                                return std::move(state);
+                              },
+                              [delimiter](JoiningState &state, JoiningState &other) {
+                                state.merge(delimiter, other);
+                              },
+                              IDENTITY_FINISH};
+  }
+
+  /**
+   * \fn auto summarizing(TypeToDouble &&mapper)
+   * \brief Returns a Collector computing count, sum, min, max, mean and variance of a double-valued function applied to the input elements in a single pass, instead of one terminal operation per statistic.
+   *
+   * Values are buffered in blocks of SummarizingState::BLOCK which are summarized with SSE2 when available, partial results merge exactly like sequential ones up to rounding.
+   * @tparam TypeToDouble type of function extracting the property to be summarized
+   * @param mapper a function extracting the property to be summarized
+   * @return a Collector producing SummaryStatistics of the derived property
+   */
+  template<typename TypeToDouble>
+  static auto summarizing(TypeToDouble &&mapper) {
+    return streams::Collector{[] { return SummarizingState(); },
+                              [mapper](SummarizingState &state, const auto &element) {
+                                state.add(static_cast<double>(mapper(element)));
+                              },
+                              [](SummarizingState &state) {
+                                state.flush();
+                                return state.statistics;
+                              },
+                              [](SummarizingState &state, SummarizingState &other) {
+                                state.flush();
+                                other.flush();
+                                state.statistics.merge(other.statistics);
+                              },
+                              UNORDERED};
+  }
+
+  /**
+   * \fn auto summarizing()
+   * \brief Returns a Collector computing count, sum, min, max, mean and variance of the numeric input elements in a single pass.
+   * @return a Collector producing SummaryStatistics of the input elements
+   */
+  static auto summarizing() {
+    return summarizing([](const auto &element) { return element; });
+  }
+
+  /**
+   * \fn auto collectingAndThen(Collector<Supplier, Accumulator, Finisher, Combiner> &&collector, Mapper &&mapper)
    * \brief Adapts a Collector to perform an additional finishing transformation.
    * @tparam Supplier Type of Supplier Function of the collector
    * @tparam Accumulator Type of Accumulator Function of the collector
    * @tparam Finisher Type of the Finisher Function of the collector
+   * @tparam Combiner Type of the Combiner Function of the collector
    * @tparam Mapper type of Finisher function to be applied to the final result of the downstream collector
    * @param collector
    * @param mapper
    * @return a collector which performs the action of the downstream collector, followed by an additional finishing step
    */
-  template<typename Supplier, typename Accumulator, typename Finisher, typename Mapper>
-  static auto collectingAndThen(Collector<Supplier, Accumulator, Finisher> &&collector, Mapper &&mapper) {
+  template<typename Supplier, typename Accumulator, typename Finisher, typename Combiner, typename Mapper>
+  static auto collectingAndThen(Collector<Supplier, Accumulator, Finisher, Combiner> &&collector, Mapper &&mapper) {
     return streams::Collector{collector.supplier(),
                               collector.accumulator(),
                               [collector, mapper](decltype(collector.supplier()()) &intermediate) {
                                 return mapper(collector.finisher()(intermediate));
-                              }};
+                              },
+                              collector.combiner(),
+                              collector.characteristics() & ~IDENTITY_FINISH};
+  }
+
+  /**
+   * \fn auto teeing(Args &&...collectorsAndMerger)
+   * \brief Returns a Collector that is a composite of downstream collectors, every element is passed to each of them in a single traversal and their results are merged by the last argument.
+   *
+   * The result containers of the downstream collectors are kept in a std::tuple, so no element is stored or type erased. The composite can combine partial results when every downstream collector can, and is UNORDERED when every downstream collector is.
+   * @tparam Args types of the downstream collectors followed by the type of the merger
+   * @param collectorsAndMerger two or more downstream collectors, then a function receiving their results in order and producing the final result
+   * @return a Collector which aggregates the results of the downstream collectors
+   */
+  template<typename... Args>
+  static auto teeing(Args &&...collectorsAndMerger) {
+    static_assert(sizeof...(Args) >= 3, "teeing requires at least two collectors and a merger");
+    auto arguments = std::forward_as_tuple(std::forward<Args>(collectorsAndMerger)...);
+    return tee(std::get<sizeof...(Args) - 1>(arguments), arguments, std::make_index_sequence<sizeof...(Args) - 1>());
+  }
+
+  /**
+   * \fn auto toHyperLogLog(unsigned precision = 12, const Hash &hash = Hash())
+   * \brief Returns a Collector that adds the input elements to a HyperLogLog sketch, which estimates their distinct count in 2^precision bytes. Sketches of shards or windows can be merged afterwards with HyperLogLog::merge.
+   * @tparam T type of input elements
+   * @tparam Hash hash function of input elements
+   * @param precision between 4 and 18, the relative standard error is 1.04 / sqrt(2^precision)
+   * @param hash
+   * @return a Collector producing a HyperLogLog sketch of the input elements
+   */
+  template<typename T, typename Hash = std::hash<T>>
+  static auto toHyperLogLog(unsigned precision = 12, const Hash &hash = Hash()) {
+    HyperLogLog empty(precision);
+    return streams::Collector{[empty] { return empty; },
+                              [hash](HyperLogLog &sketch, const T &element) {
+                                sketch.add(mixHash(hash(element)));
+                              },
+                              [](HyperLogLog &sketch) {
+                                return std::move(sketch);
+                              },
+                              [](HyperLogLog &sketch, HyperLogLog &other) {
+                                sketch.merge(other);
+                              },
+                              UNORDERED | IDENTITY_FINISH};
+  }
+
+  /**
+   * \fn auto approxDistinct(unsigned precision = 12, const Hash &hash = Hash())
+   * \brief Returns a Collector estimating the number of distinct input elements with a HyperLogLog sketch, in 2^precision bytes whatever the number of elements. Use it instead of toSet() or distinct() followed by count() when an estimate is enough.
+   * @tparam T type of input elements
+   * @tparam Hash hash function of input elements
+   * @param precision between 4 and 18, the relative standard error is 1.04 / sqrt(2^precision), 1.6% for the default 12
+   * @param hash
+   * @return a Collector estimating the distinct count of the input elements
+   */
+  template<typename T, typename Hash = std::hash<T>>
+  static auto approxDistinct(unsigned precision = 12, const Hash &hash = Hash()) {
+    return collectingAndThen(toHyperLogLog<T>(precision, hash), [](const HyperLogLog &sketch) {
+      return static_cast<size_t>(std::llround(sketch.estimate()));
+    });
+  }
+
+  /**
+   * \fn auto toTDigest(double compression = 100)
+   * \brief Returns a Collector that adds the numeric input elements to a TDigest, which estimates any quantile of them with bounded memory. Digests of shards or windows can be merged afterwards with TDigest::merge.
+   * @param compression at least 10, larger digests are more accurate
+   * @return a Collector producing a TDigest of the input elements
+   */
+  static auto toTDigest(double compression = 100) {
+    TDigest empty(compression);
+    return streams::Collector{[empty] { return empty; },
+                              [](TDigest &digest, const auto &element) {
+                                digest.add(static_cast<double>(element));
+                              },
+                              [](TDigest &digest) {
+                                digest.compress();
+                                return std::move(digest);
+                              },
+                              [](TDigest &digest, TDigest &other) {
+                                digest.merge(other);
+                              },
+                              UNORDERED};
+  }
+
+  /**
+   * \fn auto quantiles(std::vector<double> fractions, double compression = 100)
+   * \brief Returns a Collector estimating quantiles of the numeric input elements in a single pass with a TDigest, instead of sorting the whole input.
+   *
+   * The rank error of a quantile q is roughly proportional to q * (1 - q) / compression, so p99 and p999 are more accurate than the median. Memory is bounded by the compression whatever the number of elements.
+   * std::vector<double> latencies = requests.stream().map([](auto request){return request.latency;}).collect(Collectors::quantiles({0.5, 0.99, 0.999}));
+   * @param fractions quantiles to estimate, between 0 and 1
+   * @param compression at least 10, larger digests are more accurate
+   * @return a Collector returning the estimated quantiles in the order of fractions, NaN for an empty input
+   */
+  static auto quantiles(std::vector<double> fractions, double compression = 100) {
+    if (std::any_of(fractions.begin(), fractions.end(), [](double fraction) { return !(fraction >= 0 && fraction <= 1); })) {
+      throw std::invalid_argument("quantiles fractions must be between 0 and 1");
+    }
+    return collectingAndThen(toTDigest(compression), [fractions](const TDigest &digest) {
+      std::vector<double> result;
+      result.reserve(fractions.size());
+      for (double fraction : fractions) {
+        result.emplace_back(digest.quantile(fraction));
+      }
+      return result;
+    });
+  }
+
+  /**
+   * \fn auto heavyHitters(size_t k, double epsilon, const Hash &hash = Hash(), const KeyEqual &keyEqual = KeyEqual())
+   * \brief Returns a Collector finding the k most frequent input elements with a SpaceSaving summary of max(k, 1 / epsilon) counters, instead of counting every distinct element with groupingBy and sorting.
+   *
+   * Every element more frequent than epsilon times the number of elements is reported if it is among the k largest counts, and reported counts overestimate by at most epsilon times the number of elements, see FrequentItem::error.
+   * @tparam T type of input elements
+   * @tparam Hash hash function of input elements
+   * @tparam KeyEqual equals of input elements
+   * @param k number of items to report
+   * @param epsilon error relative to the number of elements, between 0 and 1
+   * @param hash
+   * @param keyEqual
+   * @return a Collector returning up to k FrequentItem by decreasing count
+   */
+  template<typename T, typename Hash = std::hash<T>, typename KeyEqual = std::equal_to<T>>
+  static auto heavyHitters(size_t k, double epsilon, const Hash &hash = Hash(), const KeyEqual &keyEqual = KeyEqual()) {
+    if (k == 0 || !(epsilon > 0 && epsilon <= 1)) {
+      throw std::invalid_argument("heavyHitters needs k > 0 and epsilon in (0, 1]");
+    }
+    using Summary = SpaceSaving<T, Hash, KeyEqual>;
+    auto capacity = std::max(k, static_cast<size_t>(std::ceil(1 / epsilon)));
+    return streams::Collector{[capacity, hash, keyEqual] { return Summary(capacity, hash, keyEqual); },
+                              [](Summary &summary, const T &element) {
+                                summary.add(element);
+                              },
+                              [k](Summary &summary) {
+                                return summary.topK(k);
+                              },
+                              [](Summary &summary, Summary &other) {
+                                summary.merge(other);
+                              },
+                              UNORDERED};
+  }
+
+  /**
+   * \fn auto sample(size_t k, uint64_t seed = 0)
+   * \brief Returns a Collector keeping a uniform random sample of k input elements with a Reservoir, instead of the biased prefix of limit() or all the elements of toVector().
+   * @tparam T type of input elements
+   * @param k size of the sample, all elements are kept when there are fewer
+   * @param seed seed of the random number generator, the same seed gives the same sample of the same input
+   * @return a Collector returning a vector of at most k elements
+   */
+  template<typename T>
+  static auto sample(size_t k, uint64_t seed = 0) {
+    return sampling<T>(k, seed, false);
+  }
+
+  /**
+   * \fn auto sampleSkipping(size_t k, uint64_t seed = 0)
+   * \brief Returns a Collector keeping a uniform random sample of k input elements, drawing the number of elements to skip between replacements instead of a random number per element. It is faster than sample() when there are many more elements than k.
+   * @tparam T type of input elements
+   * @param k size of the sample, all elements are kept when there are fewer
+   * @param seed seed of the random number generator
+   * @return a Collector returning a vector of at most k elements
+   */
+  template<typename T>
+  static auto sampleSkipping(size_t k, uint64_t seed = 0) {
+    return sampling<T>(k, seed, true);
+  }
+
+  /**
+   * \fn auto sampleBy(Classifier &&classifier, size_t kPerKey, uint64_t seed = 0)
+   * \brief Returns a Collector keeping a stratified sample, a uniform random sample of kPerKey input elements for every key returned by the classifier, so rare keys are represented as well as frequent ones.
+   * @tparam T type of input elements
+   * @tparam Classifier type of function extracting the key of the stratum
+   * @param classifier
+   * @param kPerKey size of the sample of every key
+   * @param seed seed of the random number generators, the reservoir of a key is seeded from seed and the hash of the key
+   * @return a Collector returning an unordered map from key to a vector of at most kPerKey elements
+   */
+  template<typename T, typename Classifier>
+  static auto sampleBy(Classifier &&classifier, size_t kPerKey, uint64_t seed = 0) {
+    using K = typename std::invoke_result<Classifier, T>::type;
+    using Strata = std::unordered_map<K, Reservoir<T>>;
+    if (kPerKey == 0) {
+      throw std::invalid_argument("sampleBy needs kPerKey > 0");
+    }
+    return streams::Collector{[] { return Strata(); },
+                              [classifier, kPerKey, seed](Strata &strata, const T &element) {
+                                auto key = classifier(element);
+                                auto position = strata.find(key);
+                                if (position == strata.end()) {
+                                  auto keySeed = mixHash(seed ^ std::hash<K>()(key));
+                                  position = strata.try_emplace(std::move(key), kPerKey, keySeed).first;
+                                }
+                                position->second.add(element);
+                              },
+                              [](Strata &strata) {
+                                std::unordered_map<K, std::vector<T>> samples;
+                                for (auto &[key, reservoir] : strata) {
+                                  samples.try_emplace(key, reservoir.items());
+                                }
+                                return samples;
+                              },
+                              [](Strata &strata, Strata &other) {
+                                for (auto &[key, reservoir] : other) {
+                                  auto [position, inserted] = strata.try_emplace(key, std::move(reservoir));
+                                  if (!inserted) {
+                                    position->second.merge(reservoir);
+                                  }
+                                }
+                              },
+                              UNORDERED};
+  }
+
+  /**
+   * \fn auto toHistogram(TypeToDouble &&mapper, const Histogram &empty)
+   * \brief Returns a Collector counting a double-valued function applied to the input elements in a copy of an empty Histogram, instead of groupingBy a bucket function with counting(). Values are buffered in blocks of HistogramState::BLOCK whose bins are computed with SSE2 when available.
+   * @tparam TypeToDouble type of function extracting the counted property
+   * @param mapper a function extracting the counted property
+   * @param empty histogram with the layout of the result, Histogram::linear() or Histogram::logarithmic()
+   * @return a Collector producing a Histogram of the derived property
+   */
+  template<typename TypeToDouble>
+  static auto toHistogram(TypeToDouble &&mapper, const Histogram &empty) {
+    return streams::Collector{[empty] { return HistogramState(empty); },
+                              [mapper](HistogramState &state, const auto &element) {
+                                state.add(static_cast<double>(mapper(element)));
+                              },
+                              [](HistogramState &state) {
+                                state.flush();
+                                return state.histogram;
+                              },
+                              [](HistogramState &state, HistogramState &other) {
+                                state.flush();
+                                other.flush();
+                                state.histogram.merge(other.histogram);
+                              },
+                              UNORDERED};
+  }
+
+  /**
+   * \fn auto histogram(TypeToDouble &&mapper, double min, double max, size_t bins)
+   * \brief Returns a Collector counting a double-valued function applied to the input elements in bins of equal width between min and max, see Histogram::linear().
+   * @tparam TypeToDouble type of function extracting the counted property
+   * @param mapper
+   * @param min lower bound of the first bin
+   * @param max upper bound of the last bin
+   * @param bins number of bins
+   * @return a Collector producing a Histogram of the derived property
+   */
+  template<typename TypeToDouble, typename = std::enable_if_t<!std::is_arithmetic_v<std::decay_t<TypeToDouble>>>>
+  static auto histogram(TypeToDouble &&mapper, double min, double max, size_t bins) {
+    return toHistogram(std::forward<TypeToDouble>(mapper), Histogram::linear(min, max, bins));
+  }
+
+  /**
+   * \fn auto histogram(double min, double max, size_t bins)
+   * \brief Returns a Collector counting the numeric input elements in bins of equal width between min and max, see Histogram::linear().
+   * @param min lower bound of the first bin
+   * @param max upper bound of the last bin
+   * @param bins number of bins
+   * @return a Collector producing a Histogram of the input elements
+   */
+  static auto histogram(double min, double max, size_t bins) {
+    return histogram([](const auto &element) { return element; }, min, max, bins);
+  }
+
+  /**
+   * \fn auto logHistogram(TypeToDouble &&mapper, double min, double max, unsigned precision = 2)
+   * \brief Returns a Collector counting a double-valued function applied to the input elements in bins whose width is proportional to their values, like HdrHistogram, for latencies and sizes spanning several orders of magnitude, see Histogram::logarithmic().
+   * @tparam TypeToDouble type of function extracting the counted property
+   * @param mapper
+   * @param min lowest tracked value, greater than 0
+   * @param max highest tracked value
+   * @param precision number of significant decimal digits of values, between 1 and 4
+   * @return a Collector producing a Histogram of the derived property
+   */
+  template<typename TypeToDouble, typename = std::enable_if_t<!std::is_arithmetic_v<std::decay_t<TypeToDouble>>>>
+  static auto logHistogram(TypeToDouble &&mapper, double min, double max, unsigned precision = 2) {
+    return toHistogram(std::forward<TypeToDouble>(mapper), Histogram::logarithmic(min, max, precision));
+  }
+
+  /**
+   * \fn auto logHistogram(double min, double max, unsigned precision = 2)
+   * \brief Returns a Collector counting the numeric input elements in bins whose width is proportional to their values, see Histogram::logarithmic().
+   * @param min lowest tracked value, greater than 0
+   * @param max highest tracked value
+   * @param precision number of significant decimal digits of values, between 1 and 4
+   * @return a Collector producing a Histogram of the input elements
+   */
+  static auto logHistogram(double min, double max, unsigned precision = 2) {
+    return logHistogram([](const auto &element) { return element; }, min, max, precision);
+  }
+
+  /**
+   * \fn auto bloomFilter(size_t expectedItems, double fpp = 0.01, const Hash &hash = Hash())
+   * \brief Returns a Collector adding the input elements to a BloomFilter sized for expectedItems distinct elements and a false positive probability, a compact replacement of toUnorderedSet() for membership tests with Stream::filterMightContain().
+   * @tparam T type of input elements
+   * @tparam Hash hash function of input elements
+   * @param expectedItems number of distinct elements expected
+   * @param fpp false positive probability
+   * @param hash
+   * @return a Collector producing a BloomFilter of the input elements
+   */
+  template<typename T, typename Hash = std::hash<T>>
+  static auto bloomFilter(size_t expectedItems, double fpp = 0.01, const Hash &hash = Hash()) {
+    BloomFilter<T, Hash> empty(expectedItems, fpp, hash);
+    return streams::Collector{[empty] { return empty; },
+                              [](BloomFilter<T, Hash> &filter, const T &element) {
+                                filter.add(element);
+                              },
+                              [](BloomFilter<T, Hash> &filter) {
+                                return std::move(filter);
+                              },
+                              [](BloomFilter<T, Hash> &filter, BloomFilter<T, Hash> &other) {
+                                filter.merge(other);
+                              },
+                              UNORDERED | IDENTITY_FINISH};
   }
 
   /**
@@ -180,23 +591,25 @@ struct Collectors final {
   template<typename T, typename Classifier, typename K = typename std::invoke_result_t<Classifier, T>, typename Compare = std::less<K>,
            class Allocator = std::allocator<std::pair<const K, std::vector<T>>>>
   static auto groupingByOrdered(Classifier &&mapper, Compare cmp = Compare(), Allocator allocator = Allocator()) {
-    return streams::Collector{[] { return std::vector<std::pair<K, T>>(); },
-                              [mapper](std::vector<std::pair<K, T>> &intermediate, const T &element) {
-                                intermediate.emplace_back(std::pair<K, T>{mapper(element), element});
-                              },
-                              [cmp, allocator](auto &intermediate) {
-                                std::map<K, std::vector<T>, Compare, Allocator> result(cmp, allocator);
-                                for (auto &item : intermediate) {
-                                  result.try_emplace(item.first, std::vector<T>());
-                                  result[item.first].emplace_back(item.second);
-                                }
-                                return result;
-                              }};
+    using Groups = std::map<K, std::vector<T>, Compare, Allocator>;
+    return streams::Collector{[cmp, allocator] { return Groups(cmp, allocator); },
+                              [mapper](Groups &groups, auto &&element) {
+                                groups[mapper(element)].emplace_back(std::forward<decltype(element)>(element));
+                              },
+                              [](Groups &groups) {
+                                return std::move(groups);
+                              },
+                              [](Groups &groups, Groups &other) {
+                                mergeGroups(groups, other);
+                              },
+                              IDENTITY_FINISH};
   }
 
   /**
    * \fn auto groupingBy(Classifier &&mapper, Hash hash = Hash(), KeyEqual keyEqual = KeyEqual(), Allocator allocator = Allocator())
    * \brief Returns a Collector implementing a "group by" operation on input elements of type T, grouping elements according to a classification function, and returning the results in a Unordered Map.
+   *
+   * The groups are laid out according to the keys of the first elements, see AdaptiveGroups: integral and enum keys dense enough, compared with std::equal_to, are grouped in an array indexed by the key until a key too sparse for it arrives, other keys in the map reserved for their estimated number.
    * @tparam T input elements type
    * @tparam Classifier the type of classifier function mapping input elements to keys
    * @tparam K Key type
@@ -213,24 +626,25 @@ struct Collectors final {
            class KeyEqual = std::equal_to<K>,
            class Allocator = std::allocator<std::pair<const K, std::vector<T>>>>
   static auto groupingBy(Classifier &&mapper, const Hash &hash = Hash(), const KeyEqual &keyEqual = KeyEqual(), const Allocator &allocator = Allocator()) {
-    return streams::Collector{[] { return std::vector<std::pair<K, T>>(); },
-                              [mapper](std::vector<std::pair<K, T>> &intermediate, const T &element) {
-                                intermediate.emplace_back(std::pair<K, T>{mapper(element), element});
-                              },
-                              [&hash, &keyEqual, &allocator](std::vector<std::pair<K, T>> &intermediate) {
-                                std::unordered_map<K, std::vector<T>, Hash, KeyEqual, Allocator> result{1, hash, keyEqual, allocator};
-                                for (const auto &item : intermediate) {
-                                  result.try_emplace(item.first, std::vector<T>());
-                                  result[item.first].emplace_back(item.second);
-                                }
-                                return result;
+    using Groups = std::unordered_map<K, std::vector<T>, Hash, KeyEqual, Allocator>;
+    using State = AdaptiveGroups<K, T, Groups>;
+    return streams::Collector{[hash, keyEqual, allocator] { return State{Groups{1, hash, keyEqual, allocator}}; },
+                              [mapper](State &groups, auto &&element) {
+                                groups.add(mapper(element), std::forward<decltype(element)>(element));
+                              },
+                              [](State &groups) {
+                                return groups.finish();
+                              },
+                              [](State &groups, State &other) {
+                                groups.merge(other);
                               }};
   }
 
   /**
-   * \fn auto groupingByOrdered(Classifier &&mapper, Collector<Supplier, Accumulator, Finisher> &&collector, Compare cmp = Compare(), Allocator allocator = Allocator())
+   * \fn auto groupingByOrdered(Classifier &&mapper, Collector<Supplier, Accumulator, Finisher, Combiner> &&collector, Compare cmp = Compare(), Allocator allocator = Allocator())
    * \brief Returns a Collector implementing a cascaded "group by" operation on input elements of type T, grouping elements according to a classification function, and then performing a reduction operation on the values associated with a given key using the specified downstream Collector.
    *
+   * Grouping is single pass, every key keeps one result container of the downstream collector which accumulates the elements as they arrive, so memory is proportional to the number of keys rather than to the number of elements.
    * There are no guarantees on the type, mutability, serializability, or thread-safety of the Map returned.
    * // Compute sum of salaries by department <br/>
    *    std::map<Department, double> totalByDept = employees.stream()
@@ -242,6 +656,7 @@ struct Collectors final {
    * @tparam Supplier type of Supplier of downstream collector
    * @tparam Accumulator type of Accumulator of downstream collector
    * @tparam Finisher type of Finisher of downstream collector
+   * @tparam Combiner type of Combiner of downstream collector
    * @tparam Compare type of Comparator for returning map
    * @tparam Allocator type of Allocator for returning map
    * @param mapper
@@ -250,33 +665,39 @@ struct Collectors final {
    * @param allocator
    * @return a Collector implementing the cascaded group-by operation
    */
-  template<typename T, typename Classifier, typename K = typename std::invoke_result_t<Classifier, T>, typename Supplier, typename Accumulator, typename Finisher, typename Compare = std::less<K>,
+  template<typename T, typename Classifier, typename K = typename std::invoke_result_t<Classifier, T>, typename Supplier, typename Accumulator, typename Finisher, typename Combiner, typename Compare = std::less<K>,
            class Allocator = std::allocator<std::pair<const K, std::vector<T>>>>
-  static auto groupingByOrdered(Classifier &&mapper, Collector<Supplier, Accumulator, Finisher> &&collector, Compare cmp = Compare(), Allocator allocator = Allocator()) {
-    return streams::Collector{[] { return std::vector<std::pair<K, T>>(); },
-                              [mapper](std::vector<std::pair<K, T>> &intermediate, const T &element) {
-                                intermediate.emplace_back(std::pair<K, T>{mapper(element), element});
-                              },
-                              [&collector, &cmp, &allocator](auto &intermediate) {
-                                std::map<K, std::vector<T>, Compare, Allocator> iResult(cmp, allocator);
-                                for (auto &item : intermediate) {
-                                  iResult.try_emplace(item.first, std::vector<T>());
-                                  iResult[item.first].emplace_back(item.second);
+  static auto groupingByOrdered(Classifier &&mapper, Collector<Supplier, Accumulator, Finisher, Combiner> &&collector, Compare cmp = Compare(), Allocator allocator = Allocator()) {
+    using State = decltype(collector.supply());
+    using X = decltype(collector.finish(std::declval<State &>()));
+    using States = std::map<K, State, Compare, typename std::allocator_traits<Allocator>::template rebind_alloc<std::pair<const K, State>>>;
+    return streams::Collector{[cmp, allocator] { return States(cmp, allocator); },
+                              [mapper, collector](States &states, auto &&element) {
+                                K key = mapper(element);
+                                auto position = states.lower_bound(key);
+                                if (position == states.end() || states.key_comp()(key, position->first)) {
+                                  position = states.emplace_hint(position, std::move(key), collector.supply());
                                 }
-                                auto repr = (*iResult.begin()).second;
-                                using X = decltype(collector.apply(repr));
+                                collector.accumulate(position->second, std::forward<decltype(element)>(element));
+                              },
+                              [collector, cmp](States &states) {
                                 std::map<K, X, Compare> result(cmp);
-                                for (auto &item : iResult) {
-                                  result.insert({item.first, collector.apply(item.second)});
+                                for (auto &[key, state] : states) {
+                                  result.emplace_hint(result.end(), key, collector.finish(state));
                                 }
                                 return result;
-                              }};
+                              },
+                              [collector](auto &states, auto &other) {
+                                combineStates(states, other, collector);
+                              },
+                              collector.characteristics() & UNORDERED};
   }
 
   /**
-   * \fn auto groupingByOrdered(Classifier &&mapper, Collector<Supplier, Accumulator, Finisher> &&collector, Compare cmp = Compare(), Allocator allocator = Allocator())
+   * \fn auto groupingByOrdered(Classifier &&mapper, Collector<Supplier, Accumulator, Finisher, Combiner> &&collector, Compare cmp = Compare(), Allocator allocator = Allocator())
    * \brief Returns a Collector implementing a cascaded "group by" operation on input elements of type T, grouping elements according to a classification function, and then performing a reduction operation on the values associated with a given key using the specified downstream Collector.
    *
+   * Grouping is single pass, every key keeps one result container of the downstream collector which accumulates the elements as they arrive, so memory is proportional to the number of keys rather than to the number of elements.
    * There are no guarantees on the type, mutability, serializability, or thread-safety of the Map returned.
    * // Compute sum of salaries by department <br/>
    *    std::unordered_map<Department, double> totalByDept = employees.stream()
@@ -288,6 +709,7 @@ struct Collectors final {
    * @tparam Supplier type of Supplier of downstream collector
    * @tparam Accumulator type of Accumulator of downstream collector
    * @tparam Finisher type of Finisher of downstream collector
+   * @tparam Combiner type of Combiner of downstream collector
    * @tparam Hash Hash function of key of resulting map
    * @tparam KeyEqual Key Equals function of key of resulting map
    * @tparam Allocator Allocator for the resulting map
@@ -298,52 +720,203 @@ struct Collectors final {
    * @param allocator
    * @return
    */
-  template<typename T, typename Classifier, typename K = typename std::invoke_result_t<Classifier, T>, typename Supplier, typename Accumulator, typename Finisher, class Hash = std::hash<K>,
+  template<typename T, typename Classifier, typename K = typename std::invoke_result_t<Classifier, T>, typename Supplier, typename Accumulator, typename Finisher, typename Combiner, class Hash = std::hash<K>,
            class KeyEqual = std::equal_to<K>,
            class Allocator = std::allocator<std::pair<const K, std::vector<T>>>>
-  static auto groupingBy(Classifier &&mapper, Collector<Supplier, Accumulator, Finisher> &&collector, const Hash &hash = Hash(), const KeyEqual &keyEqual = KeyEqual(), const Allocator &allocator = Allocator()) {
-    return streams::Collector{[] { return std::vector<std::pair<K, T>>(); },
-                              [mapper](std::vector<std::pair<K, T>> &intermediate, const T &element) {
-                                intermediate.emplace_back(std::pair<K, T>{mapper(element), element});
-                              },
-                              [&collector, &hash, &keyEqual, &allocator](auto &intermediate) {
-                                std::unordered_map<K, std::vector<T>, Hash, KeyEqual, Allocator> iResult{1, hash, keyEqual, allocator};
-                                for (auto &item : intermediate) {
-                                  iResult.try_emplace(item.first, std::vector<T>());
-                                  iResult[item.first].emplace_back(item.second);
+  static auto groupingBy(Classifier &&mapper, Collector<Supplier, Accumulator, Finisher, Combiner> &&collector, const Hash &hash = Hash(), const KeyEqual &keyEqual = KeyEqual(), const Allocator &allocator = Allocator()) {
+    using State = decltype(collector.supply());
+    using X = decltype(collector.finish(std::declval<State &>()));
+    using States = std::unordered_map<K, State, Hash, KeyEqual, typename std::allocator_traits<Allocator>::template rebind_alloc<std::pair<const K, State>>>;
+    return streams::Collector{[hash, keyEqual, allocator] { return States{1, hash, keyEqual, allocator}; },
+                              [mapper, collector](States &states, auto &&element) {
+                                accumulateState(states, mapper(element), collector, std::forward<decltype(element)>(element));
+                              },
+                              [collector, hash, keyEqual](States &states) {
+                                std::unordered_map<K, X, Hash, KeyEqual> result{states.size(), hash, keyEqual};
+                                for (auto &[key, state] : states) {
+                                  result.emplace(key, collector.finish(state));
                                 }
-                                auto repr = (*iResult.begin()).second;
-                                using X = decltype(collector.apply(repr));
-                                std::unordered_map<K, X, Hash, KeyEqual> result{1, hash, keyEqual};
-                                for (auto &item : iResult) {
-                                  result.emplace(item.first, collector.apply(item.second));
+                                return result;
+                              },
+                              [collector](auto &states, auto &other) {
+                                combineStates(states, other, collector);
+                              },
+                              collector.characteristics() & UNORDERED};
+  }
+
+  /**
+   * \fn auto groupingByFlat(Classifier &&mapper, size_t expectedKeys = 0, Hash hash = Hash(), KeyEqual keyEqual = KeyEqual())
+   * \brief Returns a Collector implementing a "group by" operation on input elements of type T like groupingBy, returning the results in a collection::SFlatMap.
+   *
+   * The flat map keeps its entries in one array probed by 16 control bytes at a time, which is faster than std::unordered_map for many small keys. Pass expectedKeys when the number of distinct keys is known to group without rehashing.
+   * @tparam T input elements type
+   * @tparam Classifier the type of classifier function mapping input elements to keys
+   * @tparam K Key type
+   * @tparam Hash Hash of Key
+   * @tparam KeyEqual Equals for Key
+   * @param mapper
+   * @param expectedKeys number of distinct keys to reserve room for
+   * @param hash
+   * @param keyEqual
+   * @return a Collector implementing the group-by operation
+   */
+  template<typename T, typename Classifier, typename K = typename std::invoke_result_t<Classifier, T>, class Hash = std::hash<K>,
+           class KeyEqual = std::equal_to<K>>
+  static auto groupingByFlat(Classifier &&mapper, size_t expectedKeys = 0, const Hash &hash = Hash(), const KeyEqual &keyEqual = KeyEqual()) {
+    using Groups = collection::SFlatMap<K, std::vector<T>, Hash, KeyEqual>;
+    return streams::Collector{[expectedKeys, hash, keyEqual] { return Groups(expectedKeys, hash, keyEqual); },
+                              [mapper](Groups &groups, auto &&element) {
+                                groups[mapper(element)].emplace_back(std::forward<decltype(element)>(element));
+                              },
+                              [](Groups &groups) {
+                                return std::move(groups);
+                              },
+                              [](Groups &groups, Groups &other) {
+                                mergeGroups(groups, other);
+                              },
+                              IDENTITY_FINISH};
+  }
+
+  /**
+   * \fn auto groupingByFlat(Classifier &&mapper, Collector<Supplier, Accumulator, Finisher, Combiner> &&collector, size_t expectedKeys = 0, Hash hash = Hash(), KeyEqual keyEqual = KeyEqual())
+   * \brief Returns a Collector implementing a cascaded "group by" operation like groupingBy, keeping the downstream result containers and returning the results in a collection::SFlatMap.
+   * @tparam T type of input element
+   * @tparam Classifier type of classifier function mapping input elements to keys
+   * @tparam K type of keys
+   * @tparam Supplier type of Supplier of downstream collector
+   * @tparam Accumulator type of Accumulator of downstream collector
+   * @tparam Finisher type of Finisher of downstream collector
+   * @tparam Combiner type of Combiner of downstream collector
+   * @tparam Hash Hash function of key of resulting map
+   * @tparam KeyEqual Key Equals function of key of resulting map
+   * @param mapper
+   * @param collector
+   * @param expectedKeys number of distinct keys to reserve room for
+   * @param hash
+   * @param keyEqual
+   * @return a Collector implementing the cascaded group-by operation
+   */
+  template<typename T, typename Classifier, typename K = typename std::invoke_result_t<Classifier, T>, typename Supplier, typename Accumulator, typename Finisher, typename Combiner, class Hash = std::hash<K>,
+           class KeyEqual = std::equal_to<K>>
+  static auto groupingByFlat(Classifier &&mapper, Collector<Supplier, Accumulator, Finisher, Combiner> &&collector, size_t expectedKeys = 0, const Hash &hash = Hash(), const KeyEqual &keyEqual = KeyEqual()) {
+    using State = decltype(collector.supply());
+    using X = decltype(collector.finish(std::declval<State &>()));
+    using States = collection::SFlatMap<K, State, Hash, KeyEqual>;
+    return streams::Collector{[expectedKeys, hash, keyEqual] { return States(expectedKeys, hash, keyEqual); },
+                              [mapper, collector](States &states, auto &&element) {
+                                accumulateState(states, mapper(element), collector, std::forward<decltype(element)>(element));
+                              },
+                              [collector, hash, keyEqual](States &states) {
+                                collection::SFlatMap<K, X, Hash, KeyEqual> result(states.size(), hash, keyEqual);
+                                for (auto &[key, state] : states) {
+                                  result.try_emplace(key, collector.finish(state));
                                 }
                                 return result;
+                              },
+                              [collector](auto &states, auto &other) {
+                                combineStates(states, other, collector);
+                              },
+                              collector.characteristics() & UNORDERED};
+  }
+
+  /**
+   * \fn auto aggregatingBy(KeyMapper &&keyMapper, Aggregate &&...aggregates)
+   * \brief Returns a Collector grouping the input elements by key and computing several aggregates of every group in a single pass, the collector form of Stream::aggregateBy().
+   * @tparam T type of input elements
+   * @tparam KeyMapper type of function extracting the key of the group
+   * @tparam Aggregate types of the aggregates
+   * @param keyMapper
+   * @param aggregates aggregates created by Aggregates
+   * @return a Collector producing an AggregateTable with one row per key
+   */
+  template<typename T, typename KeyMapper, typename... Aggregate>
+  static auto aggregatingBy(KeyMapper &&keyMapper, Aggregate &&...aggregates) {
+    using State = AggregationState<T, std::decay_t<KeyMapper>, std::decay_t<Aggregate>...>;
+    return streams::Collector{[keyMapper, aggregateTuple = std::make_tuple(aggregates...)] { return State(keyMapper, aggregateTuple); },
+                              [](State &state, const T &element) {
+                                state.add(element);
+                              },
+                              [](State &state) {
+                                return state.finish();
+                              },
+                              [](State &state, State &other) {
+                                state.merge(other);
                               }};
   }
 
   /**
-   * \fn auto joining(std::string delimiter = " ", std::string prefix = "", std::string suffix = "")
-   * Returns a Collector that concatenates the input elements, separated by the specified delimiter, with the specified prefix and suffix, in encounter order.
-   * @param delimiter the delimiter to be used between each element
-   * @param prefix the sequence of characters to be used at the beginning of the joined result
-   * @param suffix the sequence of characters to be used at the end of the joined result
-   * @return A Collector which concatenates CharSequence elements, separated by the specified delimiter, in encounter order
+   * \fn auto groupingByDense(Classifier &&mapper, size_t maxKey)
+   * \brief Returns a Collector implementing a "group by" operation on input elements of type T whose keys are small non negative integers or enums, like hour of day or shard number, returning a vector of groups indexed by key.
+   *
+   * Groups live in an array indexed directly by key, so no key is hashed or compared. Keys which have no element have an empty group. A key greater than maxKey throws std::out_of_range.
+   * Partial results collected by different threads are combined index by index.
+   * @tparam T input elements type
+   * @tparam Classifier the type of classifier function mapping input elements to integral or enum keys
+   * @param mapper
+   * @param maxKey largest key returned by mapper
+   * @return a Collector implementing the dense group-by operation
    */
-  static auto joining(std::string delimiter = " ", std::string prefix = "", std::string suffix = "") {
-    return streams::Collector{[] { return std::vector<std::string>(); },
-                              [](std::vector<std::string> &intermediate, const auto &element) {
-                                intermediate.emplace_back(element);
-                              },
-                              [&](std::vector<std::string> &intermediate) -> std::string {
-                                std::stringstream sstream;
-                                sstream << prefix;
-                                for (size_t i = 0; i < intermediate.size() - 1; i++) {
-                                  sstream << intermediate[i] << delimiter;
+  template<typename T, typename Classifier>
+  static auto groupingByDense(Classifier &&mapper, size_t maxKey) {
+    using Groups = std::vector<std::vector<T>>;
+    return streams::Collector{[maxKey] { return Groups(maxKey + 1); },
+                              [mapper](Groups &groups, auto &&element) {
+                                groups[denseIndex(mapper(element), groups.size())].emplace_back(std::forward<decltype(element)>(element));
+                              },
+                              [](Groups &groups) {
+                                return std::move(groups);
+                              },
+                              [](Groups &groups, Groups &other) {
+                                for (size_t key = 0; key < groups.size(); key++) {
+                                  append(groups[key], other[key]);
                                 }
-                                sstream << intermediate[intermediate.size() - 1] << suffix;
-                                return sstream.str();
-                              }};
+                              },
+                              IDENTITY_FINISH};
+  }
+
+  /**
+   * \fn auto groupingByDense(Classifier &&mapper, size_t maxKey, Collector<Supplier, Accumulator, Finisher, Combiner> &&downstream)
+   * \brief Returns a Collector implementing a cascaded "group by" operation on input elements of type T whose keys are small non negative integers or enums, reducing each group with the downstream Collector and returning a vector of results indexed by key.
+   *
+   * Every key from 0 to maxKey has a downstream result container in an array indexed directly by key, so keys which have no element hold the result of an empty group, for example 0 for counting(). A key greater than maxKey throws std::out_of_range.
+   * Partial results collected by different threads are combined index by index with the downstream combiner.
+   * // Count events by hour of day <br/>
+   *    std::vector<size_t> eventsByHour = events.stream()
+   *                                           .collect(Collectors::groupingByDense<Event>([](auto event){return event.hour;}, 23, Collectors::counting()));
+   * @tparam T type of input element
+   * @tparam Classifier type of classifier function mapping input elements to integral or enum keys
+   * @tparam Supplier type of Supplier of downstream collector
+   * @tparam Accumulator type of Accumulator of downstream collector
+   * @tparam Finisher type of Finisher of downstream collector
+   * @tparam Combiner type of Combiner of downstream collector
+   * @param mapper
+   * @param maxKey largest key returned by mapper
+   * @param downstream
+   * @return a Collector implementing the cascaded dense group-by operation
+   */
+  template<typename T, typename Classifier, typename Supplier, typename Accumulator, typename Finisher, typename Combiner>
+  static auto groupingByDense(Classifier &&mapper, size_t maxKey, Collector<Supplier, Accumulator, Finisher, Combiner> &&downstream) {
+    using State = decltype(downstream.supply());
+    using States = std::vector<State>;
+    return streams::Collector{[maxKey, downstream] { return States(maxKey + 1, downstream.supply()); },
+                              [mapper, downstream](States &states, auto &&element) {
+                                auto key = denseIndex(mapper(element), states.size());
+                                downstream.accumulate(states[key], std::forward<decltype(element)>(element));
+                              },
+                              [downstream](States &states) {
+                                std::vector<decltype(downstream.finish(std::declval<State &>()))> result;
+                                result.reserve(states.size());
+                                for (auto &state : states) {
+                                  result.emplace_back(downstream.finish(state));
+                                }
+                                return result;
+                              },
+                              [downstream](States &states, States &other) {
+                                for (size_t key = 0; key < states.size(); key++) {
+                                  downstream.combine(states[key], other[key]);
+                                }
+                              },
+                              downstream.characteristics() & UNORDERED};
   }
 
   /**
@@ -356,14 +929,21 @@ struct Collectors final {
    */
   template<typename T, typename Comparator>
   static auto maxBy(Comparator &&comp) {
-    return streams::Collector{[] { return std::vector<T>(); },
-                              [](std::vector<T> &intermediate, const auto &element) {
-                                intermediate.emplace_back(element);
+    return streams::Collector{[] { return std::optional<T>(); },
+                              [comp](std::optional<T> &best, auto &&element) {
+                                if (!best.has_value() || comp(best.value(), element)) {
+                                  best = std::forward<decltype(element)>(element);
+                                }
                               },
-                              [&](std::vector<T> &intermediate) -> std::optional<T> {
-                                auto iterator = std::max_element(intermediate.begin(), intermediate.end(), comp);
-                                return iterator != intermediate.end() ? std::optional<T>(*iterator) : std::nullopt;
-                              }};
+                              [](std::optional<T> &best) -> std::optional<T> {
+                                return std::move(best);
+                              },
+                              [comp](std::optional<T> &best, std::optional<T> &other) {
+                                if (other.has_value() && (!best.has_value() || comp(best.value(), other.value()))) {
+                                  best = std::move(other);
+                                }
+                              },
+                              IDENTITY_FINISH};
   }
   /**
    * \fn auto minBy(Comparator &&comp)
@@ -375,14 +955,21 @@ struct Collectors final {
    */
   template<typename T, typename Comparator>
   static auto minBy(Comparator &&comp) {
-    return streams::Collector{[] { return std::vector<T>(); },
-                              [](std::vector<T> &intermediate, const auto &element) {
-                                intermediate.emplace_back(element);
+    return streams::Collector{[] { return std::optional<T>(); },
+                              [comp](std::optional<T> &best, auto &&element) {
+                                if (!best.has_value() || comp(element, best.value())) {
+                                  best = std::forward<decltype(element)>(element);
+                                }
                               },
-                              [&](std::vector<T> &intermediate) -> std::optional<T> {
-                                auto iterator = std::min_element(intermediate.begin(), intermediate.end(), comp);
-                                return iterator != intermediate.end() ? std::optional<T>(*iterator) : std::nullopt;
-                              }};
+                              [](std::optional<T> &best) -> std::optional<T> {
+                                return std::move(best);
+                              },
+                              [comp](std::optional<T> &best, std::optional<T> &other) {
+                                if (other.has_value() && (!best.has_value() || comp(other.value(), best.value()))) {
+                                  best = std::move(other);
+                                }
+                              },
+                              IDENTITY_FINISH};
   }
 
   /**
@@ -395,56 +982,87 @@ struct Collectors final {
    */
   template<typename T, typename Predicate>
   static auto partitioningBy(Predicate &&predicate) {
-    return streams::Collector{[] { return std::vector<T>(); },
-                              [](std::vector<T> &intermediate, const auto &element) {
-                                intermediate.emplace_back(element);
-                              },
-                              [predicate](std::vector<T> &intermediate) {
-                                std::unordered_map<bool, std::vector<T>> result;
-                                for (auto &item : intermediate) {
-                                  result.try_emplace(predicate(item), std::vector<T>());
-                                  result[predicate(item)].emplace_back(item);
-                                }
-                                return result;
-                              }};
+    using Partitions = std::unordered_map<bool, std::vector<T>>;
+    return streams::Collector{[] { return Partitions(); },
+                              [predicate](Partitions &partitions, auto &&element) {
+                                partitions[predicate(element)].emplace_back(std::forward<decltype(element)>(element));
+                              },
+                              [](Partitions &partitions) {
+                                return std::move(partitions);
+                              },
+                              [](Partitions &partitions, Partitions &other) {
+                                mergeGroups(partitions, other);
+                              },
+                              IDENTITY_FINISH};
   }
 
   /**
-   * \fn auto partitioningBy(Predicate &&predicate, Collector<Supplier, Accumulator, Finisher> &&downstream)
-   * \brief Returns a Collector which partitions the input elements according to a Predicate, reduces the values in each partition according to another Collector, and organizes them into a UnorderedMap<Boolean, D> whose values are the result of the downstream reduction.
+   * \fn auto partitioningBy(Predicate &&predicate, Collector<Supplier, Accumulator, Finisher, Combiner> &&downstream)
+   * \brief Returns a Collector which partitions the input elements according to a Predicate, reduces the values in each partition according to another Collector, and organizes them into a UnorderedMap<Boolean, D> whose values are the result of the downstream reduction. Each partition accumulates into its own downstream result container as the elements arrive.
    * There are no guarantees on the type, mutability, serializability, or thread-safety of the Map returned.
    * @tparam T type of input elements
    * @tparam Predicate type of predicate function used for classifying input elements
    * @tparam Supplier type of Supplier function of downstream collector
    * @tparam Accumulator type of Accumulator function of downstream collector
    * @tparam Finisher type of Finisher function of downstream collector
+   * @tparam Combiner type of Combiner function of downstream collector
    * @param predicate
    * @param downstream
    * @return a Collector implementing the cascaded partitioning operation
    */
-  template<typename T, typename Predicate, typename Supplier, typename Accumulator, typename Finisher>
-  static auto partitioningBy(Predicate &&predicate, Collector<Supplier, Accumulator, Finisher> &&downstream) {
-    return streams::Collector{[] { return std::vector<T>(); },
-                              [](std::vector<T> &intermediate, const auto &element) {
-                                intermediate.emplace_back(element);
-                              },
-                              [predicate, downstream](std::vector<T> &intermediate) {
-                                std::unordered_map<bool, std::vector<T>> iResult;
-                                for (auto &item : intermediate) {
-                                  iResult.try_emplace(predicate(item), std::vector<T>());
-                                  iResult[predicate(item)].emplace_back(item);
-                                }
-                                auto repr = (*iResult.begin()).second;
-                                using X = decltype(downstream.apply(repr));
+  template<typename T, typename Predicate, typename Supplier, typename Accumulator, typename Finisher, typename Combiner>
+  static auto partitioningBy(Predicate &&predicate, Collector<Supplier, Accumulator, Finisher, Combiner> &&downstream) {
+    using State = decltype(downstream.supply());
+    using X = decltype(downstream.finish(std::declval<State &>()));
+    using States = std::unordered_map<bool, State>;
+    return streams::Collector{[] { return States(); },
+                              [predicate, downstream](States &states, auto &&element) {
+                                accumulateState(states, static_cast<bool>(predicate(element)), downstream, std::forward<decltype(element)>(element));
+                              },
+                              [downstream](States &states) {
                                 std::unordered_map<bool, X> result;
-                                for (std::pair<const bool, std::vector<T>> &item : iResult) {
-                                  result.insert(std::pair<bool, X>{item.first, downstream.apply(item.second)});
+                                for (auto &[key, state] : states) {
+                                  result.emplace(key, downstream.finish(state));
                                 }
                                 return result;
-                              }};
+                              },
+                              [downstream](auto &states, auto &other) {
+                                combineStates(states, other, downstream);
+                              },
+                              downstream.characteristics() & UNORDERED};
+  }
+  /**
+   * \fn auto partitioningByFlat(Predicate &&predicate)
+   * \brief Returns a Collector which partitions the input elements according to a Predicate like partitioningBy, organizing them into a collection::SFlatMap<bool, std::vector<T>>.
+   * @tparam T type of input element
+   * @tparam Predicate type of predicate used for classifying input elements
+   * @param predicate
+   * @return a Collector implementing the partitioning operation
+   */
+  template<typename T, typename Predicate>
+  static auto partitioningByFlat(Predicate &&predicate) {
+    return groupingByFlat<T>([predicate](const T &element) { return static_cast<bool>(predicate(element)); }, 2);
   }
+
   /**
-   * \fn auto mapping(Mapper &&mapper, Collector<Supplier, Accumulator, Finisher> &&downstream)
+   * \fn auto partitioningByFlat(Predicate &&predicate, Collector<Supplier, Accumulator, Finisher, Combiner> &&downstream)
+   * \brief Returns a Collector which partitions the input elements according to a Predicate like partitioningBy, reduces the values in each partition according to another Collector, and organizes them into a collection::SFlatMap<bool, D>.
+   * @tparam T type of input elements
+   * @tparam Predicate type of predicate function used for classifying input elements
+   * @tparam Supplier type of Supplier function of downstream collector
+   * @tparam Accumulator type of Accumulator function of downstream collector
+   * @tparam Finisher type of Finisher function of downstream collector
+   * @tparam Combiner type of Combiner function of downstream collector
+   * @param predicate
+   * @param downstream
+   * @return a Collector implementing the cascaded partitioning operation
+   */
+  template<typename T, typename Predicate, typename Supplier, typename Accumulator, typename Finisher, typename Combiner>
+  static auto partitioningByFlat(Predicate &&predicate, Collector<Supplier, Accumulator, Finisher, Combiner> &&downstream) {
+    return groupingByFlat<T>([predicate](const T &element) { return static_cast<bool>(predicate(element)); }, std::move(downstream), 2);
+  }
+  /**
+   * \fn auto mapping(Mapper &&mapper, Collector<Supplier, Accumulator, Finisher, Combiner> &&downstream)
    * \brief Adapts a downstream collector accepting elements of say type U to one accepting elements of input element by applying a mapping function to each input element before accumulation.
    * std::map<City, std::set<std::string>> lastNamesByCity = people.stream().collect(groupingByOrdered<Person>([](auto person){return person.city;},
    *                                  mapping([](auto person){return person.city;}, toSet<std::string>())));
@@ -453,17 +1071,20 @@ struct Collectors final {
    * @tparam Supplier type of supplier function to be applied to downstream collector
    * @tparam Accumulator type of accumulator function to be applied to downstream collector
    * @tparam Finisher type of finisher function to be applied to downstream collector
+   * @tparam Combiner type of combiner function to be applied to downstream collector
    * @param mapper
    * @param downstream
    * @return a collector which applies the mapping function to the input elements and provides the mapped results to the downstream collector
    */
-  template<typename Mapper, typename Supplier, typename Accumulator, typename Finisher>
-  static auto mapping(Mapper &&mapper, Collector<Supplier, Accumulator, Finisher> &&downstream) {
+  template<typename Mapper, typename Supplier, typename Accumulator, typename Finisher, typename Combiner>
+  static auto mapping(Mapper &&mapper, Collector<Supplier, Accumulator, Finisher, Combiner> &&downstream) {
     return streams::Collector{downstream.supplier(),
-                              [mapper, downstream](decltype(downstream.supplier()()) &intermediate, auto element) {
-                                downstream.accumulator()(intermediate, mapper(element));
+                              [mapper, downstream](decltype(downstream.supplier()()) &intermediate, auto &&element) {
+                                downstream.accumulate(intermediate, mapper(std::forward<decltype(element)>(element)));
                               },
-                              downstream.finisher()};
+                              downstream.finisher(),
+                              downstream.combiner(),
+                              downstream.characteristics()};
   }
 
   /**
@@ -475,12 +1096,16 @@ struct Collectors final {
   template<typename T>
   static auto toVector() {
     return streams::Collector{[] { return std::vector<T>(); },
-                              [](std::vector<T> &intermediate, const auto &element) {
-                                intermediate.emplace_back(element);
+                              [](std::vector<T> &intermediate, auto &&element) {
+                                intermediate.emplace_back(std::forward<decltype(element)>(element));
                               },
                               [](std::vector<T> &intermediate) {
-                                return intermediate;
-                              }};
+                                return std::move(intermediate);
+                              },
+                              [](std::vector<T> &intermediate, std::vector<T> &other) {
+                                append(intermediate, other);
+                              },
+                              IDENTITY_FINISH};
   }
 
   /**
@@ -497,12 +1122,16 @@ struct Collectors final {
            typename Allocator = std::allocator<T>>
   static auto toSet(Compare cmp = Compare(), Allocator allocator = Allocator()) {
     return streams::Collector{[cmp, allocator] { return std::set<T, Compare, Allocator>(cmp, allocator); },
-                              [](std::set<T, Compare, Allocator> &intermediate, const auto &element) {
-                                intermediate.emplace(element);
+                              [](std::set<T, Compare, Allocator> &intermediate, auto &&element) {
+                                intermediate.emplace(std::forward<decltype(element)>(element));
                               },
                               [](std::set<T, Compare, Allocator> &intermediate) {
-                                return intermediate;
-                              }};
+                                return std::move(intermediate);
+                              },
+                              [](std::set<T, Compare, Allocator> &intermediate, std::set<T, Compare, Allocator> &other) {
+                                intermediate.merge(other);
+                              },
+                              UNORDERED | IDENTITY_FINISH};
   }
 
   /**
@@ -514,18 +1143,25 @@ struct Collectors final {
    */
   template<typename Container>
   static auto toContainer(Container &&container) {
-    return streams::Collector{[&container] { return container; },
-                              [](Container &intermediate, const auto &element) {
-                                intermediate.insert(intermediate.end(), element);
+    using Result = std::decay_t<Container>;
+    return streams::Collector{[container = Result(std::forward<Container>(container))] { return container; },
+                              [](Result &intermediate, auto &&element) {
+                                intermediate.insert(intermediate.end(), std::forward<decltype(element)>(element));
                               },
-                              [](Container &intermediate) {
-                                return intermediate;
-                              }};
+                              [](Result &intermediate) {
+                                return std::move(intermediate);
+                              },
+                              [](Result &intermediate, Result &other) {
+                                for (auto &element : other) {
+                                  intermediate.insert(intermediate.end(), std::move(element));
+                                }
+                              },
+                              IDENTITY_FINISH};
   }
 
   /**
    * \fn auto toMap(KeyMapper &&keyMapper, ValueMapper &&valueMapper)
-   * \brief Returns a Collector that accumulates elements into a Map whose keys and values are the result of applying the provided mapping functions to the input elements. If map has duplicates use toMap(KeyMapper &&keyMapper, ValueMapper &&valueMapper, MergeFunction &&mergeFunction)
+   * \brief Returns a Collector that accumulates elements into a Map whose keys and values are the result of applying the provided mapping functions to the input elements, the last value of a duplicated key is kept. To combine values of duplicated keys use toMap(KeyMapper &&keyMapper, ValueMapper &&valueMapper, MergeFunction &&mergeFunction)
    * @tparam T type of input elements
    * @tparam KeyMapper type of the key mapping function
    * @tparam ValueMapper type of the value mapping function
@@ -535,25 +1171,14 @@ struct Collectors final {
    */
   template<typename T, typename KeyMapper, typename ValueMapper>
   static auto toMap(KeyMapper &&keyMapper, ValueMapper &&valueMapper) {
-    return streams::Collector{[] { return std::vector<T>(); },
-                              [](std::vector<T> &intermediate, const auto &element) {
-                                intermediate.emplace_back(element);
-                              },
-                              [keyMapper, valueMapper](std::vector<T> &intermediate) {
-                                using K = typename std::invoke_result<KeyMapper, T>::type;
-                                using V = typename std::invoke_result<ValueMapper, T>::type;
-
-                                std::map<K, V, std::less<K>, std::allocator<std::pair<const K, V>>> result;
-                                for (const T &item : intermediate) {
-                                  result[keyMapper(item)] = valueMapper(item);
-                                }
-                                return result;
-                              }};
+    using K = typename std::invoke_result<KeyMapper, T>::type;
+    using V = typename std::invoke_result<ValueMapper, T>::type;
+    return collectToMap<T>([] { return std::map<K, V>(); }, keyMapper, valueMapper);
   }
 
   /**
    * \fn auto toMap(KeyMapper &&keyMapper, ValueMapper &&valueMapper, MergeFunction &&mergeFunction)
-   * \brief Returns a Collector that accumulates elements into a Map whose keys and values are the result of applying the provided mapping functions to the input elements.
+   * \brief Returns a Collector that accumulates elements into a Map whose keys and values are the result of applying the provided mapping functions to the input elements. The value of a duplicated key is merged into the stored value as the element arrives, the first value of a key is stored as is.
    * @tparam T type of input element
    * @tparam KeyMapper type of the key mapping function
    * @tparam ValueMapper type of the value mapping function
@@ -565,27 +1190,85 @@ struct Collectors final {
    */
   template<typename T, typename KeyMapper, typename ValueMapper, typename MergeFunction>
   static auto toMap(KeyMapper &&keyMapper, ValueMapper &&valueMapper, MergeFunction &&mergeFunction) {
-    return streams::Collector{[] { return std::vector<T>(); },
-                              [](std::vector<T> &intermediate, const auto &element) {
-                                intermediate.emplace_back(element);
-                              },
-                              [keyMapper, valueMapper, mergeFunction](std::vector<T> &intermediate) {
-                                using K = typename std::invoke_result<KeyMapper, T>::type;
-                                using V = typename std::invoke_result<ValueMapper, T>::type;
+    using K = typename std::invoke_result<KeyMapper, T>::type;
+    using V = typename std::invoke_result<ValueMapper, T>::type;
+    return collectToMap<T>([] { return std::map<K, V>(); }, keyMapper, valueMapper, mergeFunction);
+  }
 
-                                std::map<K, std::vector<V>> iResult;
-                                for (const T &item : intermediate) {
-                                  iResult.try_emplace(keyMapper(item), std::vector<V>());
-                                  iResult[keyMapper(item)].emplace_back(valueMapper(item));
-                                }
+  /**
+   * \fn auto toUnorderedMap(KeyMapper &&keyMapper, ValueMapper &&valueMapper, size_t expectedKeys = 0)
+   * \brief Returns a Collector that accumulates elements into a std::unordered_map whose keys and values are the result of applying the provided mapping functions to the input elements, the last value of a duplicated key is kept.
+   * @tparam T type of input elements
+   * @tparam KeyMapper type of the key mapping function
+   * @tparam ValueMapper type of the value mapping function
+   * @param keyMapper
+   * @param valueMapper
+   * @param expectedKeys number of distinct keys to reserve room for
+   * @return a Collector which collects elements into an unordered map whose keys and values are the result of applying mapping functions to the input elements
+   */
+  template<typename T, typename KeyMapper, typename ValueMapper>
+  static auto toUnorderedMap(KeyMapper &&keyMapper, ValueMapper &&valueMapper, size_t expectedKeys = 0) {
+    using K = typename std::invoke_result<KeyMapper, T>::type;
+    using V = typename std::invoke_result<ValueMapper, T>::type;
+    return collectToMap<T>([expectedKeys] { return reserved<std::unordered_map<K, V>>(expectedKeys); }, keyMapper, valueMapper);
+  }
 
-                                std::map<K, V> result;
-                                for (const auto &item : iResult) {
-                                  result[item.first] = std::reduce(item.second.begin(), item.second.end(), V{}, mergeFunction);
-                                }
+  /**
+   * \fn auto toUnorderedMap(KeyMapper &&keyMapper, ValueMapper &&valueMapper, MergeFunction &&mergeFunction, size_t expectedKeys = 0)
+   * \brief Returns a Collector that accumulates elements into a std::unordered_map whose keys and values are the result of applying the provided mapping functions to the input elements. The value of a duplicated key is merged into the stored value as the element arrives, the first value of a key is stored as is.
+   * @tparam T type of input element
+   * @tparam KeyMapper type of the key mapping function
+   * @tparam ValueMapper type of the value mapping function
+   * @tparam MergeFunction type of merge function, used to resolve collisions between values associated with the same key
+   * @param keyMapper
+   * @param valueMapper
+   * @param mergeFunction
+   * @param expectedKeys number of distinct keys to reserve room for
+   * @return a Collector which collects elements into an unordered map whose values are the values of each key combined using the merge function
+   */
+  template<typename T, typename KeyMapper, typename ValueMapper, typename MergeFunction, typename = std::enable_if_t<!std::is_integral_v<std::decay_t<MergeFunction>>>>
+  static auto toUnorderedMap(KeyMapper &&keyMapper, ValueMapper &&valueMapper, MergeFunction &&mergeFunction, size_t expectedKeys = 0) {
+    using K = typename std::invoke_result<KeyMapper, T>::type;
+    using V = typename std::invoke_result<ValueMapper, T>::type;
+    return collectToMap<T>([expectedKeys] { return reserved<std::unordered_map<K, V>>(expectedKeys); }, keyMapper, valueMapper, mergeFunction);
+  }
 
-                                return result;
-                              }};
+  /**
+   * \fn auto toFlatMap(KeyMapper &&keyMapper, ValueMapper &&valueMapper, size_t expectedKeys = 0)
+   * \brief Returns a Collector that accumulates elements into a collection::SFlatMap whose keys and values are the result of applying the provided mapping functions to the input elements, the last value of a duplicated key is kept.
+   * @tparam T type of input elements
+   * @tparam KeyMapper type of the key mapping function
+   * @tparam ValueMapper type of the value mapping function
+   * @param keyMapper
+   * @param valueMapper
+   * @param expectedKeys number of distinct keys to reserve room for
+   * @return a Collector which collects elements into a flat map whose keys and values are the result of applying mapping functions to the input elements
+   */
+  template<typename T, typename KeyMapper, typename ValueMapper>
+  static auto toFlatMap(KeyMapper &&keyMapper, ValueMapper &&valueMapper, size_t expectedKeys = 0) {
+    using K = typename std::invoke_result<KeyMapper, T>::type;
+    using V = typename std::invoke_result<ValueMapper, T>::type;
+    return collectToMap<T>([expectedKeys] { return collection::SFlatMap<K, V>(expectedKeys); }, keyMapper, valueMapper);
+  }
+
+  /**
+   * \fn auto toFlatMap(KeyMapper &&keyMapper, ValueMapper &&valueMapper, MergeFunction &&mergeFunction, size_t expectedKeys = 0)
+   * \brief Returns a Collector that accumulates elements into a collection::SFlatMap whose keys and values are the result of applying the provided mapping functions to the input elements. The value of a duplicated key is merged into the stored value as the element arrives, the first value of a key is stored as is.
+   * @tparam T type of input element
+   * @tparam KeyMapper type of the key mapping function
+   * @tparam ValueMapper type of the value mapping function
+   * @tparam MergeFunction type of merge function, used to resolve collisions between values associated with the same key
+   * @param keyMapper
+   * @param valueMapper
+   * @param mergeFunction
+   * @param expectedKeys number of distinct keys to reserve room for
+   * @return a Collector which collects elements into a flat map whose values are the values of each key combined using the merge function
+   */
+  template<typename T, typename KeyMapper, typename ValueMapper, typename MergeFunction, typename = std::enable_if_t<!std::is_integral_v<std::decay_t<MergeFunction>>>>
+  static auto toFlatMap(KeyMapper &&keyMapper, ValueMapper &&valueMapper, MergeFunction &&mergeFunction, size_t expectedKeys = 0) {
+    using K = typename std::invoke_result<KeyMapper, T>::type;
+    using V = typename std::invoke_result<ValueMapper, T>::type;
+    return collectToMap<T>([expectedKeys] { return collection::SFlatMap<K, V>(expectedKeys); }, keyMapper, valueMapper, mergeFunction);
   }
 
   /**
@@ -598,26 +1281,172 @@ struct Collectors final {
    */
   template<typename T, typename BinaryOp>
   static auto reducing(BinaryOp &&binaryOp) {
-    return streams::Collector{
-        [] { return std::vector<T>(); },
-        [](std::vector<T> &intermediate, const auto &element) {
-          intermediate.emplace_back(element);
-        },
-        [&binaryOp](std::vector<T> &intermediate) {
-          return std::reduce(intermediate.begin(), intermediate.end(), T{}, binaryOp);
-        }};
+    return reducing<T>(T{}, std::forward<BinaryOp>(binaryOp));
   }
 
+  /**
+   * \fn auto reducing(T identity, BinaryOp &&binaryOp)
+   * \brief Returns a Collector which performs a reduction of its input elements under a specified BinaryOperator using the provided identity. Partial results are combined with the same operator, so identity must be an identity of binaryOp for combined results to match sequential ones.
+   * @tparam T type of input element
+   * @tparam BinaryOp type a BinaryOperator<T> used to reduce the input elements
+   * @param identity the initial value of the reduction
+   * @param binaryOp
+   * @return
+   */
   template<typename T, typename BinaryOp>
   static auto reducing(T identity, BinaryOp &&binaryOp) {
     return streams::Collector{
-        [] { return std::vector<T>(); },
-        [](std::vector<T> &intermediate, const auto &element) {
-          intermediate.emplace_back(element);
+        [identity] { return identity; },
+        [binaryOp](T &reduced, auto &&element) {
+          reduced = binaryOp(std::move(reduced), std::forward<decltype(element)>(element));
         },
-        [&identity, &binaryOp](std::vector<T> &intermediate) {
-          return std::reduce(intermediate.begin(), intermediate.end(), identity, binaryOp);
-        }};
+        [](T &reduced) {
+          return std::move(reduced);
+        },
+        [binaryOp](T &reduced, T &other) {
+          reduced = binaryOp(std::move(reduced), std::move(other));
+        },
+        IDENTITY_FINISH};
+  }
+
+ private:
+  template<typename Container>
+  static void append(Container &container, Container &other) {
+    container.insert(container.end(), std::make_move_iterator(other.begin()), std::make_move_iterator(other.end()));
+  }
+
+  template<typename Merger, typename Arguments, size_t... I>
+  static auto tee(Merger &&merger, Arguments &arguments, std::index_sequence<I...> /*indices*/) {
+    auto collectors = std::make_tuple(std::get<I>(arguments)...);
+    using Collectors = decltype(collectors);
+    using State = std::tuple<decltype(std::get<I>(collectors).supply())...>;
+    auto supplier = [collectors] { return State(std::get<I>(collectors).supply()...); };
+    auto accumulator = [collectors](State &state, const auto &element) {
+      (std::get<I>(collectors).accumulate(std::get<I>(state), element), ...);
+    };
+    auto finisher = [collectors, merger](State &state) {
+      return merger(std::get<I>(collectors).finish(std::get<I>(state))...);
+    };
+    if constexpr ((std::tuple_element_t<I, Collectors>::combinable() && ...)) {
+      unsigned characteristics = UNORDERED;
+      ((characteristics &= std::get<I>(collectors).characteristics()), ...);
+      return streams::Collector{std::move(supplier),
+                                std::move(accumulator),
+                                std::move(finisher),
+                                [collectors](State &state, State &other) {
+                                  (std::get<I>(collectors).combine(std::get<I>(state), std::get<I>(other)), ...);
+                                },
+                                characteristics};
+    } else {
+      return streams::Collector{std::move(supplier), std::move(accumulator), std::move(finisher)};
+    }
+  }
+
+  template<typename T, typename Supplier, typename KeyMapper, typename ValueMapper>
+  static auto collectToMap(Supplier &&supplier, KeyMapper &keyMapper, ValueMapper &valueMapper) {
+    using Result = std::invoke_result_t<Supplier>;
+    return streams::Collector{std::forward<Supplier>(supplier),
+                              [keyMapper, valueMapper](Result &result, const T &element) {
+                                result.insert_or_assign(keyMapper(element), valueMapper(element));
+                              },
+                              [](Result &result) {
+                                return std::move(result);
+                              },
+                              [](Result &result, Result &other) {
+                                for (auto &[key, value] : other) {
+                                  result.insert_or_assign(key, std::move(value));
+                                }
+                              },
+                              IDENTITY_FINISH};
+  }
+
+  template<typename T, typename Supplier, typename KeyMapper, typename ValueMapper, typename MergeFunction>
+  static auto collectToMap(Supplier &&supplier, KeyMapper &keyMapper, ValueMapper &valueMapper, MergeFunction &mergeFunction) {
+    using Result = std::invoke_result_t<Supplier>;
+    return streams::Collector{std::forward<Supplier>(supplier),
+                              [keyMapper, valueMapper, mergeFunction](Result &result, const T &element) {
+                                mergeValue(result, keyMapper(element), valueMapper(element), mergeFunction);
+                              },
+                              [](Result &result) {
+                                return std::move(result);
+                              },
+                              [mergeFunction](Result &result, Result &other) {
+                                for (auto &[key, value] : other) {
+                                  mergeValue(result, key, std::move(value), mergeFunction);
+                                }
+                              },
+                              IDENTITY_FINISH};
+  }
+
+  template<typename Map>
+  static Map reserved(size_t expectedKeys) {
+    Map map;
+    map.reserve(expectedKeys);
+    return map;
+  }
+
+  template<typename Map, typename Key, typename Value, typename MergeFunction>
+  static void mergeValue(Map &map, Key &&key, Value &&value, const MergeFunction &mergeFunction) {
+    auto [position, inserted] = map.try_emplace(std::forward<Key>(key), std::forward<Value>(value));
+    if (!inserted) {
+      position->second = mergeFunction(position->second, std::forward<Value>(value));
+    }
+  }
+
+  template<typename T>
+  static auto sampling(size_t k, uint64_t seed, bool skipping) {
+    auto supplier = [k, seed, skipping] { return Reservoir<T>(k, seed, skipping); };
+    // the reservoir is built once here so that k == 0 is rejected before the stream runs
+    supplier();
+    return streams::Collector{std::move(supplier),
+                              [](Reservoir<T> &reservoir, auto &&element) {
+                                reservoir.add(std::forward<decltype(element)>(element));
+                              },
+                              [](Reservoir<T> &reservoir) {
+                                return std::move(reservoir).items();
+                              },
+                              [](Reservoir<T> &reservoir, Reservoir<T> &other) {
+                                reservoir.merge(other);
+                              },
+                              UNORDERED};
+  }
+
+  template<typename Key>
+  static size_t denseIndex(Key key, size_t size) {
+    auto index = static_cast<size_t>(key);
+    if (index >= size) {
+      throw std::out_of_range("groupingByDense key greater than maxKey");
+    }
+    return index;
+  }
+
+  template<typename States, typename Key, typename Downstream, typename E>
+  static void accumulateState(States &states, Key &&key, const Downstream &downstream, E &&element) {
+    auto position = states.find(key);
+    if (position == states.end()) {
+      position = states.emplace(std::forward<Key>(key), downstream.supply()).first;
+    }
+    downstream.accumulate(position->second, std::forward<E>(element));
+  }
+
+  template<typename States, typename Downstream>
+  static void combineStates(States &states, States &other, const Downstream &downstream) {
+    for (auto &[key, state] : other) {
+      auto [position, inserted] = states.try_emplace(key, std::move(state));
+      if (!inserted) {
+        downstream.combine(position->second, state);
+      }
+    }
+  }
+
+  template<typename Groups>
+  static void mergeGroups(Groups &groups, Groups &other) {
+    for (auto &[key, values] : other) {
+      auto [position, inserted] = groups.try_emplace(key, std::move(values));
+      if (!inserted) {
+        append(position->second, values);
+      }
+    }
   }
 };
 }// namespace aalbatross::utils::streams
@@ -2,10 +2,15 @@
 #define INCLUDED_STREAMS4CPP_PROCESSOR_H_
 
 #include "collection/streamabledeque.h"
+#include "profile.h"
 
 #include <any>
+#include <deque>
 #include <iostream>
 #include <memory>
+#include <optional>
+#include <stdexcept>
+#include <utility>
 namespace aalbatross::utils::streams {
 /**
  * \class Processor
@@ -18,16 +23,56 @@ struct Processor {
     dListener_ = std::move(processor);
   }
 
+  /**
+   * \fn void process(T &&input)
+   * \brief Passes one element to this processor. An rvalue is moved into the type erased value and from there into the next processor, so an element is not copied from stage to stage.
+   * @tparam T type of element
+   * @param input element
+   */
   template<typename T>
-  void process(T input) {
-    processImpl(std::move(std::any(input)));
+  void process(T &&input) {
+#ifdef STREAMS4CPP_PROFILING
+    dProfile_.elementsIn++;
+    ProfileScope scope(dProfile_);
+#endif
+    std::any value(std::forward<T>(input));
+    processImpl(value);
   }
 
   virtual void reset() = 0;
 
+  /**
+   * \fn void flush()
+   * \brief Signals the end of the source. Processors holding a pending result emit it before passing the signal on to the next processor.
+   */
+  virtual void flush() {
+    if (dListener_) {
+      dListener_->flush();
+    }
+  }
+
+  /**
+   * \fn const char *name()
+   * \brief operator name of the processor, reported by UBStream::explain() and UBStream::profile().
+   * @return name of the processor
+   */
+  virtual const char *name() const { return "processor"; }
+
+#ifdef STREAMS4CPP_PROFILING
+  StageProfile &profile() { return dProfile_; }
+#endif
+
  protected:
   std::shared_ptr<Processor> dListener_;
-  virtual void processImpl(const std::any &value) = 0;
+#ifdef STREAMS4CPP_PROFILING
+  StageProfile dProfile_;
+#endif
+  /**
+   * \fn void processImpl(std::any &value)
+   * \brief Processes one element, value owns it so it may be moved out.
+   * @param value type erased element
+   */
+  virtual void processImpl(std::any &value) = 0;
 };
 /**
  * \class MapProcessor
@@ -42,14 +87,16 @@ struct MapProcessor : public Processor {
 
   ~MapProcessor() override = default;
 
+  const char *name() const override { return "map"; }
+
   void reset() override {}
 
  protected:
-  void processImpl(const std::any &value) override {
+  void processImpl(std::any &value) override {
     if (dListener_) {
       try {
-        const auto &input = std::any_cast<IN>(value);
-        dListener_->process(std::move(dMapper_(input)));
+        auto &input = std::any_cast<IN &>(value);
+        dListener_->process(dMapper_(std::move(input)));
       } catch (const std::bad_any_cast &e) {
         std::cout << e.what() << " Expected type:" << value.type().name() << '\n';
       }
@@ -73,15 +120,17 @@ struct FlatMapProcessor : public Processor {
 
   ~FlatMapProcessor() override = default;
 
+  const char *name() const override { return "flatten"; }
+
   void reset() override {}
 
  protected:
-  void processImpl(const std::any &value) override {
+  void processImpl(std::any &value) override {
     if (dListener_) {
       try {
-        const auto &input = std::any_cast<IN>(value);
-        for (const auto &element : input) {
-          dListener_->process(std::move(dMapper_(element)));
+        auto &input = std::any_cast<IN &>(value);
+        for (auto &element : input) {
+          dListener_->process(dMapper_(std::move(element)));
         }
       } catch (const std::bad_any_cast &e) {
         std::cout << e.what() << " Expected type:" << value.type().name() << '\n';
@@ -95,7 +144,7 @@ struct FlatMapProcessor : public Processor {
 
 /**
  * \class ConsumerProcessor
- * \brief Unbound stream processor derived from Processor, applies Consumer function to incoming streaming inputs.
+ * \brief Unbound stream processor derived from Processor, applies Consumer function to incoming streaming inputs. The consumer receives every element as an lvalue it owns, so it may move from it.
  * @tparam Mapper
  * @tparam IN
  */
@@ -107,11 +156,13 @@ struct ConsumerProcessor : public Processor {
 
   ~ConsumerProcessor() override = default;
 
+  const char *name() const override { return "forEach"; }
+
   void reset() override {}
 
  protected:
-  void processImpl(const std::any &value) override {
-    const auto &input = std::any_cast<IN>(value);
+  void processImpl(std::any &value) override {
+    auto &input = std::any_cast<IN &>(value);
     dConsumer_(input);
   }
 
@@ -131,15 +182,17 @@ struct FilterProcessor : public Processor {
 
   ~FilterProcessor() override = default;
 
+  const char *name() const override { return "filter"; }
+
   void reset() override {}
 
  protected:
-  void processImpl(const std::any &value) override {
+  void processImpl(std::any &value) override {
     if (dListener_) {
       try {
-        const auto &input = std::any_cast<IN>(value);
-        if (dPredicate_(input)) {
-          dListener_->process(input);
+        auto &input = std::any_cast<IN &>(value);
+        if (dPredicate_(std::as_const(input))) {
+          dListener_->process(std::move(input));
         }
       } catch (const std::bad_any_cast &e) {
         std::cout << e.what() << " Expected type:" << value.type().name() << '\n';
@@ -161,15 +214,17 @@ struct LimitProcessor : public Processor {
 
   ~LimitProcessor() override = default;
 
+  const char *name() const override { return "limit"; }
+
   void reset() override {
     dCount_ = 0;
   }
 
  protected:
-  void processImpl(const std::any &value) override {
+  void processImpl(std::any &value) override {
     if (dListener_) {
       try {
-        const auto &input = std::any_cast<IN>(value);
+        auto &input = std::any_cast<IN &>(value);
         if (dCount_ >= dLimit_) {
           return;
         }
@@ -198,17 +253,19 @@ struct SkipProcessor : public Processor {
 
   ~SkipProcessor() override = default;
 
+  const char *name() const override { return "skip"; }
+
   void reset() override {
     dCount_ = 0;
   }
 
  protected:
-  void processImpl(const std::any &value) override {
+  void processImpl(std::any &value) override {
     if (dListener_) {
       try {
-        const auto &input = std::any_cast<IN>(value);
+        auto &input = std::any_cast<IN &>(value);
         if (dCount_ >= dLimit_) {
-          dListener_->process(input);
+          dListener_->process(std::move(input));
         } else {
           dCount_++;
         }
@@ -233,15 +290,17 @@ struct SlidingWindowProcessor : public Processor {
 
   ~SlidingWindowProcessor() override = default;
 
+  const char *name() const override { return "sliding"; }
+
   void reset() override {
     dElements_.clear();
   }
 
  protected:
-  void processImpl(const std::any &value) override {
+  void processImpl(std::any &value) override {
     if (dListener_) {
       try {
-        const auto &input = std::any_cast<IN>(value);
+        auto &input = std::any_cast<IN &>(value);
         dElements_.emplace_back(std::move(input));
         if (dElements_.size() == dWindowSize_) {
           dListener_->process(dElements_);
@@ -269,15 +328,17 @@ struct FixedWindowProcessor : public Processor {
 
   ~FixedWindowProcessor() override = default;
 
+  const char *name() const override { return "fixed"; }
+
   void reset() override {
     dElements_.clear();
   }
 
  protected:
-  void processImpl(const std::any &value) override {
+  void processImpl(std::any &value) override {
     if (dListener_) {
       try {
-        const auto &input = std::any_cast<IN>(value);
+        auto &input = std::any_cast<IN &>(value);
         dElements_.emplace_back(std::move(input));
         if (dElements_.size() == dWindowSize_) {
           dListener_->process(dElements_);
@@ -295,5 +356,188 @@ struct FixedWindowProcessor : public Processor {
   size_t dWindowSize_;
 };
 
+/**
+ * \class RunningProcessor
+ * \brief Unbound stream processor derived from Processor, accumulates incoming streaming inputs with a Collector and emits the result of the elements seen so far every given number of elements.
+ * @tparam Collector
+ * @tparam IN
+ */
+template<typename Collector, typename IN>
+struct RunningProcessor : public Processor {
+  RunningProcessor(Collector collector, size_t every) : dCollector_(std::move(collector)), dEvery_(every), dState_(dCollector_.supply()) {}
+
+  ~RunningProcessor() override = default;
+
+  const char *name() const override { return "running"; }
+
+  void reset() override {
+    dState_.emplace(dCollector_.supply());
+    dCount_ = 0;
+  }
+
+ protected:
+  void processImpl(std::any &value) override {
+    if (dListener_) {
+      try {
+        auto &input = std::any_cast<IN &>(value);
+        dCollector_.accumulate(*dState_, std::move(input));
+        if (++dCount_ % dEvery_ == 0) {
+          // finishers may move out of the result container, finish a copy to keep accumulating
+          auto state = *dState_;
+          dListener_->process(dCollector_.finish(state));
+        }
+      } catch (const std::bad_any_cast &e) {
+        std::cout << e.what() << " Expected type:" << value.type().name() << '\n';
+      }
+    }
+  }
+
+ private:
+  Collector dCollector_;
+  size_t dEvery_;
+  size_t dCount_ = 0;
+  std::optional<decltype(std::declval<Collector &>().supply())> dState_;
+};
+
+/**
+ * \class WindowCollectProcessor
+ * \brief Unbound stream processor derived from Processor, collects windows of incoming streaming inputs without buffering them. Every step elements are accumulated into a pane with a Collector, and the panes of the last window are combined and finished when a pane completes.
+ * @tparam Collector
+ * @tparam IN
+ */
+template<typename Collector, typename IN>
+struct WindowCollectProcessor : public Processor {
+  WindowCollectProcessor(Collector collector, size_t windowSize, size_t step) : dCollector_(std::move(collector)), dPanesPerWindow_(windowSize / step), dStep_(step), dCurrent_(dCollector_.supply()) {}
+
+  ~WindowCollectProcessor() override = default;
+
+  const char *name() const override { return dPanesPerWindow_ == 1 ? "fixed" : "sliding"; }
+
+  void reset() override {
+    dCurrent_.emplace(dCollector_.supply());
+    dPanes_.clear();
+    dCount_ = 0;
+  }
+
+ protected:
+  void processImpl(std::any &value) override {
+    if (dListener_) {
+      try {
+        auto &input = std::any_cast<IN &>(value);
+        dCollector_.accumulate(*dCurrent_, std::move(input));
+        if (++dCount_ < dStep_) {
+          return;
+        }
+        dCount_ = 0;
+        if constexpr (Collector::combinable()) {
+          if (dPanesPerWindow_ > 1) {
+            dPanes_.emplace_back(std::move(*dCurrent_));
+            dCurrent_.emplace(dCollector_.supply());
+            if (dPanes_.size() > dPanesPerWindow_) {
+              dPanes_.pop_front();
+            }
+            if (dPanes_.size() == dPanesPerWindow_) {
+              // combiners may move out of the merged pane, combine copies to keep the panes of the next windows
+              auto window = dCollector_.supply();
+              for (const auto &pane : dPanes_) {
+                auto copy = pane;
+                dCollector_.combine(window, copy);
+              }
+              dListener_->process(dCollector_.finish(window));
+            }
+            return;
+          }
+        }
+        dListener_->process(dCollector_.finish(*dCurrent_));
+        dCurrent_.emplace(dCollector_.supply());
+      } catch (const std::bad_any_cast &e) {
+        std::cout << e.what() << " Expected type:" << value.type().name() << '\n';
+      }
+    }
+  }
+
+ private:
+  using State = decltype(std::declval<Collector &>().supply());
+
+  Collector dCollector_;
+  size_t dPanesPerWindow_;
+  size_t dStep_;
+  size_t dCount_ = 0;
+  std::optional<State> dCurrent_;
+  std::deque<State> dPanes_;
+};
+
+/**
+ * \class SortedGroupProcessor
+ * \brief Unbound stream processor derived from Processor, collects runs of incoming streaming inputs with equal keys and emits the key and the result of the Collector for a run as soon as the key changes, and for the last run when the source ends.
+ *
+ * Only the run being collected is held. A key ordered before the previous key throws std::invalid_argument when validate is set, otherwise it starts a new run.
+ * @tparam Collector
+ * @tparam Classifier
+ * @tparam IN
+ * @tparam K
+ * @tparam Compare
+ */
+template<typename Collector, typename Classifier, typename IN, typename K, typename Compare>
+struct SortedGroupProcessor : public Processor {
+  SortedGroupProcessor(Collector collector, Classifier classifier, Compare cmp, bool validate) : dCollector_(std::move(collector)), dClassifier_(std::move(classifier)), dCmp_(std::move(cmp)), dValidate_(validate) {}
+
+  ~SortedGroupProcessor() override = default;
+
+  const char *name() const override { return "groupingBySorted"; }
+
+  void reset() override {
+    dKey_.reset();
+    dState_.reset();
+  }
+
+  void flush() override {
+    emit();
+    Processor::flush();
+  }
+
+ protected:
+  void processImpl(std::any &value) override {
+    if (dListener_) {
+      try {
+        auto &input = std::any_cast<IN &>(value);
+        K key = dClassifier_(std::as_const(input));
+        if (dKey_ && (dCmp_(key, *dKey_) || dCmp_(*dKey_, key))) {
+          if (dValidate_ && dCmp_(key, *dKey_)) {
+            throw std::invalid_argument("groupingBySorted input is not sorted by key");
+          }
+          emit();
+        }
+        if (!dKey_) {
+          dKey_.emplace(std::move(key));
+          dState_.emplace(dCollector_.supply());
+        }
+        dCollector_.accumulate(*dState_, std::move(input));
+      } catch (const std::bad_any_cast &e) {
+        std::cout << e.what() << " Expected type:" << value.type().name() << '\n';
+      }
+    }
+  }
+
+ private:
+  using State = decltype(std::declval<Collector &>().supply());
+  using Result = decltype(std::declval<Collector &>().finish(std::declval<State &>()));
+
+  void emit() {
+    if (dKey_ && dListener_) {
+      dListener_->process(std::pair<K, Result>(std::move(*dKey_), dCollector_.finish(*dState_)));
+    }
+    dKey_.reset();
+    dState_.reset();
+  }
+
+  Collector dCollector_;
+  Classifier dClassifier_;
+  Compare dCmp_;
+  bool dValidate_;
+  std::optional<K> dKey_;
+  std::optional<State> dState_;
+};
+
 }// namespace aalbatross::utils::streams
 #endif//INCLUDED_STREAMS4CPP_PROCESSOR_H_
@@ -0,0 +1,233 @@
+#ifndef INCLUDED_STREAMS4CPP_PROFILE_H_
+#define INCLUDED_STREAMS4CPP_PROFILE_H_
+#include "aalbatross/utils/iterators/iterator.h"
+
+#include <atomic>
+#include <chrono>
+#include <ctime>
+#include <iomanip>
+#include <memory>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace aalbatross::utils::streams {
+/**
+ * \class StageProfile
+ * \brief Statistics of one stage of a stream pipeline.
+ *
+ * Wall time and allocated bytes are exclusive to the stage, they do not include the time spent in the other stages of the pipeline.
+ * Cpu time is read once per run and split between stages in proportion to their wall time.
+ * Adaptive stages also report the algorithm they chose and the number of distinct keys estimated from their sample, see StrategyChoice.
+ */
+struct StageProfile {
+  std::string name;
+  size_t elementsIn = 0;
+  size_t elementsOut = 0;
+  std::chrono::nanoseconds wallTime{0};
+  std::chrono::nanoseconds cpuTime{0};
+  size_t bytesAllocated = 0;
+  std::string strategy{};
+  size_t estimatedDistinct = 0;
+};
+
+/**
+ * \class PipelineProfile
+ * \brief Report of a stream pipeline returned by explain() and profile(), stages are listed from the source to the last stage.
+ */
+struct PipelineProfile {
+  std::vector<StageProfile> stages;
+
+  /**
+   * \fn std::string toString()
+   * \brief Formats the report as a table with one row per stage.
+   * @return table of stages
+   */
+  std::string toString() const {
+    std::stringstream sstream;
+    sstream << std::left << std::setw(4) << "#" << std::setw(12) << "stage" << std::right
+            << std::setw(12) << "in" << std::setw(12) << "out"
+            << std::setw(14) << "wall(us)" << std::setw(14) << "cpu(us)" << std::setw(14) << "alloc(B)" << std::setw(10) << "strategy" << '\n';
+    for (size_t i = 0; i < stages.size(); i++) {
+      const auto &stage = stages[i];
+      sstream << std::left << std::setw(4) << i << std::setw(12) << stage.name << std::right
+              << std::setw(12) << stage.elementsIn << std::setw(12) << stage.elementsOut
+              << std::setw(14) << std::chrono::duration_cast<std::chrono::microseconds>(stage.wallTime).count()
+              << std::setw(14) << std::chrono::duration_cast<std::chrono::microseconds>(stage.cpuTime).count()
+              << std::setw(14) << stage.bytesAllocated << std::setw(10) << stage.strategy << '\n';
+    }
+    return sstream.str();
+  }
+
+  /**
+   * \fn void apportionCpuTime(std::chrono::nanoseconds cpuTime)
+   * \brief Splits the cpu time of a run between the stages in proportion to their exclusive wall time.
+   * @param cpuTime cpu time of the whole run
+   */
+  void apportionCpuTime(std::chrono::nanoseconds cpuTime) {
+    std::chrono::nanoseconds wallTime{0};
+    for (const auto &stage : stages) {
+      wallTime += stage.wallTime;
+    }
+    if (wallTime.count() == 0) {
+      return;
+    }
+    for (auto &stage : stages) {
+      stage.cpuTime = std::chrono::nanoseconds(static_cast<long long>(static_cast<double>(cpuTime.count()) * stage.wallTime.count() / wallTime.count()));
+    }
+  }
+
+  friend std::ostream &operator<<(std::ostream &ost, const PipelineProfile &profile) {
+    return ost << profile.toString();
+  }
+};
+
+/**
+ * \class Profiler
+ * \brief Hooks of the opt-in pipeline instrumentation.
+ *
+ * Instrumentation is compiled in only when STREAMS4CPP_PROFILING is defined (cmake option STREAMS4CPP_PROFILING), otherwise stages are not wrapped and no statistic is recorded.
+ * The library does not replace the global allocator, to account allocated bytes per stage call Profiler::recordAllocation from your own operator new.
+ */
+struct Profiler final {
+  /**
+   * \fn void recordAllocation(size_t bytes)
+   * \brief Records an allocation, call it from a replaced operator new to account bytes allocated by stages.
+   * @param bytes size of the allocation
+   */
+  static void recordAllocation(size_t bytes) {
+    allocatedBytes().fetch_add(bytes, std::memory_order_relaxed);
+  }
+
+  /**
+   * \fn std::atomic<size_t> &allocatedBytes()
+   * \brief Total bytes recorded by recordAllocation.
+   * @return allocation counter
+   */
+  static std::atomic<size_t> &allocatedBytes() {
+    static std::atomic<size_t> bytes{0};
+    return bytes;
+  }
+
+  /**
+   * \fn bool enabled()
+   * \brief Whether the instrumentation is compiled in.
+   * @return true when STREAMS4CPP_PROFILING is defined
+   */
+  static constexpr bool enabled() {
+#ifdef STREAMS4CPP_PROFILING
+    return true;
+#else
+    return false;
+#endif
+  }
+};
+
+/**
+ * \class ProfileScope
+ * \brief Makes a StageProfile the running stage of the calling thread for its scope.
+ *
+ * Wall time and allocated bytes are charged to the running stage only: entering a nested scope pauses the enclosing stage until the nested scope exits, so every stage records its exclusive values.
+ * Only the monotonic clock is read, once on entry and once on exit; cpu time is read once per run, see PipelineProfile::apportionCpuTime.
+ */
+struct ProfileScope final {
+  explicit ProfileScope(StageProfile &profile) : dParent_(running().stage) {
+    switchTo(&profile);
+  }
+
+  ProfileScope(const ProfileScope &) = delete;
+  ProfileScope &operator=(const ProfileScope &) = delete;
+
+  ~ProfileScope() {
+    switchTo(dParent_);
+  }
+
+ private:
+  struct Running {
+    StageProfile *stage = nullptr;
+    std::chrono::steady_clock::time_point since;
+    size_t bytesSince = 0;
+  };
+
+  static Running &running() {
+    thread_local Running current;
+    return current;
+  }
+
+  static void switchTo(StageProfile *stage) {
+    auto &current = running();
+    auto now = std::chrono::steady_clock::now();
+    size_t bytes = Profiler::allocatedBytes().load(std::memory_order_relaxed);
+    if (current.stage) {
+      current.stage->wallTime += std::chrono::duration_cast<std::chrono::nanoseconds>(now - current.since);
+      current.stage->bytesAllocated += bytes - current.bytesSince;
+    }
+    current.stage = stage;
+    current.since = now;
+    current.bytesSince = bytes;
+  }
+
+  StageProfile *dParent_;
+};
+
+/**
+ * \class CpuClock
+ * \brief Cpu time of the process, read once per run of a profiled pipeline since reading it costs a system call.
+ */
+struct CpuClock final {
+  CpuClock() : dStart_(std::clock()) {}
+
+  /**
+   * \fn std::chrono::nanoseconds elapsed()
+   * \brief Cpu time spent since construction.
+   * @return cpu time
+   */
+  std::chrono::nanoseconds elapsed() const {
+    return std::chrono::nanoseconds(static_cast<long long>((std::clock() - dStart_) * (1e9 / CLOCKS_PER_SEC)));
+  }
+
+ private:
+  std::clock_t dStart_;
+};
+
+/**
+ * \class ProfilingIterator
+ * \brief Iterator wrapping a stage of a Stream pipeline, recording the elements it yields and the exclusive time spent pulling them.
+ * @tparam T element type
+ */
+template<typename T>
+struct ProfilingIterator : public iterators::Iterator<T> {
+  ProfilingIterator(std::unique_ptr<iterators::Iterator<T>> stage, std::shared_ptr<StageProfile> profile) : dStage_(std::move(stage)), dProfile_(std::move(profile)) {}
+
+  ~ProfilingIterator() override = default;
+
+  inline bool hasNext() override {
+    ProfileScope scope(*dProfile_);
+    bool hasMore = dStage_->hasNext();
+    if (hasMore) {
+      dProfile_->elementsOut++;
+    }
+    return hasMore;
+  }
+
+  inline std::optional<T> next() override { return dStage_->next(); }
+
+  inline std::optional<T> take() override { return dStage_->take(); }
+
+  inline void reset() override { dStage_->reset(); }
+
+  inline std::optional<size_t> size() override { return dStage_->size(); }
+
+  inline std::unique_ptr<iterators::Iterator<T>> reversed() override {
+    auto reversed = dStage_->reversed();
+    return reversed ? std::make_unique<ProfilingIterator<T>>(std::move(reversed), dProfile_) : nullptr;
+  }
+
+ private:
+  std::unique_ptr<iterators::Iterator<T>> dStage_;
+  std::shared_ptr<StageProfile> dProfile_;
+};
+}// namespace aalbatross::utils::streams
+
+#endif//INCLUDED_STREAMS4CPP_PROFILE_H_
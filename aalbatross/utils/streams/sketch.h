@@ -0,0 +1,918 @@
+#ifndef INCLUDED_STREAMS4CPP_SKETCH_H_
+#define INCLUDED_STREAMS4CPP_SKETCH_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define STREAMS4CPP_SKETCH_SSE2
+#endif
+
+namespace aalbatross::utils::streams {
+/**
+ * \fn uint64_t mixHash(uint64_t hash)
+ * \brief Finalizer of MurmurHash3, spreads the bits of a hash so that sketches can use any of them. std::hash is the identity for integers on common standard libraries, which sketches cannot use directly.
+ * @param hash hash of an element
+ * @return mixed hash
+ */
+inline uint64_t mixHash(uint64_t hash) {
+  hash ^= hash >> 33U;
+  hash *= 0xFF51AFD7ED558CCDULL;
+  hash ^= hash >> 33U;
+  hash *= 0xC4CEB9FE1A85EC53ULL;
+  hash ^= hash >> 33U;
+  return hash;
+}
+
+/**
+ * \class HyperLogLog
+ * \brief Fixed size state of Collectors::approxDistinct(), a HyperLogLog sketch estimating the number of distinct hashes added to it.
+ *
+ * The sketch has 2^precision one byte registers, for example 4 KB with the default precision 12, whatever the number of elements, and estimates with a relative standard error of 1.04 / sqrt(2^precision), 1.6% at precision 12. Sketches of the same precision merge into the sketch of the union of their inputs, so shards and windows can be counted separately.
+ */
+struct HyperLogLog {
+  explicit HyperLogLog(unsigned precision = 12) : dPrecision_(precision) {
+    if (precision < 4 || precision > 18) {
+      throw std::invalid_argument("HyperLogLog precision must be between 4 and 18");
+    }
+    dRegisters_.assign(size_t{1} << precision, 0);
+  }
+
+  /**
+   * \fn void add(uint64_t hash)
+   * \brief Adds a well mixed 64 bit hash of an element, see mixHash().
+   * @param hash hash of the element
+   */
+  void add(uint64_t hash) {
+    size_t index = hash >> (64U - dPrecision_);
+    // the sentinel bit bounds the rank when the remaining bits are all zero
+    uint64_t remaining = (hash << dPrecision_) | (uint64_t{1} << (dPrecision_ - 1));
+    auto rank = static_cast<uint8_t>(countLeadingZeros(remaining) + 1);
+    dRegisters_[index] = std::max(dRegisters_[index], rank);
+  }
+
+  /**
+   * \fn void merge(const HyperLogLog &other)
+   * \brief Merges another sketch, the result estimates the distinct count of the union of both inputs.
+   * @param other sketch of the same precision
+   */
+  void merge(const HyperLogLog &other) {
+    if (other.dPrecision_ != dPrecision_) {
+      throw std::invalid_argument("HyperLogLog sketches of different precision cannot be merged");
+    }
+    for (size_t i = 0; i < dRegisters_.size(); i++) {
+      dRegisters_[i] = std::max(dRegisters_[i], other.dRegisters_[i]);
+    }
+  }
+
+  /**
+   * \fn double estimate()
+   * \brief Estimated number of distinct hashes added, small cardinalities are estimated with linear counting.
+   * @return estimated distinct count
+   */
+  double estimate() const {
+    auto registers = static_cast<double>(dRegisters_.size());
+    double sum = 0;
+    size_t zeros = 0;
+    for (uint8_t rank : dRegisters_) {
+      sum += std::ldexp(1.0, -rank);
+      zeros += rank == 0 ? 1 : 0;
+    }
+    double raw = alpha() * registers * registers / sum;
+    if (raw <= 2.5 * registers && zeros > 0) {
+      return registers * std::log(registers / static_cast<double>(zeros));
+    }
+    return raw;
+  }
+
+  unsigned precision() const { return dPrecision_; }
+
+  /**
+   * \fn double relativeError()
+   * \brief Relative standard error of estimate().
+   * @return 1.04 / sqrt(2^precision)
+   */
+  double relativeError() const { return 1.04 / std::sqrt(static_cast<double>(dRegisters_.size())); }
+
+  /**
+   * \fn size_t bytes()
+   * \brief Memory held by the registers of the sketch.
+   * @return bytes of the registers
+   */
+  size_t bytes() const { return dRegisters_.size(); }
+
+ private:
+  unsigned dPrecision_;
+  std::vector<uint8_t> dRegisters_;
+
+  double alpha() const {
+    switch (dRegisters_.size()) {
+      case 16:
+        return 0.673;
+      case 32:
+        return 0.697;
+      case 64:
+        return 0.709;
+      default:
+        return 0.7213 / (1 + 1.079 / static_cast<double>(dRegisters_.size()));
+    }
+  }
+
+  static unsigned countLeadingZeros(uint64_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+    return static_cast<unsigned>(__builtin_clzll(value));
+#else
+    unsigned zeros = 0;
+    for (uint64_t bit = uint64_t{1} << 63U; (value & bit) == 0; bit >>= 1U) {
+      zeros++;
+    }
+    return zeros;
+#endif
+  }
+};
+
+/**
+ * \class TDigest
+ * \brief Fixed size state of Collectors::quantiles(), a merging t-digest summarizing a distribution of values with weighted centroids.
+ *
+ * Centroids are small near both ends of the distribution and large around the median, so the rank error of quantile(q) is roughly proportional to q * (1 - q) / compression: tails like p99 and p999 are the most accurate. The minimum and maximum are exact.
+ * The digest holds at most about compression centroids plus a buffer of 5 * compression values, 100 is a good default. Digests merge into the digest of the union of their inputs.
+ */
+struct TDigest {
+  struct Centroid {
+    double mean;
+    double weight;
+  };
+
+  explicit TDigest(double compression = 100) : dCompression_(compression) {
+    if (!(compression >= 10)) {
+      throw std::invalid_argument("TDigest compression must be at least 10");
+    }
+    dBuffer_.reserve(bufferSize());
+  }
+
+  /**
+   * \fn void add(double value, double weight = 1)
+   * \brief Adds a value, NaN values are ignored.
+   * @param value
+   * @param weight number of occurrences of value
+   */
+  void add(double value, double weight = 1) {
+    if (std::isnan(value)) {
+      return;
+    }
+    dMin_ = std::min(dMin_, value);
+    dMax_ = std::max(dMax_, value);
+    dBuffer_.push_back(Centroid{value, weight});
+    if (dBuffer_.size() >= bufferSize()) {
+      compress();
+    }
+  }
+
+  /**
+   * \fn void merge(const TDigest &other)
+   * \brief Merges the centroids of another digest.
+   * @param other
+   */
+  void merge(const TDigest &other) {
+    dMin_ = std::min(dMin_, other.dMin_);
+    dMax_ = std::max(dMax_, other.dMax_);
+    for (const auto *centroids : {&other.dCentroids_, &other.dBuffer_}) {
+      for (const auto &centroid : *centroids) {
+        dBuffer_.push_back(centroid);
+        if (dBuffer_.size() >= bufferSize()) {
+          compress();
+        }
+      }
+    }
+  }
+
+  /**
+   * \fn void compress()
+   * \brief Merges the buffered values into the centroids, quantile() is cheapest after compressing.
+   */
+  void compress() {
+    if (dBuffer_.empty()) {
+      return;
+    }
+    dBuffer_.insert(dBuffer_.end(), dCentroids_.begin(), dCentroids_.end());
+    std::sort(dBuffer_.begin(), dBuffer_.end(), [](const Centroid &lhs, const Centroid &rhs) { return lhs.mean < rhs.mean; });
+    double total = 0;
+    for (const auto &centroid : dBuffer_) {
+      total += centroid.weight;
+    }
+    dCentroids_.clear();
+    Centroid current = dBuffer_.front();
+    double weightSoFar = 0;
+    double limit = total * kInverse(k(0) + 1);
+    for (size_t i = 1; i < dBuffer_.size(); i++) {
+      const Centroid &next = dBuffer_[i];
+      if (weightSoFar + current.weight + next.weight <= limit) {
+        current.weight += next.weight;
+        current.mean += (next.mean - current.mean) * next.weight / current.weight;
+      } else {
+        weightSoFar += current.weight;
+        dCentroids_.push_back(current);
+        limit = total * kInverse(k(weightSoFar / total) + 1);
+        current = next;
+      }
+    }
+    dCentroids_.push_back(current);
+    dBuffer_.clear();
+    dTotal_ = total;
+  }
+
+  /**
+   * \fn double quantile(double q)
+   * \brief Estimated value below which a fraction q of the values fall, interpolating between centroids.
+   * @param q fraction between 0 and 1
+   * @return estimated quantile, NaN when the digest is empty
+   */
+  double quantile(double q) const {
+    if (!dBuffer_.empty()) {
+      TDigest compressed = *this;
+      compressed.compress();
+      return compressed.quantile(q);
+    }
+    if (dCentroids_.empty()) {
+      return std::numeric_limits<double>::quiet_NaN();
+    }
+    if (q <= 0) {
+      return dMin_;
+    }
+    if (q >= 1) {
+      return dMax_;
+    }
+    double target = q * dTotal_;
+    const Centroid &first = dCentroids_.front();
+    if (target < first.weight / 2) {
+      return dMin_ + (first.mean - dMin_) * target / (first.weight / 2);
+    }
+    double cumulative = 0;
+    for (size_t i = 0; i + 1 < dCentroids_.size(); i++) {
+      const Centroid &left = dCentroids_[i];
+      const Centroid &right = dCentroids_[i + 1];
+      double leftCenter = cumulative + left.weight / 2;
+      double rightCenter = cumulative + left.weight + right.weight / 2;
+      if (target < rightCenter) {
+        return left.mean + (right.mean - left.mean) * (target - leftCenter) / (rightCenter - leftCenter);
+      }
+      cumulative += left.weight;
+    }
+    const Centroid &last = dCentroids_.back();
+    double lastCenter = dTotal_ - last.weight / 2;
+    return last.mean + (dMax_ - last.mean) * std::min(1.0, (target - lastCenter) / (last.weight / 2));
+  }
+
+  /**
+   * \fn double count()
+   * \brief Total weight of the values added.
+   * @return number of values added
+   */
+  double count() const {
+    double total = dTotal_;
+    for (const auto &centroid : dBuffer_) {
+      total += centroid.weight;
+    }
+    return total;
+  }
+
+  double min() const { return dMin_; }
+
+  double max() const { return dMax_; }
+
+  double compression() const { return dCompression_; }
+
+  /**
+   * \fn size_t centroids()
+   * \brief Number of centroids after the last compress().
+   * @return number of centroids
+   */
+  size_t centroids() const { return dCentroids_.size(); }
+
+ private:
+  static constexpr double PI = 3.14159265358979323846;
+
+  double dCompression_;
+  double dTotal_ = 0;
+  double dMin_ = std::numeric_limits<double>::infinity();
+  double dMax_ = -std::numeric_limits<double>::infinity();
+  std::vector<Centroid> dCentroids_;
+  std::vector<Centroid> dBuffer_;
+
+  size_t bufferSize() const { return static_cast<size_t>(5 * dCompression_); }
+
+  // k1 scale function, centroids span at most one unit of k
+  double k(double q) const { return dCompression_ / (2 * PI) * std::asin(2 * std::clamp(q, 0.0, 1.0) - 1); }
+
+  double kInverse(double scale) const { return (std::sin(std::min(scale * 2 * PI / dCompression_, PI / 2)) + 1) / 2; }
+};
+
+/**
+ * \class FrequentItem
+ * \brief Item reported by SpaceSaving with its estimated frequency, the true frequency lies between count - error and count.
+ * @tparam K item type
+ */
+template<typename K>
+struct FrequentItem {
+  K key;
+  size_t count;
+  size_t error;
+};
+
+/**
+ * \class SpaceSaving
+ * \brief Fixed size state of Collectors::heavyHitters(), a Space-Saving summary counting the most frequent items of a stream with a fixed number of counters.
+ *
+ * When all counters are in use a new item replaces the item with the smallest count and inherits that count as its error. With capacity counters every item more frequent than total() / capacity is kept, and counts overestimate by at most total() / capacity. Summaries merge into a summary of the union of their inputs with the same guarantee.
+ * @tparam K item type
+ * @tparam Hash hash of item
+ * @tparam KeyEqual equals of item
+ */
+template<typename K, typename Hash = std::hash<K>, typename KeyEqual = std::equal_to<K>>
+struct SpaceSaving {
+  explicit SpaceSaving(size_t capacity, const Hash &hash = Hash(), const KeyEqual &keyEqual = KeyEqual()) : dCapacity_(capacity), dPositions_(capacity, hash, keyEqual) {
+    if (capacity == 0) {
+      throw std::invalid_argument("SpaceSaving capacity must be positive");
+    }
+    dCounters_.reserve(capacity);
+  }
+
+  /**
+   * \fn void add(const K &key, size_t weight = 1)
+   * \brief Counts weight occurrences of key.
+   * @param key
+   * @param weight
+   */
+  void add(const K &key, size_t weight = 1) {
+    dTotal_ += weight;
+    auto position = dPositions_.find(key);
+    if (position != dPositions_.end()) {
+      dCounters_[position->second].count += weight;
+      siftDown(dHeapIndex_[position->second]);
+    } else if (dCounters_.size() < dCapacity_) {
+      size_t slot = dCounters_.size();
+      dCounters_.push_back(FrequentItem<K>{key, weight, 0});
+      dPositions_.emplace(key, slot);
+      dHeap_.push_back(slot);
+      dHeapIndex_.push_back(slot);
+      siftUp(slot);
+    } else {
+      size_t slot = dHeap_.front();
+      FrequentItem<K> &smallest = dCounters_[slot];
+      dPositions_.erase(smallest.key);
+      smallest = FrequentItem<K>{key, smallest.count + weight, smallest.count};
+      dPositions_.emplace(key, slot);
+      siftDown(0);
+    }
+  }
+
+  /**
+   * \fn void merge(const SpaceSaving &other)
+   * \brief Merges another summary, an item missing from a full summary is counted with the smallest count of that summary, and the capacity items with the largest counts are kept.
+   * @param other
+   */
+  void merge(const SpaceSaving &other) {
+    size_t thisMissing = dCounters_.size() == dCapacity_ ? countAt(0) : 0;
+    size_t otherMissing = other.dCounters_.size() == other.dCapacity_ ? other.countAt(0) : 0;
+    std::vector<FrequentItem<K>> merged(dCounters_);
+    for (auto &item : merged) {
+      item.count += otherMissing;
+      item.error += otherMissing;
+    }
+    for (const auto &item : other.dCounters_) {
+      auto position = dPositions_.find(item.key);
+      if (position != dPositions_.end()) {
+        merged[position->second].count += item.count - otherMissing;
+        merged[position->second].error += item.error - otherMissing;
+      } else {
+        merged.push_back(FrequentItem<K>{item.key, item.count + thisMissing, item.error + thisMissing});
+      }
+    }
+    if (merged.size() > dCapacity_) {
+      std::nth_element(merged.begin(), merged.begin() + static_cast<std::ptrdiff_t>(dCapacity_), merged.end(), [](const auto &lhs, const auto &rhs) { return lhs.count > rhs.count; });
+      merged.resize(dCapacity_);
+    }
+    dCounters_ = std::move(merged);
+    dTotal_ += other.dTotal_;
+    dPositions_.clear();
+    dHeap_.clear();
+    dHeapIndex_.clear();
+    for (size_t slot = 0; slot < dCounters_.size(); slot++) {
+      dPositions_.emplace(dCounters_[slot].key, slot);
+      dHeap_.push_back(slot);
+      dHeapIndex_.push_back(slot);
+      siftUp(slot);
+    }
+  }
+
+  /**
+   * \fn std::vector<FrequentItem<K>> topK(size_t k)
+   * \brief The k items with the largest counts, by decreasing count.
+   * @param k
+   * @return most frequent items
+   */
+  std::vector<FrequentItem<K>> topK(size_t k) const {
+    std::vector<FrequentItem<K>> items(dCounters_);
+    auto end = items.begin() + static_cast<std::ptrdiff_t>(std::min(k, items.size()));
+    std::partial_sort(items.begin(), end, items.end(), [](const auto &lhs, const auto &rhs) { return lhs.count > rhs.count; });
+    items.erase(end, items.end());
+    return items;
+  }
+
+  /**
+   * \fn size_t total()
+   * \brief Total weight of the items added.
+   * @return number of items added
+   */
+  size_t total() const { return dTotal_; }
+
+  size_t capacity() const { return dCapacity_; }
+
+ private:
+  size_t dCapacity_;
+  size_t dTotal_ = 0;
+  std::vector<FrequentItem<K>> dCounters_;
+  std::unordered_map<K, size_t, Hash, KeyEqual> dPositions_;
+  // min heap of counter slots on count, the smallest counter is replaced first. Slots do not move so that sifting never touches dPositions_
+  std::vector<size_t> dHeap_;
+  std::vector<size_t> dHeapIndex_;
+
+  size_t countAt(size_t index) const { return dCounters_[dHeap_[index]].count; }
+
+  void swapHeap(size_t lhs, size_t rhs) {
+    std::swap(dHeap_[lhs], dHeap_[rhs]);
+    dHeapIndex_[dHeap_[lhs]] = lhs;
+    dHeapIndex_[dHeap_[rhs]] = rhs;
+  }
+
+  void siftUp(size_t index) {
+    while (index > 0 && countAt((index - 1) / 2) > countAt(index)) {
+      swapHeap(index, (index - 1) / 2);
+      index = (index - 1) / 2;
+    }
+  }
+
+  void siftDown(size_t index) {
+    while (true) {
+      size_t smallest = index;
+      for (size_t child = 2 * index + 1; child <= 2 * index + 2 && child < dHeap_.size(); child++) {
+        if (countAt(child) < countAt(smallest)) {
+          smallest = child;
+        }
+      }
+      if (smallest == index) {
+        return;
+      }
+      swapHeap(index, smallest);
+      index = smallest;
+    }
+  }
+};
+/**
+ * \class Reservoir
+ * \brief Fixed size state of Collectors::sample(), a uniform random sample of at most capacity elements of a stream of unknown length.
+ *
+ * The default mode is Vitter's Algorithm R and draws a random number per element. The skipping mode is Li's Algorithm L: it draws the number of elements to skip before the next replacement, so the random number generator is called O(capacity * log(count / capacity)) times. Both modes keep every element with probability capacity / count. The engine is std::mt19937_64, so samples are reproducible from the seed with the same standard library. Reservoirs merge into a uniform sample of the union of their inputs.
+ * @tparam T element type
+ */
+template<typename T>
+struct Reservoir {
+  explicit Reservoir(size_t capacity, uint64_t seed = 0, bool skipping = false) : dCapacity_(capacity), dSkipping_(skipping), dEngine_(seed) {
+    if (capacity == 0) {
+      throw std::invalid_argument("Reservoir capacity must be greater than 0");
+    }
+  }
+
+  void add(const T &element) {
+    insert(element);
+  }
+
+  /**
+   * \fn void add(T &&element)
+   * \brief Adds an element, moving it into the sample when it is kept, so move-only elements can be sampled.
+   * @param element element of the stream
+   */
+  void add(T &&element) {
+    insert(std::move(element));
+  }
+
+  /**
+   * \fn void merge(Reservoir &other)
+   * \brief Merges another reservoir, the result is a uniform sample of the union of both inputs. Every slot is drawn from either reservoir in proportion to the number of elements it has seen and not yet drawn.
+   * @param other reservoir of the same capacity, its items are shuffled
+   */
+  void merge(Reservoir &other) {
+    if (other.dCount_ == 0) {
+      return;
+    }
+    std::shuffle(dItems_.begin(), dItems_.end(), dEngine_);
+    std::shuffle(other.dItems_.begin(), other.dItems_.end(), dEngine_);
+    uint64_t remaining = dCount_;
+    uint64_t otherRemaining = other.dCount_;
+    size_t taken = 0;
+    size_t otherTaken = 0;
+    std::vector<T> merged;
+    size_t size = std::min(dCapacity_, dItems_.size() + other.dItems_.size());
+    merged.reserve(size);
+    while (merged.size() < size) {
+      if (std::uniform_int_distribution<uint64_t>(0, remaining + otherRemaining - 1)(dEngine_) < remaining) {
+        merged.push_back(std::move(dItems_[taken++]));
+        remaining--;
+      } else {
+        merged.push_back(std::move(other.dItems_[otherTaken++]));
+        otherRemaining--;
+      }
+    }
+    dItems_ = std::move(merged);
+    dCount_ += other.dCount_;
+    if (dSkipping_ && dItems_.size() == dCapacity_) {
+      // the threshold of Algorithm L after count elements is the capacity-th smallest of count uniform keys
+      double smaller = std::gamma_distribution<double>(static_cast<double>(dCapacity_))(dEngine_);
+      double larger = std::gamma_distribution<double>(static_cast<double>(dCount_ - dCapacity_ + 1))(dEngine_);
+      dThreshold_ = smaller / (smaller + larger);
+      scheduleNext();
+    }
+  }
+
+  const std::vector<T> &items() const & { return dItems_; }
+
+  std::vector<T> items() && { return std::move(dItems_); }
+
+  uint64_t count() const { return dCount_; }
+
+  size_t capacity() const { return dCapacity_; }
+
+ private:
+  size_t dCapacity_;
+  bool dSkipping_;
+  std::mt19937_64 dEngine_;
+  std::vector<T> dItems_;
+  uint64_t dCount_ = 0;
+  uint64_t dNext_ = 0;
+  double dThreshold_ = 1;
+
+  template<typename U>
+  void insert(U &&element) {
+    dCount_++;
+    if (dItems_.size() < dCapacity_) {
+      dItems_.push_back(std::forward<U>(element));
+      if (dSkipping_ && dItems_.size() == dCapacity_) {
+        dThreshold_ = std::exp(std::log(uniform()) / static_cast<double>(dCapacity_));
+        scheduleNext();
+      }
+    } else if (!dSkipping_) {
+      auto position = std::uniform_int_distribution<uint64_t>(0, dCount_ - 1)(dEngine_);
+      if (position < dCapacity_) {
+        dItems_[position] = std::forward<U>(element);
+      }
+    } else if (dCount_ == dNext_) {
+      dItems_[std::uniform_int_distribution<size_t>(0, dCapacity_ - 1)(dEngine_)] = std::forward<U>(element);
+      dThreshold_ *= std::exp(std::log(uniform()) / static_cast<double>(dCapacity_));
+      scheduleNext();
+    }
+  }
+
+  double uniform() {
+    return std::uniform_real_distribution<double>(std::numeric_limits<double>::min(), 1)(dEngine_);
+  }
+
+  void scheduleNext() {
+    auto skip = std::floor(std::log(uniform()) / std::log1p(-dThreshold_));
+    dNext_ = skip < static_cast<double>(std::numeric_limits<uint64_t>::max() / 2) ? dCount_ + static_cast<uint64_t>(skip) + 1 : std::numeric_limits<uint64_t>::max();
+  }
+};
+/**
+ * \class Histogram
+ * \brief State of Collectors::histogram() and Collectors::logHistogram(), counts of values in bins indexed by arithmetic on the value instead of hashing.
+ *
+ * A linear histogram splits [min, max) in bins of equal width. A logarithmic histogram, like HdrHistogram, splits every power of two between min and max in 2^bits sub-bins of equal width, where 2^bits >= 10^precision, so the width of a bin is less than 10^-precision times its values. In both layouts the bin of a value is computed without branches from its difference to min or from the bits of its IEEE 754 representation, two values at a time with SSE2 when available. Values below the first bin (and NaN) are counted by underflow(), values above the last bin by overflow(). Histograms of the same layout merge by adding counts.
+ */
+class Histogram {
+ public:
+  /**
+   * \fn Histogram linear(double min, double max, size_t bins)
+   * \brief Histogram of bins of equal width between min (inclusive) and max (exclusive).
+   * @param min lower bound of the first bin
+   * @param max upper bound of the last bin, greater than min
+   * @param bins number of bins, greater than 0
+   * @return empty linear histogram
+   */
+  static Histogram linear(double min, double max, size_t bins) {
+    if (!(min < max) || !std::isfinite(min) || !std::isfinite(max) || bins == 0 || bins > MAX_BINS) {
+      throw std::invalid_argument("linear Histogram needs finite min < max and 0 < bins <= 2^24");
+    }
+    Histogram histogram(false, min, max, bins);
+    histogram.dScale_ = static_cast<double>(bins) / (max - min);
+    return histogram;
+  }
+
+  /**
+   * \fn Histogram logarithmic(double min, double max, unsigned precision)
+   * \brief Histogram of bins whose width is proportional to their values, between min and max (inclusive).
+   * @param min lowest tracked value, greater than 0
+   * @param max highest tracked value, greater than min
+   * @param precision number of significant decimal digits of values, between 1 and 4
+   * @return empty logarithmic histogram
+   */
+  static Histogram logarithmic(double min, double max, unsigned precision) {
+    if (!(min >= std::numeric_limits<double>::min() && min < max && std::isfinite(max)) || precision < 1 || precision > 4) {
+      throw std::invalid_argument("logarithmic Histogram needs 0 < min < max finite and precision between 1 and 4");
+    }
+    unsigned bits = 0;
+    for (uint64_t subBins = 1, limit = static_cast<uint64_t>(std::pow(10, precision)); subBins < limit; subBins <<= 1U) {
+      bits++;
+    }
+    unsigned shift = MANTISSA_BITS - bits;
+    uint64_t first = bitsOf(min) >> shift;
+    uint64_t last = bitsOf(max) >> shift;
+    if (last - first + 1 > MAX_BINS) {
+      throw std::invalid_argument("logarithmic Histogram has more than 2^24 bins, reduce precision or the range");
+    }
+    Histogram histogram(true, min, max, last - first + 1);
+    histogram.dShift_ = shift;
+    histogram.dFirstKey_ = first;
+    histogram.dUnder_ = valueOf((first << shift) - 1);
+    histogram.dOver_ = valueOf((last + 1) << shift);
+    return histogram;
+  }
+
+  void add(double value, uint64_t count = 1) { dCounts_[indexOf(value)] += count; }
+
+  /**
+   * \fn void addBlock(const double *values, size_t size)
+   * \brief Counts a contiguous block of values, their bins are computed two at a time with SSE2 when available.
+   * @param values
+   * @param size number of values
+   */
+  void addBlock(const double *values, size_t size) {
+    size_t i = 0;
+#ifdef STREAMS4CPP_SKETCH_SSE2
+    if (dLogarithmic_) {
+      __m128d under = _mm_set1_pd(dUnder_);
+      __m128d over = _mm_set1_pd(dOver_);
+      __m128i shift = _mm_cvtsi32_si128(static_cast<int>(dShift_));
+      __m128i origin = _mm_set1_epi64x(static_cast<int64_t>(dFirstKey_ - 1));
+      alignas(16) uint64_t indices[2];
+      for (; i + 2 <= size; i += 2) {
+        __m128d clamped = _mm_min_pd(_mm_max_pd(_mm_loadu_pd(values + i), under), over);
+        _mm_store_si128(reinterpret_cast<__m128i *>(indices), _mm_sub_epi64(_mm_srl_epi64(_mm_castpd_si128(clamped), shift), origin));
+        dCounts_[indices[0]]++;
+        dCounts_[indices[1]]++;
+      }
+    } else {
+      __m128d min = _mm_set1_pd(dMin_);
+      __m128d scale = _mm_set1_pd(dScale_);
+      __m128d one = _mm_set1_pd(1);
+      __m128d zero = _mm_setzero_pd();
+      __m128d last = _mm_set1_pd(static_cast<double>(dBins_ + 1));
+      alignas(16) int32_t indices[4];
+      for (; i + 2 <= size; i += 2) {
+        __m128d position = _mm_add_pd(_mm_mul_pd(_mm_sub_pd(_mm_loadu_pd(values + i), min), scale), one);
+        _mm_store_si128(reinterpret_cast<__m128i *>(indices), _mm_cvttpd_epi32(_mm_min_pd(_mm_max_pd(position, zero), last)));
+        dCounts_[indices[0]]++;
+        dCounts_[indices[1]]++;
+      }
+    }
+#endif
+    for (; i < size; i++) {
+      dCounts_[indexOf(values[i])]++;
+    }
+  }
+
+  /**
+   * \fn void merge(const Histogram &other)
+   * \brief Adds the counts of another histogram of the same layout.
+   * @param other
+   */
+  void merge(const Histogram &other) {
+    if (dLogarithmic_ != other.dLogarithmic_ || dMin_ != other.dMin_ || dMax_ != other.dMax_ || dBins_ != other.dBins_) {
+      throw std::invalid_argument("cannot merge histograms of different layouts");
+    }
+    for (size_t i = 0; i < dCounts_.size(); i++) {
+      dCounts_[i] += other.dCounts_[i];
+    }
+  }
+
+  size_t bins() const { return dBins_; }
+
+  /**
+   * \fn uint64_t count(size_t bin)
+   * \brief Number of values in a bin.
+   * @param bin between 0 and bins() - 1
+   * @return count of values in the bin
+   */
+  uint64_t count(size_t bin) const { return dCounts_.at(bin + 1); }
+
+  double lowerBound(size_t bin) const {
+    return dLogarithmic_ ? valueOf((dFirstKey_ + bin) << dShift_) : dMin_ + static_cast<double>(bin) / dScale_;
+  }
+
+  double upperBound(size_t bin) const { return lowerBound(bin + 1); }
+
+  uint64_t underflow() const { return dCounts_.front(); }
+
+  uint64_t overflow() const { return dCounts_.back(); }
+
+  uint64_t total() const { return std::accumulate(dCounts_.begin(), dCounts_.end(), uint64_t{0}); }
+
+  /**
+   * \fn double quantile(double fraction)
+   * \brief Approximate value at the given fraction of the counted values, the upper bound of the bin holding it, min for underflow and max for overflow.
+   * @param fraction between 0 and 1
+   * @return approximate quantile, NaN if no value was counted
+   */
+  double quantile(double fraction) const {
+    uint64_t all = total();
+    if (all == 0) {
+      return std::numeric_limits<double>::quiet_NaN();
+    }
+    auto rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(std::clamp(fraction, 0.0, 1.0) * static_cast<double>(all))));
+    uint64_t seen = dCounts_.front();
+    if (seen >= rank) {
+      return dMin_;
+    }
+    for (size_t bin = 0; bin < dBins_; bin++) {
+      seen += dCounts_[bin + 1];
+      if (seen >= rank) {
+        return std::min(upperBound(bin), dMax_);
+      }
+    }
+    return dMax_;
+  }
+
+ private:
+  static constexpr size_t MAX_BINS = size_t{1} << 24U;
+  static constexpr unsigned MANTISSA_BITS = 52;
+
+  Histogram(bool logarithmic, double min, double max, size_t bins) : dLogarithmic_(logarithmic), dMin_(min), dMax_(max), dBins_(bins), dCounts_(bins + 2, 0) {}
+
+  bool dLogarithmic_;
+  double dMin_;
+  double dMax_;
+  size_t dBins_;
+  double dScale_ = 0;
+  unsigned dShift_ = 0;
+  uint64_t dFirstKey_ = 0;
+  double dUnder_ = 0;
+  double dOver_ = 0;
+  std::vector<uint64_t> dCounts_;
+
+  static uint64_t bitsOf(double value) {
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+  }
+
+  static double valueOf(uint64_t bits) {
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+  }
+
+  // comparisons mirror _mm_max_pd and _mm_min_pd, so NaN is counted as underflow by both paths
+  size_t indexOf(double value) const {
+    if (dLogarithmic_) {
+      double clamped = value > dUnder_ ? value : dUnder_;
+      clamped = clamped < dOver_ ? clamped : dOver_;
+      return (bitsOf(clamped) >> dShift_) - (dFirstKey_ - 1);
+    }
+    double position = (value - dMin_) * dScale_ + 1;
+    position = position > 0 ? position : 0;
+    auto last = static_cast<double>(dBins_ + 1);
+    return static_cast<size_t>(position < last ? position : last);
+  }
+};
+
+/**
+ * \class HistogramState
+ * \brief State of Collectors::toHistogram(), values are buffered in a small fixed block which is counted with Histogram::addBlock when full.
+ */
+struct HistogramState {
+  static constexpr size_t BLOCK = 64;
+
+  explicit HistogramState(const Histogram &empty) : histogram(empty) {}
+
+  void add(double value) {
+    block[buffered++] = value;
+    if (buffered == BLOCK) {
+      flush();
+    }
+  }
+
+  void flush() {
+    histogram.addBlock(block, buffered);
+    buffered = 0;
+  }
+
+  Histogram histogram;
+  double block[BLOCK];
+  size_t buffered = 0;
+};
+/**
+ * \class BloomFilter
+ * \brief State of Collectors::bloomFilter(), a blocked Bloom filter answering whether an item might have been added, without false negatives and with a configurable false positive probability.
+ *
+ * The bits are split in blocks of one 64 byte cache line. All the bits of an item are set in a single block selected by its hash, so a lookup touches one cache line whatever the number of hashes. The filter takes about -1.44 * log2(fpp) bits per expected item, 1.2 bytes at 1% instead of tens of bytes per item of an unordered set. Filters of the same size and number of hashes merge into the filter of the union of their inputs.
+ * @tparam T item type
+ * @tparam Hash hash of item
+ */
+template<typename T, typename Hash = std::hash<T>>
+class BloomFilter {
+ public:
+  static constexpr size_t BLOCK_BITS = 512;
+
+  /**
+   * \fn BloomFilter(size_t expectedItems, double fpp = 0.01, const Hash &hash = Hash())
+   * \brief Sizes the filter for a false positive probability after expectedItems distinct items are added.
+   * @param expectedItems number of distinct items expected
+   * @param fpp false positive probability, between 0 and 1 (exclusive)
+   * @param hash
+   */
+  explicit BloomFilter(size_t expectedItems, double fpp = 0.01, const Hash &hash = Hash()) : dHash_(hash) {
+    if (!(fpp > 0 && fpp < 1)) {
+      throw std::invalid_argument("BloomFilter false positive probability must be between 0 and 1");
+    }
+    auto items = static_cast<double>(std::max<size_t>(expectedItems, 1));
+    double bits = -items * std::log(fpp) / (std::log(2) * std::log(2));
+    dBlocks_.resize(static_cast<size_t>(std::ceil(bits / BLOCK_BITS)));
+    dHashes_ = static_cast<unsigned>(std::clamp(std::round(bits / items * std::log(2)), 1.0, 16.0));
+  }
+
+  void add(const T &item) {
+    uint64_t hash = mixHash(dHash_(item));
+    Block &block = dBlocks_[blockOf(hash)];
+    forEachBit(hash, [&block](size_t word, uint64_t mask) { block.words[word] |= mask; });
+  }
+
+  /**
+   * \fn bool mightContain(const T &item)
+   * \brief Whether the item might have been added, false means it was certainly not.
+   * @param item
+   * @return false if item was never added, true if it was or with the false positive probability
+   */
+  bool mightContain(const T &item) const {
+    uint64_t hash = mixHash(dHash_(item));
+    const Block &block = dBlocks_[blockOf(hash)];
+    bool contained = true;
+    forEachBit(hash, [&block, &contained](size_t word, uint64_t mask) { contained &= (block.words[word] & mask) == mask; });
+    return contained;
+  }
+
+  void merge(const BloomFilter &other) {
+    if (dBlocks_.size() != other.dBlocks_.size() || dHashes_ != other.dHashes_) {
+      throw std::invalid_argument("cannot merge BloomFilter of different sizes");
+    }
+    for (size_t i = 0; i < dBlocks_.size(); i++) {
+      for (size_t word = 0; word < WORDS; word++) {
+        dBlocks_[i].words[word] |= other.dBlocks_[i].words[word];
+      }
+    }
+  }
+
+  unsigned hashes() const { return dHashes_; }
+
+  size_t bytes() const { return dBlocks_.size() * sizeof(Block); }
+
+ private:
+  static constexpr size_t WORDS = BLOCK_BITS / 64;
+
+  struct alignas(64) Block {
+    uint64_t words[WORDS] = {};
+  };
+
+  Hash dHash_;
+  std::vector<Block> dBlocks_;
+  unsigned dHashes_;
+
+  size_t blockOf(uint64_t hash) const {
+    return static_cast<size_t>(((hash >> 32U) * dBlocks_.size()) >> 32U);
+  }
+
+  // double hashing within the block, from bits of the hash not used to select it
+  template<typename Function>
+  void forEachBit(uint64_t hash, Function &&function) const {
+    uint64_t remixed = hash * 0x9E3779B97F4A7C15ULL;
+    auto first = static_cast<uint32_t>(remixed);
+    auto step = static_cast<uint32_t>(remixed >> 32U) | 1U;
+    for (unsigned i = 0; i < dHashes_; i++) {
+      uint32_t bit = (first + i * step) % BLOCK_BITS;
+      function(bit / 64, uint64_t{1} << (bit % 64));
+    }
+  }
+};
+}// namespace aalbatross::utils::streams
+
+#endif//INCLUDED_STREAMS4CPP_SKETCH_H_
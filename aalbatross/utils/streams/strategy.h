@@ -0,0 +1,552 @@
+#ifndef INCLUDED_STREAMS4CPP_STRATEGY_H_
+#define INCLUDED_STREAMS4CPP_STRATEGY_H_
+#include "aalbatross/utils/iterators/iterator.h"
+#include "sketch.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <set>
+#include <string_view>
+#include <type_traits>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace aalbatross::utils::streams {
+/**
+ * \class StrategyChoice
+ * \brief Algorithm chosen at run time by an adaptive operator and the sample it was chosen from, reported by Stream::explain() and Stream::profile().
+ *
+ * The strategy is "adaptive" until the operator has run, then one of "dense", "hash", "sort" or "tree".
+ */
+struct StrategyChoice {
+  const char *strategy = "adaptive";
+  size_t sampled = 0;
+  size_t estimatedDistinct = 0;
+};
+
+/**
+ * \class IsHashable
+ * \brief True when keys of type K have a std::hash and an operator==, so that they can be kept in unordered containers.
+ */
+template<typename K, typename = void>
+struct IsHashable : std::false_type {};
+
+template<typename K>
+struct IsHashable<K, std::void_t<decltype(std::hash<K>()(std::declval<const K &>())), decltype(std::declval<const K &>() == std::declval<const K &>())>> : std::true_type {};
+
+/**
+ * \class DenseKey
+ * \brief Order preserving mapping of integral and enum keys to unsigned 64 bit codes, the slots of dense arrays.
+ */
+template<typename K>
+struct DenseKey {
+  static constexpr bool supported() {
+    if constexpr (std::is_enum_v<K>) {
+      return true;
+    } else {
+      return std::is_integral_v<K>;
+    }
+  }
+
+  static uint64_t encode(const K &key) {
+    using U = typename Underlying<K>::type;
+    auto value = static_cast<U>(key);
+    if constexpr (std::is_signed_v<U>) {
+      return static_cast<uint64_t>(static_cast<int64_t>(value)) ^ SIGN;
+    } else {
+      return static_cast<uint64_t>(value);
+    }
+  }
+
+  static K decode(uint64_t code) {
+    using U = typename Underlying<K>::type;
+    if constexpr (std::is_signed_v<U>) {
+      return static_cast<K>(static_cast<U>(static_cast<int64_t>(code ^ SIGN)));
+    } else {
+      return static_cast<K>(static_cast<U>(code));
+    }
+  }
+
+ private:
+  static constexpr uint64_t SIGN = uint64_t{1} << 63U;
+
+  template<typename E, bool = std::is_enum_v<E>>
+  struct Underlying {
+    using type = E;
+  };
+
+  template<typename E>
+  struct Underlying<E, true> {
+    using type = std::underlying_type_t<E>;
+  };
+};
+
+/**
+ * \class DenseSlots
+ * \brief Array of slots indexed by the code of a key minus the smallest code, which grows to new keys while at most DENSE_FACTOR slots per occupied slot are allocated.
+ * @tparam K type of keys
+ * @tparam Slot type of slots, a default constructed slot is empty
+ */
+template<typename K, typename Slot>
+class DenseSlots {
+ public:
+  static constexpr uint64_t DENSE_FACTOR = 4;
+  static constexpr uint64_t DENSE_LIMIT = uint64_t{1} << 22U;
+
+  /**
+   * \fn bool fits(uint64_t low, uint64_t high, size_t distinct)
+   * \brief Whether codes between low and high, both included, of that many distinct keys are dense enough for an array.
+   */
+  static bool fits(uint64_t low, uint64_t high, size_t distinct) {
+    auto span = high - low;
+    return span < DENSE_LIMIT && span < DENSE_FACTOR * (distinct + 1);
+  }
+
+  DenseSlots() = default;
+
+  DenseSlots(uint64_t low, uint64_t high) : dBase_(low), dSlots_(high - low + 1) {}
+
+  /**
+   * \fn Slot *find(const K &key, size_t occupied)
+   * \brief Slot of a key, growing the array to it, or nullptr when the array would be too sparse for that many occupied slots.
+   */
+  Slot *find(const K &key, size_t occupied) {
+    auto offset = DenseKey<K>::encode(key) - dBase_;
+    if (offset < dSlots_.size()) {
+      return &dSlots_[offset];
+    }
+    return grow(DenseKey<K>::encode(key), occupied);
+  }
+
+  /**
+   * \fn void forEach(F &&consumer)
+   * \brief Calls the consumer with every key and its slot in ascending order of keys, empty slots included.
+   */
+  template<typename F>
+  void forEach(F &&consumer) {
+    for (size_t index = 0; index < dSlots_.size(); ++index) {
+      consumer(DenseKey<K>::decode(dBase_ + index), dSlots_[index]);
+    }
+  }
+
+  size_t size() const { return dSlots_.size(); }
+
+ private:
+  uint64_t dBase_ = 0;
+  std::vector<Slot> dSlots_;
+
+  Slot *grow(uint64_t code, size_t occupied) {
+    auto high = std::max(code, dBase_ + (dSlots_.size() - 1));
+    auto low = std::min(code, dBase_);
+    if (!fits(low, high, occupied)) {
+      return nullptr;
+    }
+    if (code < dBase_) {
+      // prepend as many slots again as are kept, when still dense enough, so that descending keys do not shift the array every time
+      auto headroom = std::min<uint64_t>(low, dSlots_.size());
+      if (headroom > 0 && fits(low - headroom, high, occupied)) {
+        low -= headroom;
+      }
+      std::vector<Slot> slots(dBase_ - low);
+      std::move(dSlots_.begin(), dSlots_.end(), std::back_inserter(slots));
+      dSlots_ = std::move(slots);
+      dBase_ = low;
+    } else {
+      dSlots_.resize(high - low + 1);
+    }
+    return &dSlots_[code - dBase_];
+  }
+};
+
+/**
+ * \class CardinalityPlanner
+ * \brief Chooses the algorithm of the distinct and grouping operators from the first SAMPLE keys of their input.
+ *
+ * The number of distinct keys of the sample is estimated with a HyperLogLog of 2^10 registers, counted exactly for keys without std::hash, and the range of integral and enum keys is tracked:
+ * - dense, an array indexed by the key, when integral or enum keys span at most DENSE_FACTOR slots per distinct key of the sample
+ * - hash, a hash table, when at most half of the sampled keys are distinct, so the table stays small
+ * - sort, sorting all keys at once, when most keys are distinct and a table would hold nearly every key anyway
+ * - tree, the ordered set, when keys have no std::hash
+ * @tparam K type of keys
+ */
+template<typename K>
+class CardinalityPlanner {
+ public:
+  static constexpr size_t SAMPLE = 1024;
+
+  void add(const K &key) {
+    if constexpr (DenseKey<K>::supported()) {
+      auto code = DenseKey<K>::encode(key);
+      dLow_ = dSampled_ == 0 ? code : std::min(dLow_, code);
+      dHigh_ = dSampled_ == 0 ? code : std::max(dHigh_, code);
+    }
+    if constexpr (IsHashable<K>::value) {
+      dSketch_.add(mixHash(std::hash<K>()(key)));
+    } else {
+      dKeys_.insert(key);
+    }
+    ++dSampled_;
+  }
+
+  bool full() const { return dSampled_ >= SAMPLE; }
+
+  size_t sampled() const { return dSampled_; }
+
+  size_t estimatedDistinct() const {
+    if constexpr (IsHashable<K>::value) {
+      auto estimate = static_cast<size_t>(dSketch_.estimate() + 0.5);
+      return std::clamp<size_t>(estimate, std::min<size_t>(dSampled_, 1), dSampled_);
+    } else {
+      return dKeys_.size();
+    }
+  }
+
+  uint64_t low() const { return dLow_; }
+
+  uint64_t high() const { return dHigh_; }
+
+  /**
+   * \fn bool dense()
+   * \brief Whether the sampled keys are integral or enum and dense enough for an array indexed by the key.
+   */
+  bool dense() const {
+    if constexpr (DenseKey<K>::supported()) {
+      return dSampled_ > 0 && DenseSlots<K, char>::fits(dLow_, dHigh_, estimatedDistinct());
+    } else {
+      return false;
+    }
+  }
+
+  /**
+   * \fn const char *distinctStrategy()
+   * \brief Algorithm of distinct elements for the sample, "dense", "hash", "sort" or "tree".
+   */
+  const char *distinctStrategy() const {
+    if (dense()) {
+      return "dense";
+    }
+    if (2 * estimatedDistinct() > dSampled_) {
+      return "sort";
+    }
+    return IsHashable<K>::value ? "hash" : "tree";
+  }
+
+  /**
+   * \fn StrategyChoice choice(const char *strategy)
+   * \brief Reports a strategy chosen from the sample.
+   */
+  StrategyChoice choice(const char *strategy) const {
+    return StrategyChoice{strategy, dSampled_, estimatedDistinct()};
+  }
+
+ private:
+  size_t dSampled_ = 0;
+  uint64_t dLow_ = 0;
+  uint64_t dHigh_ = 0;
+  HyperLogLog dSketch_{10};
+  std::set<K> dKeys_;
+};
+
+/**
+ * \fn std::vector<T> distinctSorted(iterators::Iterator<T> &upstream, StrategyChoice &choice)
+ * \brief Takes the remaining elements of an iterator and returns the distinct ones in ascending order, with the algorithm chosen by a CardinalityPlanner from the first elements, see Stream::distinct().
+ *
+ * A dense array falls back to sorting when later keys are too sparse for it.
+ * @tparam T type of elements, ordered by operator<
+ * @param upstream iterator of elements
+ * @param choice receives the algorithm used
+ * @return distinct elements in ascending order
+ */
+template<typename T>
+std::vector<T> distinctSorted(iterators::Iterator<T> &upstream, StrategyChoice &choice) {
+  CardinalityPlanner<T> planner;
+  std::vector<T> elements;
+  while (!planner.full() && upstream.hasNext()) {
+    elements.emplace_back(upstream.take().value());
+    planner.add(elements.back());
+  }
+  const char *strategy = planner.distinctStrategy();
+  choice = planner.choice(strategy);
+  if constexpr (DenseKey<T>::supported()) {
+    if (strategy == std::string_view("dense")) {
+      DenseSlots<T, char> slots(planner.low(), planner.high());
+      size_t occupied = 0;
+      auto insert = [&slots, &occupied](const T &element) {
+        auto *slot = slots.find(element, occupied);
+        if (slot != nullptr && *slot == 0) {
+          *slot = 1;
+          ++occupied;
+        }
+        return slot != nullptr;
+      };
+      for (const auto &element : elements) {
+        insert(element);
+      }
+      std::optional<T> sparse;
+      while (upstream.hasNext()) {
+        auto element = upstream.take().value();
+        if (!insert(element)) {
+          sparse = std::move(element);
+          break;
+        }
+      }
+      elements.clear();
+      slots.forEach([&elements](T key, char present) {
+        if (present != 0) {
+          elements.emplace_back(key);
+        }
+      });
+      if (!sparse) {
+        return elements;
+      }
+      elements.emplace_back(*sparse);
+      choice.strategy = strategy = "sort";
+    }
+  }
+  if constexpr (IsHashable<T>::value) {
+    if (strategy == std::string_view("hash")) {
+      std::unordered_set<T> set(std::make_move_iterator(elements.begin()), std::make_move_iterator(elements.end()), 2 * choice.estimatedDistinct);
+      while (upstream.hasNext()) {
+        set.insert(upstream.take().value());
+      }
+      elements.clear();
+      elements.reserve(set.size());
+      for (auto node = set.begin(); node != set.end();) {
+        elements.emplace_back(std::move(set.extract(node++).value()));
+      }
+      std::sort(elements.begin(), elements.end());
+      return elements;
+    }
+  }
+  if (strategy == std::string_view("tree")) {
+    std::set<T> set(std::make_move_iterator(elements.begin()), std::make_move_iterator(elements.end()));
+    while (upstream.hasNext()) {
+      set.insert(upstream.take().value());
+    }
+    elements.clear();
+    for (auto node = set.begin(); node != set.end();) {
+      elements.emplace_back(std::move(set.extract(node++).value()));
+    }
+    return elements;
+  }
+  while (upstream.hasNext()) {
+    elements.emplace_back(upstream.take().value());
+  }
+  std::sort(elements.begin(), elements.end());
+  elements.erase(std::unique(elements.begin(), elements.end(), [](const T &left, const T &right) { return !(left < right); }), elements.end());
+  return elements;
+}
+
+/**
+ * \class DistinctIterator
+ * \brief Pipeline stage yielding the distinct upstream elements in ascending order, see distinctSorted(). The upstream is drained and the algorithm chosen on first access only, so a profiled stage accounts the planning and deduplication time.
+ * @tparam T element type, ordered by operator<
+ */
+template<typename T>
+struct DistinctIterator : public iterators::Iterator<T> {
+  DistinctIterator(std::unique_ptr<iterators::Iterator<T>> upstream, std::shared_ptr<StrategyChoice> choice) : dUpstream_(std::move(upstream)), dChoice_(std::move(choice)) {}
+
+  ~DistinctIterator() override = default;
+
+  inline bool hasNext() override {
+    if (!dBuffered_) {
+      dElements_ = distinctSorted(*dUpstream_, *dChoice_);
+      dBuffered_ = true;
+    }
+    return dPosition_++ < dElements_.size();
+  }
+
+  inline std::optional<T> next() override {
+    if constexpr (!std::is_copy_constructible_v<T>) {
+      return take();
+    } else {
+      return dPosition_ > 0 && dPosition_ <= dElements_.size() ? std::optional<T>{dElements_[dPosition_ - 1]} : std::nullopt;
+    }
+  }
+
+  inline std::optional<T> take() override {
+    return dPosition_ > 0 && dPosition_ <= dElements_.size() ? std::optional<T>{std::move(dElements_[dPosition_ - 1])} : std::nullopt;
+  }
+
+  inline void reset() override {
+    dUpstream_->reset();
+    dElements_.clear();
+    dBuffered_ = false;
+    dPosition_ = 0;
+  }
+
+ private:
+  std::unique_ptr<iterators::Iterator<T>> dUpstream_;
+  std::shared_ptr<StrategyChoice> dChoice_;
+  std::vector<T> dElements_;
+  bool dBuffered_ = false;
+  size_t dPosition_ = 0;
+};
+
+/**
+ * \class AdaptiveGroups
+ * \brief Groups of elements by key which choose their layout from the first SAMPLE elements, see Collectors::groupingBy() and Stream::groupedBy().
+ *
+ * The first elements are buffered while a CardinalityPlanner samples their keys. Integral and enum keys dense enough are then grouped in an array indexed by the key, moving to the hash table of the result when a later key is too sparse, and other keys go to the hash table of the result reserved for the estimated number of keys.
+ * @tparam K type of keys
+ * @tparam T type of elements
+ * @tparam Groups unordered map of keys to vectors of elements, the result
+ */
+template<typename K, typename T, typename Groups>
+class AdaptiveGroups {
+ public:
+  explicit AdaptiveGroups(Groups groups) : dGroups_(std::move(groups)) {}
+
+  /**
+   * \fn void add(K key, E &&element)
+   * \brief Appends an element to the group of its key.
+   */
+  template<typename E>
+  void add(K key, E &&element) {
+    auto *group = find(key);
+    if (group != nullptr) {
+      group->emplace_back(std::forward<E>(element));
+    } else if (dPhase_ == Phase::SAMPLING) {
+      dPlanner_.add(key);
+      dSample_.emplace_back(std::move(key), std::forward<E>(element));
+      if (dPlanner_.full()) {
+        plan();
+      }
+    } else {
+      dGroups_[std::move(key)].emplace_back(std::forward<E>(element));
+    }
+  }
+
+  /**
+   * \fn void merge(AdaptiveGroups &other)
+   * \brief Moves the groups of other into these groups, the elements of other following the elements of the same key.
+   */
+  void merge(AdaptiveGroups &other) {
+    for (auto &[key, element] : other.dSample_) {
+      add(std::move(key), std::move(element));
+    }
+    other.dSample_.clear();
+    if (other.dPhase_ == Phase::SAMPLING) {
+      return;
+    }
+    if (dPhase_ == Phase::SAMPLING) {
+      plan();
+    }
+    other.forEachGroup([this](K key, std::vector<T> &elements) {
+      auto *group = find(key);
+      if (group == nullptr) {
+        group = &dGroups_[std::move(key)];
+      }
+      std::move(elements.begin(), elements.end(), std::back_inserter(*group));
+    });
+  }
+
+  /**
+   * \fn Groups finish()
+   * \brief Moves the groups out.
+   */
+  Groups finish() {
+    if (dPhase_ == Phase::SAMPLING) {
+      plan();
+    }
+    toHash();
+    return std::move(dGroups_);
+  }
+
+  const StrategyChoice &choice() const { return dChoice_; }
+
+ private:
+  enum class Phase { SAMPLING,
+                     DENSE,
+                     HASH };
+
+  static constexpr bool denseCapable() {
+    return DenseKey<K>::supported() && std::is_same_v<typename Groups::key_equal, std::equal_to<K>>;
+  }
+
+  using Slots = std::conditional_t<denseCapable(), DenseSlots<K, std::vector<T>>, char>;
+
+  void plan() {
+    if constexpr (denseCapable()) {
+      if (dPlanner_.dense()) {
+        dSlots_ = Slots(dPlanner_.low(), dPlanner_.high());
+        dPhase_ = Phase::DENSE;
+        dChoice_ = dPlanner_.choice("dense");
+      }
+    }
+    if (dPhase_ == Phase::SAMPLING) {
+      dGroups_.reserve(dPlanner_.estimatedDistinct());
+      dPhase_ = Phase::HASH;
+      dChoice_ = dPlanner_.choice("hash");
+    }
+    auto sample = std::move(dSample_);
+    dSample_.clear();
+    for (auto &[key, element] : sample) {
+      add(std::move(key), std::move(element));
+    }
+  }
+
+  std::vector<T> *find(const K &key) {
+    if constexpr (denseCapable()) {
+      if (dPhase_ == Phase::DENSE) {
+        auto *group = dSlots_.find(key, dOccupied_);
+        if (group == nullptr) {
+          toHash();
+          dChoice_.strategy = "hash";
+        } else if (group->empty()) {
+          ++dOccupied_;
+        }
+        return group;
+      }
+    }
+    return nullptr;
+  }
+
+  void toHash() {
+    if constexpr (denseCapable()) {
+      if (dPhase_ == Phase::DENSE) {
+        dGroups_.reserve(dOccupied_);
+        dSlots_.forEach([this](K key, std::vector<T> &elements) {
+          if (!elements.empty()) {
+            dGroups_.try_emplace(std::move(key), std::move(elements));
+          }
+        });
+        dSlots_ = Slots();
+        dPhase_ = Phase::HASH;
+      }
+    }
+  }
+
+  template<typename F>
+  void forEachGroup(F &&consumer) {
+    if constexpr (denseCapable()) {
+      if (dPhase_ == Phase::DENSE) {
+        dSlots_.forEach([&consumer](K key, std::vector<T> &elements) {
+          if (!elements.empty()) {
+            consumer(std::move(key), elements);
+          }
+        });
+        return;
+      }
+    }
+    for (auto &[key, elements] : dGroups_) {
+      consumer(key, elements);
+    }
+  }
+
+  Groups dGroups_;
+  Phase dPhase_ = Phase::SAMPLING;
+  CardinalityPlanner<K> dPlanner_;
+  std::vector<std::pair<K, T>> dSample_;
+  Slots dSlots_{};
+  size_t dOccupied_ = 0;
+  StrategyChoice dChoice_;
+};
+}// namespace aalbatross::utils::streams
+#endif//INCLUDED_STREAMS4CPP_STRATEGY_H_
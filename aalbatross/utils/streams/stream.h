@@ -1,12 +1,18 @@
 #ifndef INCLUDED_STREAMS4CPP_STREAM_H_
 #define INCLUDED_STREAMS4CPP_STREAM_H_
+#include "aalbatross/utils/collection/streamablewindow.h"
 #include "aalbatross/utils/iterators/iterator.h"
 #include "aalbatross/utils/iterators/listiterator.h"
 #include "aalbatross/utils/iterators/listiterator_view.h"
+#include "aalbatross/utils/iterators/pipeline_iterator.h"
+#include "cache.h"
 #include "collector.h"
+#include "profile.h"
+#include "strategy.h"
 
 #include <algorithm>
 #include <deque>
+#include <functional>
 #include <list>
 #include <map>
 #include <memory>
@@ -14,8 +20,12 @@
 #include <set>
 #include <unordered_map>
 #include <unordered_set>
+#include <utility>
 #include <vector>
 namespace aalbatross::utils::streams {
+template<typename T, typename KeyMapper, typename... Aggregate>
+class AggregationState;
+
 /**
  * \class Stream
  * \brief A sequence of elements supporting sequential and parallel aggregate operations on bound container.
@@ -63,62 +73,68 @@ struct Stream {
 
   Stream(std::shared_ptr<iterators::Iterator<S>> source,
          std::function<std::unique_ptr<iterators::Iterator<T>>(iterators::Iterator<S> &)> mapper)
-      : dMapper_(std::move(mapper)), dSource_(source) {}
+      : dMapper_(std::move(mapper)), dSource_(source), dPlan_{"source"} {}
 
   explicit Stream(std::shared_ptr<iterators::Iterator<S>> &&source) : dSource_(std::forward<std::shared_ptr<iterators::Iterator<S>>>(source)) {
     std::function<std::unique_ptr<iterators::Iterator<T>>(iterators::Iterator<S> &)> mapper =
         [](iterators::Iterator<S> &source) {
-          std::vector<S> result;
-          while (source.hasNext()) {
-            result.emplace_back(source.next().value());
-          }
-          return std::make_unique<iterators::ListIteratorView<std::vector<S>>>(result);
+          return std::make_unique<iterators::SourceIterator<S>>(source);
         };
-    dMapper_ = mapper;
+    dMapper_ = instrument("source", mapper);
   }
 
   template<typename Iter>
   explicit Stream(Iter &&begin, Iter &&end) : dSource_(std::make_shared<iterators::ListIterator<Iter>>(std::forward<Iter>(begin), std::forward<Iter>(end))) {
     std::function<std::unique_ptr<iterators::Iterator<T>>(iterators::Iterator<S> &)> mapper =
         [](iterators::Iterator<S> &source) {
-          std::vector<S> result;
-          while (source.hasNext()) {
-            result.emplace_back(source.next().value());
-          }
-          return std::make_unique<iterators::ListIteratorView<std::vector<S>>>(result);
+          return std::make_unique<iterators::SourceIterator<S>>(source);
         };
-    dMapper_ = mapper;
+    dMapper_ = instrument("source", mapper);
   }
 
   /**
-   * \fn bool allMatch(std::function<bool(T)> predicate)
+   * \fn Stream<T, S> of(Container container)
+   * \brief Creates a stream owning the elements of a container. Unlike the streams over a pair of iterators, which copy every element out of a container that stays in the scope of the caller, the elements are moved from stage to stage and into the result of the terminal operation, so move-only types like std::unique_ptr are supported.
+   *
+   * The stream is consumable: the first terminal operation moves the elements out, the next ones see an empty stream. Pass the container with std::move to avoid copying it.
+   * @tparam Container type of container holding elements of type S
+   * @param container the elements of the stream
+   * @return a new stream
+   */
+  template<typename Container>
+  static Stream<T, S> of(Container container) {
+    return Stream<T, S>(std::shared_ptr<iterators::Iterator<S>>(std::make_shared<iterators::ListIteratorView<Container, S>>(std::move(container), true)));
+  }
+
+  /**
+   * \fn bool allMatch(std::function<bool(const T &)> predicate)
    * \brief Returns whether all elements of this stream match the provided predicate. May not evaluate the predicate on all elements if not necessary for determining the result. If the stream is empty then true is returned and the predicate is not evaluated.
    * @param predicate  stateless predicate to apply to elements of this stream
    * @return     true if either all elements of the stream match the provided predicate or the stream is empty, otherwise false
    */
-  bool allMatch(std::function<bool(T)> predicate) {
+  bool allMatch(std::function<bool(const T &)> predicate) {
     auto vec = toVector();
     return std::all_of(vec.begin(), vec.end(), predicate);
   }
 
   /**
-   * \fn bool anyMatch(std::function<bool(T)> predicate)
+   * \fn bool anyMatch(std::function<bool(const T &)> predicate)
    * \brief Returns whether any elements of this stream match the provided predicate. May not evaluate the predicate on all elements if not necessary for determining the result. If the stream is empty then false is returned and the predicate is not evaluated.
    * @param predicate stateless predicate to apply to elements of this stream
    * @return     true if any elements of the stream match the provided predicate, otherwise false
    */
-  bool anyMatch(std::function<bool(T)> predicate) {
+  bool anyMatch(std::function<bool(const T &)> predicate) {
     auto vec = toVector();
     return std::any_of(vec.begin(), vec.end(), predicate);
   }
 
   /**
-   * \fn bool noneMatch(std::function<bool(T)> predicate)
+   * \fn bool noneMatch(std::function<bool(const T &)> predicate)
    * \brief Returns whether no elements of this stream match the provided predicate. May not evaluate the predicate on all elements if not necessary for determining the result. If the stream is empty then true is returned and the predicate is not evaluated.
    * @param predicate stateless predicate to apply to elements of this stream
    * @return     true if either no elements of the stream match the provided predicate or the stream is empty, otherwise false
    */
-  bool noneMatch(std::function<bool(T)> predicate) {
+  bool noneMatch(std::function<bool(const T &)> predicate) {
     auto vec = toVector();
     return std::none_of(vec.begin(), vec.end(), predicate);
   }
@@ -130,7 +146,7 @@ struct Stream {
    */
   std::optional<T> head() {
     auto vec = toVector();
-    return vec.empty() ? std::optional<T>() : std::optional<T>(vec.front());
+    return vec.empty() ? std::optional<T>() : std::optional<T>(std::move(vec.front()));
   }
 
   /**
@@ -140,38 +156,42 @@ struct Stream {
    */
   std::optional<T> tail() {
     auto vec = toVector();
-    return vec.empty() ? std::optional<T>() : std::optional<T>(vec.back());
+    return vec.empty() ? std::optional<T>() : std::optional<T>(std::move(vec.back()));
   }
 
   /**
-   * \fn std::optional<T> find(std::function<bool(T)> predicate)
+   * \fn std::optional<T> find(std::function<bool(const T &)> predicate)
    * \brief Finds the first element of the sequence satisfying a predicate, if any.
    * @param predicate stateless predicate to apply to elements of this stream
    * @return an Optional describing the first element of this stream which matches with this predicate, or an empty Optional if the stream is empty
    */
-  std::optional<T> find(std::function<bool(T)> predicate) {
+  std::optional<T> find(std::function<bool(const T &)> predicate) {
     auto vec = toVector();
     auto iterator = std::find_if(vec.begin(), vec.end(), predicate);
-    return iterator != vec.end() ? std::optional<T>(*iterator) : std::optional<T>{};
+    return iterator != vec.end() ? std::optional<T>(std::move(*iterator)) : std::optional<T>{};
   }
 
   /**
    * \fn std::unordered_map<K, std::vector<T>> groupedBy(Discriminator &&discriminator)
    * \brief Partitions this traversable collection into a map of traversable collections according to some discriminator function.
+   *
+   * The groups are laid out according to the keys of the first elements, see AdaptiveGroups: integral and enum keys dense enough are grouped in an array indexed by the key, other keys in a hash table reserved for their estimated number. The layout chosen is reported by explain() as a "groupedBy" stage once the grouping has run.
    * @tparam Discriminator It is the type of Function which when applied with element of stream returns Discriminator
    * @param discriminator It is definition of function to identify the key discriminator based on elements of stream
    * @return An unordered map with key as discriminator and a vector of the stream elements.
    */
   template<typename Discriminator>
   auto groupedBy(Discriminator &&discriminator) {
-    auto vec = toVector();
     using K = typename std::invoke_result<Discriminator, T>::type;
-    std::unordered_map<K, std::vector<T>> output;
-    for (auto element : vec) {
-      K key = discriminator(element);
-      output.try_emplace(key, std::vector<T>());
-      output[key].emplace_back(element);
+    AdaptiveGroups<K, T, std::unordered_map<K, std::vector<T>>> groups{std::unordered_map<K, std::vector<T>>{}};
+    dSource_->reset();
+    auto result = dMapper_(*dSource_);
+    while (result->hasNext()) {
+      auto element = result->take().value();
+      groups.add(discriminator(std::as_const(element)), std::move(element));
     }
+    auto output = groups.finish();
+    dGrouping_ = std::make_shared<StrategyChoice>(groups.choice());
     return output;
   }
 
@@ -184,39 +204,44 @@ struct Stream {
    */
   template<typename Fun>
   auto map(Fun &&mapper) {
-    using E = typename std::invoke_result<Fun, S>::type;
+    using E = typename std::invoke_result<Fun, T>::type;
     std::function<std::unique_ptr<iterators::Iterator<E>>(iterators::Iterator<S> &)> newMapper =
         [mapper, *this](iterators::Iterator<S> &source) {
-          auto inter = dMapper_(source);
-          std::vector<E> result;
-          while (inter->hasNext()) {
-            result.emplace_back(mapper(inter->next().value()));
-          }
-          return std::make_unique<iterators::ListIteratorView<std::vector<E>>>(result);
+          return std::make_unique<iterators::MapIterator<T, E, std::decay_t<Fun>>>(dMapper_(source), mapper);
         };
-    return Stream<E, S>(dSource_, newMapper);
+    return then<E>("map", newMapper);
   }
 
   /**
-   * \fn Stream<T, S> filter(std::function<bool(T)> predicate)
+   * \fn Stream<T, S> filter(std::function<bool(const T &)> predicate)
    * \brief Selects all elements of this stream which satisfy a predicate.
    * @param predicate stateless predicated which is applied to all elements of stream.
    * @return Stream of filtered elements as per predicate.
    */
-  Stream<T, S> filter(std::function<bool(T)> predicate) {
+  Stream<T, S> filter(std::function<bool(const T &)> predicate) {
     std::function<std::unique_ptr<iterators::Iterator<T>>(iterators::Iterator<S> &)> newMapper =
         [*this, predicate](iterators::Iterator<S> &source) {
-          auto inter = dMapper_(source);
-          std::vector<T> result;
-          while (inter->hasNext()) {
-            const auto element = inter->next().value();
-            if (predicate(element)) {
-              result.emplace_back(element);
-            }
-          }
-          return std::make_unique<iterators::ListIteratorView<std::vector<T>>>(result);
+          return std::make_unique<iterators::FilterIterator<T, std::function<bool(const T &)>>>(dMapper_(source), predicate);
         };
-    return Stream<T, S>(dSource_, newMapper);
+    return then<T>("filter", newMapper);
+  }
+
+  /**
+   * \fn Stream<T, S> filterMightContain(Filter membership)
+   * \brief Selects the elements of this stream which might be contained in a membership filter, like the BloomFilter produced by Collectors::bloomFilter(). Elements of the filter are always selected, other elements with its false positive probability.
+   * @tparam Filter type of filter providing bool mightContain(const T &)
+   * @param membership the filter, shared by all the copies of the stream
+   * @return Stream of elements which might be contained in the filter
+   */
+  template<typename Filter>
+  Stream<T, S> filterMightContain(Filter membership) {
+    auto shared = std::make_shared<const Filter>(std::move(membership));
+    std::function<bool(const T &)> predicate = [shared](const T &element) { return shared->mightContain(element); };
+    std::function<std::unique_ptr<iterators::Iterator<T>>(iterators::Iterator<S> &)> newMapper =
+        [*this, predicate](iterators::Iterator<S> &source) {
+          return std::make_unique<iterators::FilterIterator<T, std::function<bool(const T &)>>>(dMapper_(source), predicate);
+        };
+    return then<T>("mightContain", newMapper);
   }
 
   /**
@@ -228,16 +253,9 @@ struct Stream {
   Stream<T, S> limit(const size_t count) {
     std::function<std::unique_ptr<iterators::Iterator<T>>(iterators::Iterator<S> &)> newMapper =
         [*this, count](iterators::Iterator<S> &source) {
-          auto inter = dMapper_(source);
-          std::vector<T> result;
-          while (inter->hasNext()) {
-            if (result.size() < count) {
-              result.emplace_back(inter->next().value());
-            }
-          }
-          return std::make_unique<iterators::ListIteratorView<std::vector<T>>>(result);
+          return std::make_unique<iterators::LimitIterator<T>>(dMapper_(source), count);
         };
-    return Stream<T, S>(dSource_, newMapper);
+    return then<T>("limit", newMapper);
   }
 
   /**
@@ -249,73 +267,164 @@ struct Stream {
   Stream<T, S> skip(const size_t count) {
     std::function<std::unique_ptr<iterators::Iterator<T>>(iterators::Iterator<S> &)> newMapper =
         [*this, count](iterators::Iterator<S> &source) {
-          auto inter = dMapper_(source);
-          std::vector<T> result;
-          size_t currentCount = 0;
-          while (inter->hasNext()) {
-            if (currentCount >= count) {
-              result.emplace_back(inter->next().value());
-            }
-            currentCount++;
-          }
-          return std::make_unique<iterators::ListIteratorView<std::vector<T>>>(result);
+          return std::make_unique<iterators::SkipIterator<T>>(dMapper_(source), count);
         };
-    return Stream<T, S>(dSource_, newMapper);
+    return then<T>("skip", newMapper);
   }
 
   /**
-   * \fn Stream<T, S> sorted(std::function<int(T, T)> comparator)
+   * \fn Stream<T, S> sorted(std::function<int(const T &, const T &)> comparator)
    * \brief Returns a stream consisting of the elements of this stream, sorted according to comparator.
    * @param comparator  stateless Comparator to be used to compare stream elements
    * @return new stream
    */
-  Stream<T, S> sorted(std::function<int(T, T)> comparator) {
+  Stream<T, S> sorted(std::function<int(const T &, const T &)> comparator) {
     std::function<std::unique_ptr<iterators::Iterator<T>>(iterators::Iterator<S> &)> newMapper =
         [*this, comparator](iterators::Iterator<S> &source) {
-          auto inter = dMapper_(source);
-          std::vector<T> result;
-          while (inter->hasNext()) {
-            result.emplace_back(inter->next().value());
-          }
-          std::sort(result.begin(), result.end(), comparator);
-          return std::make_unique<iterators::ListIteratorView<std::vector<T>>>(result);
+          return std::make_unique<iterators::SortedIterator<T, std::function<int(const T &, const T &)>>>(dMapper_(source), comparator);
         };
-    return Stream<T, S>(dSource_, newMapper);
+    return then<T>("sorted", newMapper);
   }
   /**
    * \fn Stream<T, S> distinct()
    * \brief Returns a stream consisting of the distinct elements (according to element1 == element2) of this stream.
+   *
+   * Elements come out in ascending order. The algorithm is chosen from the first elements, see CardinalityPlanner: an array indexed by the element for integral and enum elements dense enough, a hash table when there are many duplicates, otherwise a sort; explain() and profile() report the choice once the stream has run.
+   * The sample is taken and the algorithm chosen when the first element is pulled, so profile() reports the cost of the choice with the distinct stage.
    * @return new stream with unique elements.
    */
   Stream<T, S> distinct() {
+    auto choice = std::make_shared<StrategyChoice>();
     std::function<std::unique_ptr<iterators::Iterator<T>>(iterators::Iterator<S> &)> newMapper =
-        [*this](iterators::Iterator<S> &source) {
-          auto inter = dMapper_(source);
-          std::set<T> result;
-          while (inter->hasNext()) {
-            result.emplace(inter->next().value());
-          }
-          return std::make_unique<iterators::ListIteratorView<std::set<T>>>(result);
+        [*this, choice](iterators::Iterator<S> &source) {
+          return std::make_unique<DistinctIterator<T>>(dMapper_(source), choice);
         };
-    return Stream<T, S>(dSource_, newMapper);
+    return then<T>("distinct", newMapper, choice);
   }
   /**
    * \fn Stream<T, S> reverse()
    * \brief AType list consisting of all elements of this list in reverse order.
+   *
+   * When the source is bidirectional (vector, deque, list, map, set...) and every prior stage is element-wise (map, filter), the source is traversed backwards lazily, otherwise the elements are buffered and replayed in reverse.
    * @return a new stream representing original stream elements in reverse order.
    */
   Stream<T, S> reverse() {
     std::function<std::unique_ptr<iterators::Iterator<T>>(iterators::Iterator<S> &)> newMapper =
-        [*this](iterators::Iterator<S> &source) {
+        [*this](iterators::Iterator<S> &source) -> std::unique_ptr<iterators::Iterator<T>> {
           auto inter = dMapper_(source);
-          std::vector<T> result;
-          while (inter->hasNext()) {
-            result.emplace_back(inter->next().value());
+          if (auto reversed = inter->reversed(); reversed) {
+            return reversed;
           }
-          std::reverse(result.begin(), result.end());
-          return std::make_unique<iterators::ListIteratorView<std::vector<T>>>(result);
+          return std::make_unique<iterators::ReverseIterator<T>>(std::move(inter));
+        };
+    return then<T>("reverse", newMapper);
+  }
+
+  /**
+   * \fn Stream<collection::SWindow<T>, S> chunked(size_t size)
+   * \brief Groups elements in non overlapping blocks of provided size, the last block holds the remaining elements and may be smaller.
+   *
+   * Blocks are views into a buffer reused for every block, a block is valid until the next block is pulled, so consume it (for example with map) or copy it with SWindow::toVector().
+   * @param size number of elements in a block, must be positive
+   * @return a new stream of windows
+   */
+  Stream<collection::SWindow<T>, S> chunked(size_t size) {
+    std::function<std::unique_ptr<iterators::Iterator<collection::SWindow<T>>>(iterators::Iterator<S> &)> newMapper =
+        [*this, size](iterators::Iterator<S> &source) {
+          return std::make_unique<iterators::WindowIterator<T>>(dMapper_(source), size, size, true);
         };
-    return Stream<T, S>(dSource_, newMapper);
+    return then<collection::SWindow<T>>("chunked", newMapper);
+  }
+
+  /**
+   * \fn Stream<collection::SWindow<T>, S> sliding(size_t size, size_t step = 1)
+   * \brief Groups elements in fixed size blocks by passing a "sliding window" over them, moving the window by step elements. Only complete windows are emitted.
+   *
+   * Windows are views into a buffer reused for every window, no allocation happens per window. A window is valid until the next window is pulled, so consume it (for example with map) or copy it with SWindow::toVector().
+   * @param size number of elements in a window, must be positive
+   * @param step number of elements the window moves by, must be positive
+   * @return a new stream of windows
+   */
+  Stream<collection::SWindow<T>, S> sliding(size_t size, size_t step = 1) {
+    std::function<std::unique_ptr<iterators::Iterator<collection::SWindow<T>>>(iterators::Iterator<S> &)> newMapper =
+        [*this, size, step](iterators::Iterator<S> &source) {
+          return std::make_unique<iterators::WindowIterator<T>>(dMapper_(source), size, step, false);
+        };
+    return then<collection::SWindow<T>>("sliding", newMapper);
+  }
+
+  /**
+   * \fn auto groupingBySorted(Classifier &&classifier, Collector<Supplier, Accumulator, Finisher, Combiner> &&collector, bool validate = false, Compare cmp = Compare())
+   * \brief Groups a stream already sorted by key, like the stream of a SMap or of time ordered records, returning a stream of the key and the result of the collector for every group.
+   *
+   * A group is emitted as soon as the key changes, so only the group being collected is held instead of a map of all groups like groupingByOrdered(). On unsorted input a key seen before starts a new group; set validate to throw std::invalid_argument instead when a key is ordered before the previous key.
+   * // Total of every day of time ordered trades <br/>
+   *    auto daily = trades.stream().groupingBySorted([](const auto &trade){return trade.day;}, Collectors::summingDouble([](const auto &trade){return trade.amount;}));
+   * @tparam Classifier type of function mapping elements to keys
+   * @tparam Compare ordering of keys, keys are equal when neither is ordered before the other
+   * @param classifier
+   * @param collector reduces the elements of a group
+   * @param validate whether to check that keys are in ascending order
+   * @param cmp
+   * @return a new stream of std::pair of key and result of the collector
+   */
+  template<typename Classifier, typename Supplier, typename Accumulator, typename Finisher, typename Combiner, typename K = std::decay_t<std::invoke_result_t<Classifier, const T &>>, typename Compare = std::less<K>>
+  auto groupingBySorted(Classifier &&classifier, Collector<Supplier, Accumulator, Finisher, Combiner> &&collector, bool validate = false, Compare cmp = Compare()) {
+    using Downstream = Collector<Supplier, Accumulator, Finisher, Combiner>;
+    using R = decltype(collector.finish(std::declval<decltype(collector.supply()) &>()));
+    using Group = iterators::SortedGroupIterator<T, K, R, std::decay_t<Classifier>, Downstream, Compare>;
+    std::function<std::unique_ptr<iterators::Iterator<std::pair<K, R>>>(iterators::Iterator<S> &)> newMapper =
+        [*this, classifier = std::forward<Classifier>(classifier), downstream = std::move(collector), cmp, validate](iterators::Iterator<S> &source) {
+          return std::make_unique<Group>(dMapper_(source), classifier, downstream, cmp, validate);
+        };
+    return then<std::pair<K, R>>("groupingBySorted", newMapper);
+  }
+
+  /**
+   * \fn Stream<T, S> cache()
+   * \brief Returns a stream memoizing the elements of this stream. The first terminal operation runs the pipeline once into a compact buffer, the next terminal operations (and the streams derived from the returned one) are served from the buffer without visiting the source again.
+   *
+   * The buffer is released by invalidate(), the memory it holds is reported by cachedBytes() and, for all the caches of the process, by CacheControl::totalBytes().
+   * @return a new stream backed by the cache
+   */
+  Stream<T, S> cache() {
+    auto cache = std::make_shared<StreamCache<T>>();
+    std::function<std::unique_ptr<iterators::Iterator<T>>(iterators::Iterator<S> &)> newMapper =
+        [*this, cache](iterators::Iterator<S> &source) {
+          return std::make_unique<iterators::BufferIterator<T>>(cache->load([this, &source]() {
+            auto inter = dMapper_(source);
+            std::vector<T> elements;
+            if (auto size = inter->size(); size.has_value()) {
+              elements.reserve(size.value());
+            }
+            while (inter->hasNext()) {
+              elements.emplace_back(inter->take().value());
+            }
+            return elements;
+          }));
+        };
+    auto stream = then<T>("cache", newMapper);
+    stream.dCache_ = cache;
+    return stream;
+  }
+
+  /**
+   * \fn void invalidate()
+   * \brief Releases the elements memoized by the nearest cache() of this stream pipeline, the next terminal operation recomputes them. Does nothing if the pipeline has no cache.
+   */
+  void invalidate() {
+    if (dCache_) {
+      dCache_->invalidate();
+    }
+  }
+
+  /**
+   * \fn size_t cachedBytes()
+   * \brief Bytes held by the nearest cache() of this stream pipeline.
+   * @return bytes held, 0 if the pipeline has no cache or nothing is cached yet
+   */
+  size_t cachedBytes() const {
+    return dCache_ ? dCache_->bytes() : 0;
   }
 
   /**
@@ -326,7 +435,7 @@ struct Stream {
   std::optional<T> max() {
     std::vector<T> vec = toVector();
     auto iterator = std::max_element(vec.begin(), vec.end());
-    return iterator != vec.end() ? std::optional<T>(*iterator) : std::optional<T>{};
+    return iterator != vec.end() ? std::optional<T>(std::move(*iterator)) : std::optional<T>{};
   }
 
   /**
@@ -337,7 +446,7 @@ struct Stream {
   std::optional<T> min() {
     std::vector<T> vec = toVector();
     auto iterator = std::min_element(vec.begin(), vec.end());
-    return iterator != vec.end() ? std::optional<T>(*iterator) : std::optional<T>{};
+    return iterator != vec.end() ? std::optional<T>(std::move(*iterator)) : std::optional<T>{};
   }
 
   /**
@@ -350,10 +459,51 @@ struct Stream {
     return reduce(T{}, sumAccumulator);
   }
 
-  template<typename Supplier, typename Accumulator, typename Finisher>
-  auto collect(Collector<Supplier, Accumulator, Finisher> &&collector) {
-    std::vector<T> vec = std::move(toVector());
-    return collector.apply(vec);
+  /**
+   * \fn auto collect(Collector<Supplier, Accumulator, Finisher, Combiner> &&collector)
+   * \brief Performs a mutable reduction operation on the elements of this stream using a Collector. Elements are accumulated one at a time as they flow out of the pipeline, so the stream is never stored as a whole. Counting collectors are answered by count() without visiting the elements of sized pipelines.
+   * @tparam Supplier
+   * @tparam Accumulator
+   * @tparam Finisher
+   * @tparam Combiner
+   * @param collector
+   * @return result from the collector
+   */
+  template<typename Supplier, typename Accumulator, typename Finisher, typename Combiner>
+  auto collect(Collector<Supplier, Accumulator, Finisher, Combiner> &&collector) {
+    auto container = collector.supply();
+    if constexpr (std::is_same_v<Accumulator, CountingAccumulator>) {
+      container += count();
+    } else {
+      dSource_->reset();
+      auto result = dMapper_(*dSource_);
+      while (result->hasNext()) {
+        collector.accumulate(container, result->take().value());
+      }
+    }
+    return collector.finish(container);
+  }
+
+  /**
+   * \fn auto aggregateBy(KeyMapper &&keyMapper, Aggregate &&...aggregates)
+   * \brief Groups the elements of this stream by key and computes several aggregates of every group in a single pass, see Aggregates in aggregate.h.
+   *
+   * Aggregate states are stored column-wise, one contiguous array per aggregate indexed by the group id of the key, and are updated in place as every element arrives, elements are not copied.
+   * @tparam KeyMapper type of function extracting the key of the group
+   * @tparam Aggregate types of the aggregates
+   * @param keyMapper
+   * @param aggregates aggregates created by Aggregates, like Aggregates::sum() or Aggregates::count()
+   * @return AggregateTable with the key and the result of every aggregate for each group, in order of first appearance of the keys
+   */
+  template<typename KeyMapper, typename... Aggregate>
+  auto aggregateBy(KeyMapper &&keyMapper, Aggregate &&...aggregates) {
+    AggregationState<T, std::decay_t<KeyMapper>, std::decay_t<Aggregate>...> state(keyMapper, std::make_tuple(aggregates...));
+    dSource_->reset();
+    auto result = dMapper_(*dSource_);
+    while (result->hasNext()) {
+      state.add(result->take().value());
+    }
+    return state.finish();
   }
 
   /**
@@ -368,18 +518,21 @@ struct Stream {
     auto result = dMapper_(*dSource_);
     T output = identity;
     while (result->hasNext()) {
-      output = binaryAccumulator(output, result->next().value());
+      output = binaryAccumulator(std::move(output), result->take().value());
     }
     return output;
   }
   /**
    * \fn size_t count()
-   * \brief Returns the count of elements in this stream. This is a special case of a reduction and is equivalent to:
+   * \brief Returns the count of elements in this stream. When the source is sized and no stage changes the cardinality of the stream (map, sorted, reverse, limit, skip) the count is computed from the size of the source without visiting the elements, otherwise the elements are counted as they flow through the pipeline without being stored.
    * @return size of the stream.
    */
   size_t count() {
     dSource_->reset();
     auto result = dMapper_(*dSource_);
+    if (auto size = result->size(); size.has_value()) {
+      return size.value();
+    }
     size_t count = 0;
     while (result->hasNext()) {
       count++;
@@ -398,7 +551,7 @@ struct Stream {
     dSource_->reset();
     auto result = dMapper_(*dSource_);
     while (result->hasNext()) {
-      consumer(result->next().value());
+      consumer(result->take().value());
     }
   }
 
@@ -437,6 +590,49 @@ struct Stream {
    */
   auto toDeque() { return to<std::deque<T>>(); }
 
+  /**
+   * \fn PipelineProfile explain()
+   * \brief Describes the stages of this stream pipeline from the source to the last stage, without running it.
+   * @return report with the operator name of every stage
+   */
+  PipelineProfile explain() const {
+    PipelineProfile profile;
+    for (const char *name : dPlan_) {
+      profile.stages.emplace_back(StageProfile{name});
+    }
+    return withStrategies(std::move(profile));
+  }
+
+  /**
+   * \fn PipelineProfile profile()
+   * \brief Runs this stream pipeline to the end and reports, for every stage, its operator name, elements in and out, wall and cpu time and allocated bytes (see Profiler::recordAllocation).
+   *
+   * Statistics are recorded only when the library is compiled with STREAMS4CPP_PROFILING, otherwise the instrumentation compiles down to nothing and this is equivalent to explain().
+   * @return report of the stages
+   */
+  PipelineProfile profile() {
+#ifdef STREAMS4CPP_PROFILING
+    for (auto &stage : dStages_) {
+      *stage = StageProfile{stage->name};
+    }
+    CpuClock cpuClock;
+    dSource_->reset();
+    auto result = dMapper_(*dSource_);
+    while (result->hasNext()) {
+    }
+    PipelineProfile profile;
+    for (size_t i = 0; i < dStages_.size(); i++) {
+      StageProfile stage = *dStages_[i];
+      stage.elementsIn = i > 0 ? dStages_[i - 1]->elementsOut : stage.elementsOut;
+      profile.stages.emplace_back(std::move(stage));
+    }
+    profile.apportionCpuTime(cpuClock.elapsed());
+    return withStrategies(std::move(profile));
+#else
+    return explain();
+#endif
+  }
+
   /**
    * \fn StreamView<T, S> view()
    * \brief Creates Stream View which copies internal iterator
@@ -447,8 +643,62 @@ struct Stream {
   }
 
  private:
+  template<typename, typename>
+  friend struct Stream;
+
   std::function<std::unique_ptr<iterators::Iterator<T>>(iterators::Iterator<S> &)> dMapper_;
   std::shared_ptr<iterators::Iterator<S>> dSource_;
+  std::vector<const char *> dPlan_;
+  std::vector<std::shared_ptr<StrategyChoice>> dChoices_;
+  std::shared_ptr<StrategyChoice> dGrouping_;
+  std::shared_ptr<CacheControl> dCache_;
+#ifdef STREAMS4CPP_PROFILING
+  std::vector<std::shared_ptr<StageProfile>> dStages_;
+#endif
+
+  template<typename E>
+  Stream<E, S> then(const char *name, std::function<std::unique_ptr<iterators::Iterator<E>>(iterators::Iterator<S> &)> mapper, std::shared_ptr<StrategyChoice> choice = nullptr) {
+    Stream<E, S> stream(dSource_, std::move(mapper));
+    stream.dPlan_ = dPlan_;
+    stream.dChoices_ = dChoices_;
+    stream.dCache_ = dCache_;
+#ifdef STREAMS4CPP_PROFILING
+    stream.dStages_ = dStages_;
+#endif
+    stream.dMapper_ = stream.instrument(name, stream.dMapper_, std::move(choice));
+    return stream;
+  }
+
+  std::function<std::unique_ptr<iterators::Iterator<T>>(iterators::Iterator<S> &)> instrument(const char *name, std::function<std::unique_ptr<iterators::Iterator<T>>(iterators::Iterator<S> &)> mapper, std::shared_ptr<StrategyChoice> choice = nullptr) {
+    dPlan_.emplace_back(name);
+    dChoices_.resize(dPlan_.size() - 1);
+    dChoices_.emplace_back(std::move(choice));
+#ifdef STREAMS4CPP_PROFILING
+    auto stage = std::make_shared<StageProfile>(StageProfile{name});
+    dStages_.emplace_back(stage);
+    return [mapper, stage](iterators::Iterator<S> &source) -> std::unique_ptr<iterators::Iterator<T>> {
+      return std::make_unique<ProfilingIterator<T>>(mapper(source), stage);
+    };
+#else
+    return mapper;
+#endif
+  }
+
+  PipelineProfile withStrategies(PipelineProfile profile) const {
+    for (size_t i = 0; i < profile.stages.size() && i < dChoices_.size(); i++) {
+      if (dChoices_[i]) {
+        profile.stages[i].strategy = dChoices_[i]->strategy;
+        profile.stages[i].estimatedDistinct = dChoices_[i]->estimatedDistinct;
+      }
+    }
+    if (dGrouping_) {
+      StageProfile stage{"groupedBy"};
+      stage.strategy = dGrouping_->strategy;
+      stage.estimatedDistinct = dGrouping_->estimatedDistinct;
+      profile.stages.emplace_back(std::move(stage));
+    }
+    return profile;
+  }
 
   template<typename Container>
   inline auto to() {
@@ -456,7 +706,7 @@ struct Stream {
     auto inter = dMapper_(*dSource_);
     Container result;
     while (inter->hasNext()) {
-      result.emplace_back(inter->next().value());
+      result.emplace_back(inter->take().value());
     }
     return result;
   }
@@ -467,7 +717,7 @@ struct Stream {
     auto inter = dMapper_(*dSource_);
     Container result;
     while (inter->hasNext()) {
-      result.emplace(inter->next().value());
+      result.emplace(inter->take().value());
     }
     return result;
   }
@@ -4,7 +4,11 @@
 #include "collector.h"
 #include "processor.h"
 
+#include <algorithm>
+#include <functional>
 #include <iostream>
+#include <memory>
+#include <stdexcept>
 #include <utility>
 #include <vector>
 
@@ -66,6 +70,19 @@ struct UBStream {
     copy.emplace_back(std::make_shared<FilterProcessor<Predicate, T>>(std::forward<Predicate>(predicate)));
     return UBStream<T, T, BASE>(copy, dSourceData_);
   }
+  /**
+   * \fn UBStream<T, T, BASE> filterMightContain(Filter membership)
+   * \brief Selects the elements of this stream which might be contained in a membership filter, like the BloomFilter produced by Collectors::bloomFilter().
+   * @tparam Filter type of filter providing bool mightContain(const T &)
+   * @param membership the filter, shared by all the copies of the stream
+   * @return Stream of elements which might be contained in the filter
+   */
+  template<typename Filter>
+  UBStream<T, T, BASE> filterMightContain(Filter membership) {
+    auto shared = std::make_shared<const Filter>(std::move(membership));
+    return filter([shared](const T &element) { return shared->mightContain(element); });
+  }
+
   /**
    * \fn UBStream<T, T, BASE> limit(size_t limit)
    * \brief Returns a stream consisting of the elements of this stream, truncated to be no longer than maxSize in length.
@@ -112,34 +129,106 @@ struct UBStream {
   }
 
   /**
-   * \fn bool allMatch(std::function<bool(T)> predicate)
+   * \fn auto fixed(size_t windowSize, Collector<Supplier, Accumulator, Finisher, Combiner> &&collector)
+   * \brief Collects non overlapping windows of windowSize elements with a collector, emitting the result of every window. Elements are accumulated as they arrive, windows are never stored.
+   * @param windowSize
+   * @param collector
+   * @return a new stream of window results
+   */
+  template<typename Supplier, typename Accumulator, typename Finisher, typename Combiner>
+  auto fixed(size_t windowSize, Collector<Supplier, Accumulator, Finisher, Combiner> &&collector) {
+    return windowed(windowSize, windowSize, std::move(collector));
+  }
+
+  /**
+   * \fn auto sliding(size_t windowSize, size_t step, Collector<Supplier, Accumulator, Finisher, Combiner> &&collector)
+   * \brief Collects windows of windowSize elements moving by step elements with a collector, emitting the result of a window every step elements.
+   *
+   * Each run of step elements is accumulated into its own pane, and the windowSize / step panes of a window are merged with the combiner of the collector, so elements are never stored and mergeable sketches like toTDigest() keep bounded memory. windowSize must be a multiple of step.
+   * @param windowSize
+   * @param step
+   * @param collector
+   * @return a new stream of window results
+   */
+  template<typename Supplier, typename Accumulator, typename Finisher, typename Combiner>
+  auto sliding(size_t windowSize, size_t step, Collector<Supplier, Accumulator, Finisher, Combiner> &&collector) {
+    static_assert(Collector<Supplier, Accumulator, Finisher, Combiner>::combinable(), "sliding windows merge panes with the combiner of the collector");
+    return windowed(windowSize, step, std::move(collector));
+  }
+
+  /**
+   * \fn auto running(Collector<Supplier, Accumulator, Finisher, Combiner> &&collector, size_t every = 1)
+   * \brief Returns a stream of the running results of a collector, accumulating every element of this stream and emitting the result of all elements seen so far after every given number of elements.
+   *
+   * The collector state is kept between elements, so running estimates of sketch collectors like approxDistinct() cost constant memory on an unbounded stream. Every emission finishes a copy of the state, emit every n elements when the state is large.
+   * @tparam Supplier
+   * @tparam Accumulator
+   * @tparam Finisher
+   * @tparam Combiner
+   * @param collector
+   * @param every number of elements between two emitted results
+   * @return a new stream of running results
+   */
+  template<typename Supplier, typename Accumulator, typename Finisher, typename Combiner>
+  auto running(Collector<Supplier, Accumulator, Finisher, Combiner> &&collector, size_t every = 1) {
+    using State = decltype(collector.supply());
+    using E = decltype(collector.finish(std::declval<State &>()));
+    std::vector<std::shared_ptr<Processor>> copy(dProcessors_);
+    copy.emplace_back(std::make_shared<RunningProcessor<Collector<Supplier, Accumulator, Finisher, Combiner>, T>>(std::move(collector), std::max<size_t>(every, 1)));
+    return UBStream<E, T, BASE>(copy, dSourceData_);
+  }
+
+  /**
+   * \fn auto groupingBySorted(Classifier &&classifier, Collector<Supplier, Accumulator, Finisher, Combiner> &&collector, bool validate = false, Compare cmp = Compare())
+   * \brief Groups a stream already sorted by key, like time ordered records, returning a stream of the key and the result of the collector for every group.
+   *
+   * A group is emitted as soon as the first element of the next key arrives, and the last group when the source ends, so only the group being collected is held whatever the number of groups. On unsorted input a key seen before starts a new group; set validate to throw std::invalid_argument instead when a key is ordered before the previous key.
+   * @tparam Classifier type of function mapping elements to keys
+   * @tparam Compare ordering of keys, keys are equal when neither is ordered before the other
+   * @param classifier
+   * @param collector reduces the elements of a group
+   * @param validate whether to check that keys are in ascending order
+   * @param cmp
+   * @return a new stream of std::pair of key and result of the collector
+   */
+  template<typename Classifier, typename Supplier, typename Accumulator, typename Finisher, typename Combiner, typename K = std::decay_t<std::invoke_result_t<Classifier, const T &>>, typename Compare = std::less<K>>
+  auto groupingBySorted(Classifier &&classifier, Collector<Supplier, Accumulator, Finisher, Combiner> &&collector, bool validate = false, Compare cmp = Compare()) {
+    using Downstream = Collector<Supplier, Accumulator, Finisher, Combiner>;
+    using R = decltype(collector.finish(std::declval<decltype(collector.supply()) &>()));
+    std::vector<std::shared_ptr<Processor>> copy(dProcessors_);
+    copy.emplace_back(std::make_shared<SortedGroupProcessor<Downstream, std::decay_t<Classifier>, T, K, Compare>>(std::move(collector), std::forward<Classifier>(classifier), std::move(cmp), validate));
+    return UBStream<std::pair<K, R>, T, BASE>(copy, dSourceData_);
+  }
+
+  /**
+   * \fn bool allMatch(std::function<bool(const T &)> predicate)
    * \brief Returns whether all elements of this stream match the provided predicate. May not evaluate the predicate on all elements if not necessary for determining the result. If the stream is empty then true is returned and the predicate is not evaluated.
    * @param predicate  stateless predicate to apply to elements of this stream
    * @return     true if either all elements of the stream match the provided predicate or the stream is empty, otherwise false
    */
-  bool allMatch(std::function<bool(T)> predicate) {
+  bool allMatch(std::function<bool(const T &)> predicate) {
     auto vec = toVector();
     return std::all_of(vec.begin(), vec.end(), predicate);
   }
 
   /**
-   * \fn bool anyMatch(std::function<bool(T)> predicate)
+   * \fn bool anyMatch(std::function<bool(const T &)> predicate)
    * \brief Returns whether any elements of this stream match the provided predicate. May not evaluate the predicate on all elements if not necessary for determining the result. If the stream is empty then false is returned and the predicate is not evaluated.
    * @param predicate stateless predicate to apply to elements of this stream
    * @return     true if any elements of the stream match the provided predicate, otherwise false
    */
-  bool anyMatch(std::function<bool(T)> predicate) {
+  bool anyMatch(std::function<bool(const T &)> predicate) {
     auto vec = toVector();
     return std::any_of(vec.begin(), vec.end(), predicate);
   }
 
   /**
-   * \fn bool noneMatch(std::function<bool(T)> predicate)
+   * \fn bool noneMatch(std::function<bool(const T &)> predicate)
    * \brief Returns whether no elements of this stream match the provided predicate. May not evaluate the predicate on all elements if not necessary for determining the result. If the stream is empty then true is returned and the predicate is not evaluated.
    * @param predicate stateless predicate to apply to elements of this stream
    * @return     true if either no elements of the stream match the provided predicate or the stream is empty, otherwise false
    */
-  bool noneMatch(std::function<bool(T)> predicate) {
+  bool noneMatch(std::function<bool(const T &)> predicate) {
     auto vec = toVector();
     return std::none_of(vec.begin(), vec.end(), predicate);
   }
@@ -151,7 +240,7 @@ struct UBStream {
    */
   std::optional<T> head() {
     auto vec = toVector();
-    return vec.empty() ? std::optional<T>() : std::optional<T>(vec.front());
+    return vec.empty() ? std::optional<T>() : std::optional<T>(std::move(vec.front()));
   }
 
   /**
@@ -161,19 +250,19 @@ struct UBStream {
    */
   std::optional<T> tail() {
     auto vec = toVector();
-    return vec.empty() ? std::optional<T>() : std::optional<T>(vec.back());
+    return vec.empty() ? std::optional<T>() : std::optional<T>(std::move(vec.back()));
   }
 
   /**
-   * \fn std::optional<T> find(std::function<bool(T)> predicate)
+   * \fn std::optional<T> find(std::function<bool(const T &)> predicate)
    * \brief Finds the first element of the sequence satisfying a predicate, if any.
    * @param predicate stateless predicate to apply to elements of this stream
    * @return an Optional describing the first element of this stream which matches with this predicate, or an empty Optional if the stream is empty
    */
-  std::optional<T> find(std::function<bool(T)> predicate) {
+  std::optional<T> find(std::function<bool(const T &)> predicate) {
     auto vec = toVector();
     auto iterator = std::find_if(vec.begin(), vec.end(), predicate);
-    return iterator != vec.end() ? std::optional<T>(*iterator) : std::optional<T>{};
+    return iterator != vec.end() ? std::optional<T>(std::move(*iterator)) : std::optional<T>{};
   }
 
   /**
@@ -184,7 +273,7 @@ struct UBStream {
   std::optional<T> max() {
     std::vector<T> vec = toVector();
     auto iterator = std::max_element(vec.begin(), vec.end());
-    return iterator != vec.end() ? std::optional<T>(*iterator) : std::optional<T>{};
+    return iterator != vec.end() ? std::optional<T>(std::move(*iterator)) : std::optional<T>{};
   }
 
   /**
@@ -195,7 +284,7 @@ struct UBStream {
   std::optional<T> min() {
     std::vector<T> vec = toVector();
     auto iterator = std::min_element(vec.begin(), vec.end());
-    return iterator != vec.end() ? std::optional<T>(*iterator) : std::optional<T>{};
+    return iterator != vec.end() ? std::optional<T>(std::move(*iterator)) : std::optional<T>{};
   }
 
   /**
@@ -221,39 +310,107 @@ struct UBStream {
 
     auto processor = dProcessors_.front();
     dSourceData_->reset();
-    while (dSourceData_->hasNext()) {
-      processor->process(dSourceData_->next().value());
+    try {
+      while (dSourceData_->hasNext()) {
+        processor->process(dSourceData_->take().value());
+      }
+      processor->flush();
+    } catch (...) {
+      dProcessors_.pop_back();
+      throw;
     }
     dProcessors_.pop_back();
   }
 
+  /**
+   * \fn PipelineProfile explain()
+   * \brief Describes the processors of this stream pipeline from the source to the last processor, without running it.
+   * @return report with the operator name of every stage
+   */
+  PipelineProfile explain() const {
+    PipelineProfile profile;
+    profile.stages.emplace_back(StageProfile{"source"});
+    for (const auto &processor : dProcessors_) {
+      profile.stages.emplace_back(StageProfile{processor->name()});
+    }
+    return profile;
+  }
+
+  /**
+   * \fn PipelineProfile profile()
+   * \brief Runs this stream pipeline to the end of the source and reports, for every processor, its operator name, elements in and out, wall and cpu time and allocated bytes (see Profiler::recordAllocation).
+   *
+   * Statistics are recorded only when the library is compiled with STREAMS4CPP_PROFILING, otherwise the instrumentation compiles down to nothing and this is equivalent to explain().
+   * @return report of the stages
+   */
+  PipelineProfile profile() {
+#ifdef STREAMS4CPP_PROFILING
+    for (auto &processor : dProcessors_) {
+      processor->profile() = StageProfile{processor->name()};
+    }
+    StageProfile source{"source"};
+    size_t terminalCount = 0;
+    CpuClock cpuClock;
+    {
+      ProfileScope scope(source);
+      forEach([&terminalCount](const auto & /*element*/) { terminalCount++; });
+    }
+    source.elementsIn = source.elementsOut = dProcessors_.empty() ? terminalCount : dProcessors_.front()->profile().elementsIn;
+    PipelineProfile profile;
+    profile.stages.emplace_back(source);
+    for (size_t i = 0; i < dProcessors_.size(); i++) {
+      StageProfile stage = dProcessors_[i]->profile();
+      stage.elementsOut = i + 1 < dProcessors_.size() ? dProcessors_[i + 1]->profile().elementsIn : terminalCount;
+      profile.stages.emplace_back(std::move(stage));
+    }
+    profile.apportionCpuTime(cpuClock.elapsed());
+    return profile;
+#else
+    return explain();
+#endif
+  }
+
   /**
    *
    * @return
    */
   std::vector<T> toVector() {
     std::vector<T> result;
-    auto consumer = [&result](auto element) { result.emplace_back(element); };
+    auto consumer = [&result](T &element) { result.emplace_back(std::move(element)); };
     forEach(consumer);
     return result;
   }
 
   /**
-   * \fn auto collect(Collector<Supplier, Accumulator, Finisher> &&collector)
-   * \brief Performs a mutable reduction operation on the elements of this stream. A mutable reduction is one in which the reduced value is a mutable result container, such as an ArrayList, and elements are incorporated by updating the state of the result rather than by replacing the result. This produces a result equivalent to:
+   * \fn auto collect(Collector<Supplier, Accumulator, Finisher, Combiner> &&collector)
+   * \brief Performs a mutable reduction operation on the elements of this stream. A mutable reduction is one in which the reduced value is a mutable result container, such as an ArrayList, and elements are incorporated by updating the state of the result rather than by replacing the result. Elements are accumulated as the last processor emits them, the stream is never stored as a whole.
    * @tparam Supplier
    * @tparam Accumulator
    * @tparam Finisher
+   * @tparam Combiner
    * @param collector
    * @return result from the collector
    */
-  template<typename Supplier, typename Accumulator, typename Finisher>
-  auto collect(Collector<Supplier, Accumulator, Finisher> &&collector) {
-    std::vector<T> vec = toVector();
-    return collector.apply(vec);
+  template<typename Supplier, typename Accumulator, typename Finisher, typename Combiner>
+  auto collect(Collector<Supplier, Accumulator, Finisher, Combiner> &&collector) {
+    auto container = collector.supply();
+    forEach([&collector, &container](T &element) { collector.accumulate(container, std::move(element)); });
+    return collector.finish(container);
   }
 
  private:
+  template<typename Supplier, typename Accumulator, typename Finisher, typename Combiner>
+  auto windowed(size_t windowSize, size_t step, Collector<Supplier, Accumulator, Finisher, Combiner> &&collector) {
+    if (step == 0 || windowSize % step != 0) {
+      throw std::invalid_argument("window size must be a non zero multiple of step");
+    }
+    using State = decltype(collector.supply());
+    using E = decltype(collector.finish(std::declval<State &>()));
+    std::vector<std::shared_ptr<Processor>> copy(dProcessors_);
+    copy.emplace_back(std::make_shared<WindowCollectProcessor<Collector<Supplier, Accumulator, Finisher, Combiner>, T>>(std::move(collector), windowSize, step));
+    return UBStream<E, T, BASE>(copy, dSourceData_);
+  }
+
   std::vector<std::shared_ptr<Processor>> dProcessors_;
   std::shared_ptr<iterators::Iterator<BASE>> dSourceData_;
 };
@@ -21,6 +21,16 @@ namespace iterators {
 struct Iterator;
 struct ListIterator;
 struct ListIteratorView;
+struct SourceIterator;
+struct MapIterator;
+struct FilterIterator;
+struct LimitIterator;
+struct SkipIterator;
+struct SortedIterator;
+struct ReverseIterator;
+struct WindowIterator;
+struct BufferIterator;
+struct SortedGroupIterator;
 }// namespace iterators
 
 /**
@@ -44,6 +54,23 @@ struct UBStream;
 struct Stream;
 struct Collectors;
 class Collector;
+struct StreamCache;
+struct SummaryStatistics;
+struct JoiningState;
+struct Aggregates;
+class AggregationState;
+class AggregateTable;
+struct HyperLogLog;
+struct TDigest;
+struct SpaceSaving;
+struct FrequentItem;
+struct Reservoir;
+class Histogram;
+struct HistogramState;
+class BloomFilter;
+struct StrategyChoice;
+class CardinalityPlanner;
+class AdaptiveGroups;
 }// namespace streams
 
 /**
@@ -59,6 +86,8 @@ struct SMap;
 struct SSet;
 struct SUSet;
 struct SUMap;
+struct SFlatMap;
+struct SWindow;
 }// namespace collection
 
 }// namespace utils
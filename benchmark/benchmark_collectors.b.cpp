@@ -1,8 +1,10 @@
 #include <aalbatross/utils/streams/collectors.h>
 #include <aalbatross/utils/streams/stream.h>
+#include <algorithm>
 #include <benchmark/benchmark.h>
 #include <cstdlib>
 #include <memory>
+#include <numeric>
 #include <new>
 
 using namespace aalbatross::utils::streams;
@@ -77,6 +79,139 @@ static void BM_StreamGroupByCascadingWithNoDuplicates(benchmark::State &state) {
   state.SetItemsProcessed(MAX);
 }
 
+static void BM_StreamGroupByFlatOnSingleColumn(benchmark::State &state) {
+  std::vector<size_t> data;
+  for (size_t i = 0; i < MAX; i++) {
+    data.emplace_back(i % 10);
+  }
+  Stream<size_t> stream(data.begin(), data.end());
+  for (auto _ : state) {
+    stream.collect(Collectors::groupingByFlat<size_t>([](auto element) { return element; }));
+  }
+  state.SetItemsProcessed(MAX);
+}
+
+static void BM_StreamGroupByFlatCascadingWithDuplicates(benchmark::State &state) {
+  std::vector<size_t> data;
+  for (size_t i = 0; i < MAX; i++) {
+    data.emplace_back(i % 10);
+  }
+  Stream<size_t> stream(data.begin(), data.end());
+  for (auto _ : state)
+    stream.collect(Collectors::groupingByFlat<size_t>([](auto element) { return element; }, Collectors::averaging()));
+  state.SetItemsProcessed(MAX);
+}
+
+static void BM_StreamGroupByFlatCascadingWithNoDuplicates(benchmark::State &state) {
+  std::vector<size_t> data;
+  for (size_t i = 0; i < MAX; i++) {
+    data.emplace_back(i);
+  }
+  Stream<size_t> stream(data.begin(), data.end());
+  for (auto _ : state)
+    stream.collect(Collectors::groupingByFlat<size_t>([](auto element) { return element; }, Collectors::averaging()));
+  state.SetItemsProcessed(MAX);
+}
+
+static void BM_StreamGroupByFlatCascadingWithNoDuplicatesReserved(benchmark::State &state) {
+  std::vector<size_t> data;
+  for (size_t i = 0; i < MAX; i++) {
+    data.emplace_back(i);
+  }
+  Stream<size_t> stream(data.begin(), data.end());
+  for (auto _ : state)
+    stream.collect(Collectors::groupingByFlat<size_t>([](auto element) { return element; }, Collectors::averaging(), MAX));
+  state.SetItemsProcessed(MAX);
+}
+
+static void BM_StreamGroupByCascadingWithScatteredKeys(benchmark::State &state) {
+  std::vector<size_t> data;
+  for (size_t i = 0; i < MAX; i++) {
+    data.emplace_back(i * 0x9E3779B97F4A7C15ULL % 100000);
+  }
+  Stream<size_t> stream(data.begin(), data.end());
+  for (auto _ : state)
+    stream.collect(Collectors::groupingBy<size_t>([](auto element) { return element; }, Collectors::averaging()));
+  state.SetItemsProcessed(MAX);
+}
+
+static void BM_StreamGroupByFlatCascadingWithScatteredKeys(benchmark::State &state) {
+  std::vector<size_t> data;
+  for (size_t i = 0; i < MAX; i++) {
+    data.emplace_back(i * 0x9E3779B97F4A7C15ULL % 100000);
+  }
+  Stream<size_t> stream(data.begin(), data.end());
+  for (auto _ : state)
+    stream.collect(Collectors::groupingByFlat<size_t>([](auto element) { return element; }, Collectors::averaging()));
+  state.SetItemsProcessed(MAX);
+}
+
+static void BM_StreamGroupByDenseOnSingleColumn(benchmark::State &state) {
+  std::vector<size_t> data;
+  for (size_t i = 0; i < MAX; i++) {
+    data.emplace_back(i % 10);
+  }
+  Stream<size_t> stream(data.begin(), data.end());
+  for (auto _ : state) {
+    stream.collect(Collectors::groupingByDense<size_t>([](auto element) { return element; }, 9));
+  }
+  state.SetItemsProcessed(MAX);
+}
+
+static void BM_StreamGroupByDenseCascadingWithDuplicates(benchmark::State &state) {
+  std::vector<size_t> data;
+  for (size_t i = 0; i < MAX; i++) {
+    data.emplace_back(i % 10);
+  }
+  Stream<size_t> stream(data.begin(), data.end());
+  for (auto _ : state)
+    stream.collect(Collectors::groupingByDense<size_t>([](auto element) { return element; }, 9, Collectors::counting()));
+  state.SetItemsProcessed(MAX);
+}
+
+static void BM_StreamGroupByCascadingCountingWithDuplicates(benchmark::State &state) {
+  std::vector<size_t> data;
+  for (size_t i = 0; i < MAX; i++) {
+    data.emplace_back(i % 10);
+  }
+  Stream<size_t> stream(data.begin(), data.end());
+  for (auto _ : state)
+    stream.collect(Collectors::groupingBy<size_t>([](auto element) { return element; }, Collectors::counting()));
+  state.SetItemsProcessed(MAX);
+}
+
+static void BM_StreamGroupBySeparateAggregates(benchmark::State &state) {
+  std::vector<size_t> data;
+  for (size_t i = 0; i < MAX; i++) {
+    data.emplace_back(i * 7919 % MAX);
+  }
+  Stream<size_t> stream(data.begin(), data.end());
+  auto key = [](auto element) { return element % 1000; };
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(stream.collect(Collectors::groupingBy<size_t>(key, Collectors::counting())));
+    benchmark::DoNotOptimize(stream.collect(Collectors::groupingBy<size_t>(key, Collectors::summingLong([](auto element) { return element; }))));
+    benchmark::DoNotOptimize(stream.collect(Collectors::groupingBy<size_t>(key, Collectors::maxBy<size_t>(std::less<>()))));
+    benchmark::DoNotOptimize(stream.collect(Collectors::groupingBy<size_t>(key, Collectors::averaging())));
+  }
+  state.SetItemsProcessed(MAX);
+}
+
+static void BM_StreamAggregateBy(benchmark::State &state) {
+  std::vector<size_t> data;
+  for (size_t i = 0; i < MAX; i++) {
+    data.emplace_back(i * 7919 % MAX);
+  }
+  Stream<size_t> stream(data.begin(), data.end());
+  auto identity = [](auto element) { return element; };
+  for (auto _ : state)
+    benchmark::DoNotOptimize(stream.aggregateBy([](auto element) { return element % 1000; },
+                                                Aggregates::count(),
+                                                Aggregates::sum(identity),
+                                                Aggregates::max(identity),
+                                                Aggregates::average(identity)));
+  state.SetItemsProcessed(MAX);
+}
+
 static void BM_StreamPartitionByCascadingWithDuplicates(benchmark::State &state) {
   std::vector<size_t> data;
   for (size_t i = 0; i < MAX; i++) {
@@ -100,13 +235,37 @@ static void BM_StreamPartitionByCascadingWithNoDuplicates(benchmark::State &stat
 }
 
 static void BM_StreamJoiningString(benchmark::State &state) {
-  std::vector<std::string_view> data;
+  std::vector<std::string> strings;
+  for (size_t i = 0; i < MAX; i++) {
+    strings.emplace_back(std::to_string(i) + "times");
+  }
+  std::vector<std::string_view> data(strings.begin(), strings.end());
+  Stream<std::string_view> stream(data.begin(), data.end());
+  for (auto _ : state)
+    benchmark::DoNotOptimize(stream.collect(Collectors::joining(",", "{", "}")));
+  state.SetItemsProcessed(MAX);
+}
+
+static void BM_StreamJoiningOwnedString(benchmark::State &state) {
+  std::vector<std::string> data;
   for (size_t i = 0; i < MAX; i++) {
     data.emplace_back(std::to_string(i) + "times");
   }
+  Stream<std::string> stream(data.begin(), data.end());
+  for (auto _ : state)
+    benchmark::DoNotOptimize(stream.collect(Collectors::joining(",", "{", "}")));
+  state.SetItemsProcessed(MAX);
+}
+
+static void BM_StreamJoiningChunked(benchmark::State &state) {
+  std::vector<std::string> strings;
+  for (size_t i = 0; i < MAX; i++) {
+    strings.emplace_back(std::to_string(i) + "times");
+  }
+  std::vector<std::string_view> data(strings.begin(), strings.end());
   Stream<std::string_view> stream(data.begin(), data.end());
   for (auto _ : state)
-    stream.collect(Collectors::joining(",", "{", "}"));
+    benchmark::DoNotOptimize(stream.collect(Collectors::joiningChunked(",")));
   state.SetItemsProcessed(MAX);
 }
 
@@ -143,6 +302,51 @@ static void BM_StreamAveraging(benchmark::State &state) {
   state.SetItemsProcessed(MAX);
 }
 
+static void BM_StreamSeparateStatistics(benchmark::State &state) {
+  std::vector<size_t> data;
+  for (size_t i = 0; i < MAX; i++) {
+    data.emplace_back(i * 7919 % MAX);
+  }
+  Stream<size_t> stream(data.begin(), data.end());
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(stream.collect(Collectors::counting()));
+    benchmark::DoNotOptimize(stream.collect(Collectors::minBy<size_t>(std::less<>())));
+    benchmark::DoNotOptimize(stream.collect(Collectors::maxBy<size_t>(std::less<>())));
+    benchmark::DoNotOptimize(stream.collect(Collectors::summingDouble([](auto element) { return element * 1.0; })));
+    benchmark::DoNotOptimize(stream.collect(Collectors::averaging()));
+  }
+  state.SetItemsProcessed(MAX);
+}
+
+static void BM_StreamTeeingStatistics(benchmark::State &state) {
+  std::vector<size_t> data;
+  for (size_t i = 0; i < MAX; i++) {
+    data.emplace_back(i * 7919 % MAX);
+  }
+  Stream<size_t> stream(data.begin(), data.end());
+  for (auto _ : state)
+    benchmark::DoNotOptimize(stream.collect(Collectors::teeing(Collectors::counting(),
+                                                               Collectors::minBy<size_t>(std::less<>()),
+                                                               Collectors::maxBy<size_t>(std::less<>()),
+                                                               Collectors::summingDouble([](auto element) { return element * 1.0; }),
+                                                               Collectors::averaging(),
+                                                               [](auto count, auto min, auto max, auto sum, auto average) {
+                                                                 return count + min.value() + max.value() + sum + average;
+                                                               })));
+  state.SetItemsProcessed(MAX);
+}
+
+static void BM_StreamSummarizing(benchmark::State &state) {
+  std::vector<size_t> data;
+  for (size_t i = 0; i < MAX; i++) {
+    data.emplace_back(i * 7919 % MAX);
+  }
+  Stream<size_t> stream(data.begin(), data.end());
+  for (auto _ : state)
+    benchmark::DoNotOptimize(stream.collect(Collectors::summarizing()));
+  state.SetItemsProcessed(MAX);
+}
+
 static void BM_StreamToVector(benchmark::State &state) {
   std::vector<size_t> data;
   for (size_t i = 0; i < MAX; i++) {
@@ -154,6 +358,28 @@ static void BM_StreamToVector(benchmark::State &state) {
   state.SetItemsProcessed(MAX);
 }
 
+static void BM_StreamToMapMerging(benchmark::State &state) {
+  std::vector<size_t> data;
+  for (size_t i = 0; i < MAX; i++) {
+    data.emplace_back(i * 7919 % MAX);
+  }
+  Stream<size_t> stream(data.begin(), data.end());
+  for (auto _ : state)
+    benchmark::DoNotOptimize(stream.collect(Collectors::toMap<size_t>([](auto element) { return element % 1000; }, [](auto element) { return element; }, std::plus<>())));
+  state.SetItemsProcessed(MAX);
+}
+
+static void BM_StreamToUnorderedMapMerging(benchmark::State &state) {
+  std::vector<size_t> data;
+  for (size_t i = 0; i < MAX; i++) {
+    data.emplace_back(i * 7919 % MAX);
+  }
+  Stream<size_t> stream(data.begin(), data.end());
+  for (auto _ : state)
+    benchmark::DoNotOptimize(stream.collect(Collectors::toUnorderedMap<size_t>([](auto element) { return element % 1000; }, [](auto element) { return element; }, std::plus<>(), 1000)));
+  state.SetItemsProcessed(MAX);
+}
+
 static void BM_StreamToSet(benchmark::State &state) {
   std::vector<size_t> data;
   for (size_t i = 0; i < MAX; i++) {
@@ -165,6 +391,188 @@ static void BM_StreamToSet(benchmark::State &state) {
   state.SetItemsProcessed(MAX);
 }
 
+static void BM_StreamDistinctCount(benchmark::State &state) {
+  std::vector<size_t> data;
+  for (size_t i = 0; i < MAX; i++) {
+    data.emplace_back(i % 100000);
+  }
+  Stream<size_t> stream(data.begin(), data.end());
+  for (auto _ : state)
+    stream.collect(Collectors::toSet<size_t>()).size();
+  state.SetItemsProcessed(MAX);
+}
+
+static void BM_StreamApproxDistinct(benchmark::State &state) {
+  std::vector<size_t> data;
+  for (size_t i = 0; i < MAX; i++) {
+    data.emplace_back(i % 100000);
+  }
+  Stream<size_t> stream(data.begin(), data.end());
+  for (auto _ : state)
+    stream.collect(Collectors::approxDistinct<size_t>());
+  state.SetItemsProcessed(MAX);
+}
+
+static void BM_StreamSortedQuantiles(benchmark::State &state) {
+  std::vector<size_t> data;
+  for (size_t i = 0; i < MAX; i++) {
+    data.emplace_back(i * 7919 % MAX);
+  }
+  Stream<size_t> stream(data.begin(), data.end());
+  for (auto _ : state) {
+    auto sorted = stream.sorted(std::less<>()).toVector();
+    benchmark::DoNotOptimize(sorted[sorted.size() * 999 / 1000]);
+  }
+  state.SetItemsProcessed(MAX);
+}
+
+static void BM_StreamQuantiles(benchmark::State &state) {
+  std::vector<size_t> data;
+  for (size_t i = 0; i < MAX; i++) {
+    data.emplace_back(i * 7919 % MAX);
+  }
+  Stream<size_t> stream(data.begin(), data.end());
+  for (auto _ : state)
+    benchmark::DoNotOptimize(stream.collect(Collectors::quantiles({0.5, 0.99, 0.999})));
+  state.SetItemsProcessed(MAX);
+}
+
+static void BM_StreamTopKByGrouping(benchmark::State &state) {
+  std::vector<size_t> data;
+  for (size_t i = 0; i < MAX; i++) {
+    data.emplace_back(i % 3 == 0 ? i % 10 : i * 7919 % MAX);
+  }
+  Stream<size_t> stream(data.begin(), data.end());
+  for (auto _ : state) {
+    auto counts = stream.collect(Collectors::groupingBy<size_t>([](auto element) { return element; }, Collectors::counting()));
+    std::vector<std::pair<size_t, size_t>> sorted(counts.begin(), counts.end());
+    std::partial_sort(sorted.begin(), sorted.begin() + 10, sorted.end(), [](const auto &lhs, const auto &rhs) { return lhs.second > rhs.second; });
+    benchmark::DoNotOptimize(sorted.front());
+  }
+  state.SetItemsProcessed(MAX);
+}
+
+static void BM_StreamHeavyHitters(benchmark::State &state) {
+  std::vector<size_t> data;
+  for (size_t i = 0; i < MAX; i++) {
+    data.emplace_back(i % 3 == 0 ? i % 10 : i * 7919 % MAX);
+  }
+  Stream<size_t> stream(data.begin(), data.end());
+  for (auto _ : state)
+    benchmark::DoNotOptimize(stream.collect(Collectors::heavyHitters<size_t>(10, 0.001)));
+  state.SetItemsProcessed(MAX);
+}
+
+static std::vector<std::string> records(size_t count) {
+  std::vector<std::string> data;
+  data.reserve(count);
+  for (size_t i = 0; i < count; i++) {
+    data.emplace_back(std::to_string(i % 100) + std::string(64, 'r'));
+  }
+  return data;
+}
+
+static void BM_StreamGroupByBorrowedRecords(benchmark::State &state) {
+  auto data = records(MAX / 10);
+  Stream<std::string> stream(data.begin(), data.end());
+  for (auto _ : state)
+    benchmark::DoNotOptimize(stream.filter([](const auto &record) { return record[0] != '9'; }).collect(Collectors::groupingBy<std::string>([](const auto &record) { return record[0]; })));
+  state.SetItemsProcessed(MAX / 10);
+}
+
+static void BM_StreamGroupByOwnedRecords(benchmark::State &state) {
+  for (auto _ : state) {
+    state.PauseTiming();
+    auto data = records(MAX / 10);
+    state.ResumeTiming();
+    benchmark::DoNotOptimize(Stream<std::string>::of(std::move(data)).filter([](const auto &record) { return record[0] != '9'; }).collect(Collectors::groupingBy<std::string>([](const auto &record) { return record[0]; })));
+  }
+  state.SetItemsProcessed(MAX / 10);
+}
+
+static void BM_StreamSample(benchmark::State &state) {
+  std::vector<size_t> data;
+  for (size_t i = 0; i < MAX; i++) {
+    data.emplace_back(i);
+  }
+  Stream<size_t> stream(data.begin(), data.end());
+  for (auto _ : state)
+    benchmark::DoNotOptimize(stream.collect(Collectors::sample<size_t>(100, 42)));
+  state.SetItemsProcessed(MAX);
+}
+
+static void BM_StreamSampleSkipping(benchmark::State &state) {
+  std::vector<size_t> data;
+  for (size_t i = 0; i < MAX; i++) {
+    data.emplace_back(i);
+  }
+  Stream<size_t> stream(data.begin(), data.end());
+  for (auto _ : state)
+    benchmark::DoNotOptimize(stream.collect(Collectors::sampleSkipping<size_t>(100, 42)));
+  state.SetItemsProcessed(MAX);
+}
+
+static void BM_StreamGroupByBucketCounting(benchmark::State &state) {
+  std::vector<double> data;
+  for (size_t i = 0; i < MAX; i++) {
+    data.emplace_back(static_cast<double>(i * 7919 % MAX));
+  }
+  Stream<double> stream(data.begin(), data.end());
+  for (auto _ : state)
+    benchmark::DoNotOptimize(stream.collect(Collectors::groupingBy<double>([](auto element) { return static_cast<size_t>(element / 1000); }, Collectors::counting())));
+  state.SetItemsProcessed(MAX);
+}
+
+static void BM_StreamHistogram(benchmark::State &state) {
+  std::vector<double> data;
+  for (size_t i = 0; i < MAX; i++) {
+    data.emplace_back(static_cast<double>(i * 7919 % MAX));
+  }
+  Stream<double> stream(data.begin(), data.end());
+  for (auto _ : state)
+    benchmark::DoNotOptimize(stream.collect(Collectors::histogram(0, MAX, MAX / 1000)));
+  state.SetItemsProcessed(MAX);
+}
+
+static void BM_StreamLogHistogram(benchmark::State &state) {
+  std::vector<double> data;
+  for (size_t i = 0; i < MAX; i++) {
+    data.emplace_back(static_cast<double>(1 + i * 7919 % MAX));
+  }
+  Stream<double> stream(data.begin(), data.end());
+  for (auto _ : state)
+    benchmark::DoNotOptimize(stream.collect(Collectors::logHistogram(1, MAX, 3)));
+  state.SetItemsProcessed(MAX);
+}
+
+static void BM_StreamFilterByUnorderedSet(benchmark::State &state) {
+  std::vector<size_t> data;
+  for (size_t i = 0; i < MAX; i++) {
+    data.emplace_back(i * 7919 % MAX);
+  }
+  Stream<size_t> stream(data.begin(), data.end());
+  auto keys = stream.filter([](auto element) { return element % 10 == 0; }).toUnorderedSet();
+  auto shared = std::make_shared<decltype(keys)>(std::move(keys));
+  for (auto _ : state)
+    benchmark::DoNotOptimize(stream.filter([shared](auto element) { return shared->count(element) > 0; }).count());
+  state.counters["bytes"] = static_cast<double>(shared->size() * (sizeof(size_t) + 2 * sizeof(void *)) + shared->bucket_count() * sizeof(void *));
+  state.SetItemsProcessed(MAX);
+}
+
+static void BM_StreamFilterMightContain(benchmark::State &state) {
+  std::vector<size_t> data;
+  for (size_t i = 0; i < MAX; i++) {
+    data.emplace_back(i * 7919 % MAX);
+  }
+  Stream<size_t> stream(data.begin(), data.end());
+  auto filter = stream.filter([](auto element) { return element % 10 == 0; }).collect(Collectors::bloomFilter<size_t>(MAX / 10, 0.01));
+  state.counters["bytes"] = static_cast<double>(filter.bytes());
+  auto selected = stream.filterMightContain(std::move(filter));
+  for (auto _ : state)
+    benchmark::DoNotOptimize(selected.count());
+  state.SetItemsProcessed(MAX);
+}
+
 static void BM_StreamToList(benchmark::State &state) {
   std::vector<size_t> data;
   for (size_t i = 0; i < MAX; i++) {
@@ -176,19 +584,124 @@ static void BM_StreamToList(benchmark::State &state) {
   state.SetItemsProcessed(MAX);
 }
 
+static void BM_StreamSlidingAverage(benchmark::State &state) {
+  std::vector<double> data;
+  for (size_t i = 0; i < MAX; i++) {
+    data.emplace_back(i % 1000);
+  }
+  Stream<double> stream(data.begin(), data.end());
+  for (auto _ : state)
+    stream.sliding(10).map([](auto window) { return std::accumulate(window.begin(), window.end(), 0.0) / window.size(); }).forEach([](auto average) { benchmark::DoNotOptimize(average); });
+  state.SetItemsProcessed(MAX);
+}
+
+static void BM_StreamDistinct(benchmark::State &state) {
+  std::vector<size_t> data;
+  for (size_t i = 0; i < MAX; i++) {
+    data.emplace_back(i % 1000);
+  }
+  Stream<size_t> stream(data.begin(), data.end());
+  for (auto _ : state)
+    stream.distinct().toVector();
+  state.SetItemsProcessed(MAX);
+}
+
+static void BM_StreamDistinctWithScatteredKeys(benchmark::State &state) {
+  std::vector<size_t> data;
+  for (size_t i = 0; i < MAX; i++) {
+    data.emplace_back(mixHash(i % 100000));
+  }
+  Stream<size_t> stream(data.begin(), data.end());
+  for (auto _ : state)
+    stream.distinct().toVector();
+  state.SetItemsProcessed(MAX);
+}
+
+static void BM_StreamDistinctWithNoDuplicates(benchmark::State &state) {
+  std::vector<size_t> data;
+  for (size_t i = 0; i < MAX; i++) {
+    data.emplace_back(mixHash(i));
+  }
+  Stream<size_t> stream(data.begin(), data.end());
+  for (auto _ : state)
+    stream.distinct().toVector();
+  state.SetItemsProcessed(MAX);
+}
+
+static void BM_StreamGroupByOrderedOnSortedKeys(benchmark::State &state) {
+  std::vector<size_t> data;
+  for (size_t i = 0; i < MAX; i++) {
+    data.emplace_back(i / 10);
+  }
+  Stream<size_t> stream(data.begin(), data.end());
+  for (auto _ : state)
+    stream.collect(Collectors::groupingByOrdered<size_t>([](auto element) { return element; }, Collectors::counting())).size();
+  state.SetItemsProcessed(MAX);
+}
+
+static void BM_StreamGroupBySortedOnSortedKeys(benchmark::State &state) {
+  std::vector<size_t> data;
+  for (size_t i = 0; i < MAX; i++) {
+    data.emplace_back(i / 10);
+  }
+  Stream<size_t> stream(data.begin(), data.end());
+  for (auto _ : state)
+    stream.groupingBySorted([](auto element) { return element; }, Collectors::counting()).count();
+  state.SetItemsProcessed(MAX);
+}
+
 // Register the function as a benchmark
 BENCHMARK(BM_StreamGroupByOnSingleColumn);
 BENCHMARK(BM_StreamGroupByCascadingWithDuplicates);
 BENCHMARK(BM_StreamGroupByCascadingWithNoDuplicates);
+BENCHMARK(BM_StreamGroupByFlatOnSingleColumn);
+BENCHMARK(BM_StreamGroupByFlatCascadingWithDuplicates);
+BENCHMARK(BM_StreamGroupByFlatCascadingWithNoDuplicates);
+BENCHMARK(BM_StreamGroupByFlatCascadingWithNoDuplicatesReserved);
+BENCHMARK(BM_StreamGroupByCascadingWithScatteredKeys);
+BENCHMARK(BM_StreamGroupByFlatCascadingWithScatteredKeys);
+BENCHMARK(BM_StreamGroupByDenseOnSingleColumn);
+BENCHMARK(BM_StreamGroupByDenseCascadingWithDuplicates);
+BENCHMARK(BM_StreamGroupByCascadingCountingWithDuplicates);
+BENCHMARK(BM_StreamGroupBySeparateAggregates);
+BENCHMARK(BM_StreamAggregateBy);
 BENCHMARK(BM_StreamPartitionByCascadingWithDuplicates);
 BENCHMARK(BM_StreamPartitionByCascadingWithNoDuplicates);
 BENCHMARK(BM_StreamJoiningString);
+BENCHMARK(BM_StreamJoiningOwnedString);
+BENCHMARK(BM_StreamJoiningChunked);
 BENCHMARK(BM_StreamCounting);
 BENCHMARK(BM_StreamSumming);
 BENCHMARK(BM_StreamAveraging);
+BENCHMARK(BM_StreamSeparateStatistics);
+BENCHMARK(BM_StreamTeeingStatistics);
+BENCHMARK(BM_StreamSummarizing);
 BENCHMARK(BM_StreamToVector);
 BENCHMARK(BM_StreamToSet);
+BENCHMARK(BM_StreamToMapMerging);
+BENCHMARK(BM_StreamToUnorderedMapMerging);
 BENCHMARK(BM_StreamToList);
+BENCHMARK(BM_StreamFilterByUnorderedSet);
+BENCHMARK(BM_StreamFilterMightContain);
+BENCHMARK(BM_StreamGroupByBucketCounting);
+BENCHMARK(BM_StreamHistogram);
+BENCHMARK(BM_StreamLogHistogram);
+BENCHMARK(BM_StreamGroupByBorrowedRecords);
+BENCHMARK(BM_StreamGroupByOwnedRecords);
+BENCHMARK(BM_StreamSample);
+BENCHMARK(BM_StreamSampleSkipping);
+BENCHMARK(BM_StreamDistinctCount);
+BENCHMARK(BM_StreamApproxDistinct);
+BENCHMARK(BM_StreamSortedQuantiles);
+BENCHMARK(BM_StreamQuantiles);
+BENCHMARK(BM_StreamTopKByGrouping);
+BENCHMARK(BM_StreamHeavyHitters);
+BENCHMARK(BM_StreamSlidingAverage);
+BENCHMARK(BM_StreamDistinct);
+BENCHMARK(BM_StreamDistinctWithScatteredKeys);
+BENCHMARK(BM_StreamDistinctWithNoDuplicates);
+BENCHMARK(BM_StreamGroupByOrderedOnSortedKeys);
+BENCHMARK(BM_StreamGroupBySortedOnSortedKeys);
 
 int main(int argc, char *argv[]) {
   std::unique_ptr<benchmark::MemoryManager> mm(new TestMemoryManager());
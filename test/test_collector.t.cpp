@@ -5,6 +5,10 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <numeric>
+#include <random>
+
 namespace aalbatross::utils::test {
 
 struct AType {
@@ -63,6 +67,37 @@ TEST(CollectorFixtureTest, GroupingByTest) {
   EXPECT_EQ(2, result["4"].size());
 }
 
+TEST(CollectorFixtureTest, AdaptiveGroupingByTest) {
+  std::vector<int> vector(3000);
+  std::iota(vector.begin(), vector.end(), 0);
+  auto byRemainder = streams::Collectors::groupingBy<int>([](auto number) { return number % 7; });
+  auto dense = byRemainder.apply(vector);
+  ASSERT_EQ(7, dense.size());
+  EXPECT_EQ(429, dense[3].size());
+  EXPECT_EQ(3, dense[3].front());
+
+  auto identity = streams::Collectors::groupingBy<int>([](auto number) { return number; });
+  auto left = identity.supply();
+  auto right = identity.supply();
+  for (int number = 0; number < 2000; number++) {
+    identity.accumulate(left, number % 1500);
+    identity.accumulate(right, number);
+  }
+  identity.accumulate(right, 1000000);
+  identity.combine(left, right);
+  auto merged = identity.finish(left);
+  ASSERT_EQ(2001, merged.size());
+  EXPECT_THAT(merged[1200], ::testing::ElementsAre(1200, 1200));
+  EXPECT_THAT(merged[200], ::testing::ElementsAre(200, 200, 200));
+  EXPECT_THAT(merged[1000000], ::testing::ElementsAre(1000000));
+
+  auto byName = streams::Collectors::groupingBy<int>([](auto number) { return "key" + std::to_string(number % 300); });
+  auto hashed = byName.apply(vector);
+  ASSERT_EQ(300, hashed.size());
+  EXPECT_EQ(10, hashed["key42"].size());
+  EXPECT_EQ(2742, hashed["key42"].back());
+}
+
 TEST(CollectorFixtureTest, GroupingByWithCollectorTest) {
   std::vector vector{12, 12, 13, 13, 5, 4, 5, 5, 5, 5, 4};
 
@@ -77,6 +112,32 @@ TEST(CollectorFixtureTest, GroupingByWithCollectorTest) {
   EXPECT_EQ(2, result["4"]);
 }
 
+TEST(CollectorFixtureTest, GroupingByWithCollectorSinglePassTest) {
+  std::vector vector{12, 12, 13, 13, 5, 4, 5, 5, 5, 5, 4};
+  size_t containers = 0;
+  auto downstream = streams::Collector{[&containers] {
+                                         containers++;
+                                         return std::vector<int>();
+                                       },
+                                       [](std::vector<int> &intermediate, const auto &element) { intermediate.emplace_back(element); },
+                                       [](std::vector<int> &intermediate) { return intermediate.size(); }};
+  auto result = streams::Collectors::groupingBy<int>([](auto item) { return item; }, std::move(downstream)).apply(vector);
+  EXPECT_EQ(4, containers);
+  EXPECT_EQ(5, result[5]);
+  EXPECT_EQ(2, result[12]);
+
+  auto sums = streams::Collectors::groupingByOrdered<int>([](auto item) { return item % 2 == 0; }, streams::Collectors::reducing<int>(100, std::plus<>())).apply(vector);
+  EXPECT_THAT(sums, ::testing::ElementsAre(::testing::Pair(false, 151), ::testing::Pair(true, 132)));
+
+  auto partitions = streams::Collectors::partitioningBy<int>([](auto item) { return item > 10; }, streams::Collectors::counting()).apply(vector);
+  EXPECT_EQ(4, partitions[true]);
+  EXPECT_EQ(7, partitions[false]);
+
+  std::vector<int> empty;
+  EXPECT_TRUE(streams::Collectors::groupingBy<int>([](auto item) { return item; }, streams::Collectors::counting()).apply(empty).empty());
+  EXPECT_TRUE(streams::Collectors::groupingByOrdered<int>([](auto item) { return item; }, streams::Collectors::counting()).apply(empty).empty());
+}
+
 TEST(CollectorFixtureTest, JoiningTest) {
   std::vector vector{"apple", "boy", "cat", "dog", "elephant", "fish", "girl"};
 
@@ -94,6 +155,11 @@ TEST(CollectorFixtureTest, JoiningTest) {
   auto result2 = collector2.apply(vector);
   const auto *expected2 = "[apple, boy, cat, dog, elephant, fish, girl]";
   EXPECT_STREQ(expected2, result2.c_str());
+
+  std::vector<const char *> none;
+  EXPECT_EQ("[]", collector2.apply(none));
+  std::vector<std::string_view> views{"", "a", ""};
+  EXPECT_EQ(",a,", collector1.apply(views));
 }
 
 TEST(CollectorFixtureTest, MaxMinTest) {
@@ -151,6 +217,10 @@ TEST(CollectorFixtureTest, CollectToCustomContainerTest) {
   auto result1 = collector1.apply(data);
 
   EXPECT_THAT(result1, ::testing::UnorderedElementsAre(10, 16, 17, 20, 21, 29, 40, 50));
+
+  auto collector2 = streams::Collectors::toContainer(std::vector<int>{1, 2, 3});
+  EXPECT_THAT(collector2.apply(data), ::testing::SizeIs(15));
+  EXPECT_THAT(collector2.apply(data), ::testing::ElementsAre(1, 2, 3, 21, 21, 20, 20, 29, 29, 29, 10, 17, 16, 40, 50));
 }
 
 TEST(CollectorFixtureTest, CollectToSummingTest) {
@@ -167,6 +237,19 @@ TEST(CollectorFixtureTest, CollectToSummingTest) {
   EXPECT_EQ(result2, 36.0);
 }
 
+TEST(CollectorFixtureTest, CollectToCompensatedSummingTest) {
+  std::vector<double> data(10, 0.1);
+
+  auto collector1 = streams::Collectors::summingDouble([](double item) { return item; });
+  EXPECT_EQ(1.0, collector1.apply(data));
+
+  std::vector<double> cancelling{1e16, 1.0, -1e16};
+  EXPECT_EQ(1.0, collector1.apply(cancelling));
+
+  auto collector2 = streams::Collectors::averaging();
+  EXPECT_THAT(collector2.apply(data), ::testing::DoubleEq(0.1));
+}
+
 TEST(CollectorFixtureTest, CollectToMapTest1) {
   std::vector pods{
       AType{23, 'a', "xyz"},
@@ -193,10 +276,86 @@ TEST(CollectorFixtureTest, CollectToMapTest2) {
 
   auto collector2 = streams::Collectors::toMap<AType>([](auto pod) { return pod.b; }, [](auto pod) { return pod.c; }, [](auto a_1, auto a_2) { return a_1 + ", " + a_2; });
   auto result2 = collector2.apply(pods);
-  EXPECT_STREQ(result2['a'].c_str(), ", xyz, byz");
-  EXPECT_STREQ(result2['b'].c_str(), ", ayz");
-  EXPECT_STREQ(result2['c'].c_str(), ", uyz");
+  EXPECT_STREQ(result2['a'].c_str(), "xyz, byz");
+  EXPECT_STREQ(result2['b'].c_str(), "ayz");
+  EXPECT_STREQ(result2['c'].c_str(), "uyz");
   EXPECT_EQ(3, result2.size());
+
+  auto products = streams::Collectors::toMap<AType>([](auto pod) { return pod.b; }, [](auto pod) { return pod.a; }, std::multiplies<>()).apply(pods);
+  EXPECT_EQ(23 * 13, products['a']);
+  EXPECT_EQ(45, products['b']);
+}
+
+TEST(CollectorFixtureTest, CollectToUnorderedMapTest) {
+  std::vector pods{
+      AType{23, 'a', "xyz"},
+      AType{45, 'b', "ayz"},
+      AType{69, 'c', "uyz"},
+      AType{13, 'a', "byz"},
+  };
+  auto result1 = streams::Collectors::toUnorderedMap<AType>([](auto pod) { return pod.b; }, [](auto pod) { return pod.c; }, 8).apply(pods);
+  EXPECT_EQ(3, result1.size());
+  EXPECT_EQ("byz", result1['a']);
+  EXPECT_LE(8, result1.bucket_count());
+
+  auto collector = streams::Collectors::toUnorderedMap<AType>([](auto pod) { return pod.b; }, [](auto pod) { return pod.c; }, [](auto a_1, auto a_2) { return a_1 + ", " + a_2; });
+  auto result2 = collector.apply(pods);
+  EXPECT_EQ("xyz, byz", result2['a']);
+  EXPECT_EQ("uyz", result2['c']);
+
+  auto left = collector.supply();
+  auto right = collector.supply();
+  collector.accumulate(left, pods[0]);
+  collector.accumulate(right, pods[3]);
+  collector.accumulate(right, pods[2]);
+  collector.combine(left, right);
+  EXPECT_EQ("xyz, byz", left['a']);
+  EXPECT_EQ("uyz", left['c']);
+}
+
+TEST(CollectorFixtureTest, GroupingByFlatTest) {
+  std::vector vector{12, 12, 13, 13, 5, 4, 5, 5, 5, 5, 4};
+
+  auto groups = streams::Collectors::groupingByFlat<int>([](auto count) { return std::to_string(count); }, 4).apply(vector);
+  EXPECT_EQ(4, groups.size());
+  EXPECT_THAT(groups["5"], ::testing::ElementsAre(5, 5, 5, 5, 5));
+  EXPECT_EQ(2, groups["4"].size());
+
+  auto counts = streams::Collectors::groupingByFlat<int>([](auto item) { return item; }, streams::Collectors::counting()).apply(vector);
+  EXPECT_EQ(4, counts.size());
+  EXPECT_EQ(5, counts.at(5));
+  EXPECT_EQ(2, counts.at(13));
+
+  auto partitions = streams::Collectors::partitioningByFlat<int>([](auto item) { return item > 10; }).apply(vector);
+  EXPECT_THAT(partitions[true], ::testing::ElementsAre(12, 12, 13, 13));
+  auto partitionCounts = streams::Collectors::partitioningByFlat<int>([](auto item) { return item > 10; }, streams::Collectors::counting()).apply(vector);
+  EXPECT_EQ(7, partitionCounts[false]);
+}
+
+TEST(CollectorFixtureTest, CollectToFlatMapTest) {
+  std::vector pods{
+      AType{23, 'a', "xyz"},
+      AType{45, 'b', "ayz"},
+      AType{69, 'c', "uyz"},
+      AType{13, 'a', "byz"},
+  };
+  auto result1 = streams::Collectors::toFlatMap<AType>([](auto pod) { return pod.b; }, [](auto pod) { return pod.c; }).apply(pods);
+  EXPECT_EQ(3, result1.size());
+  EXPECT_EQ("byz", result1['a']);
+
+  auto result2 = streams::Collectors::toFlatMap<AType>([](auto pod) { return pod.b; }, [](auto pod) { return pod.c; }, [](auto a_1, auto a_2) { return a_1 + ", " + a_2; }, 3).apply(pods);
+  EXPECT_EQ("xyz, byz", result2['a']);
+  EXPECT_EQ("ayz", result2['b']);
+
+  auto sums = streams::Collectors::toFlatMap<AType>([](auto pod) { return pod.b; }, [](auto pod) { return pod.a; }, std::plus<>());
+  auto left = sums.supply();
+  auto right = sums.supply();
+  sums.accumulate(left, pods[0]);
+  sums.accumulate(right, pods[3]);
+  sums.accumulate(right, pods[1]);
+  sums.combine(left, right);
+  EXPECT_EQ(36, left['a']);
+  EXPECT_EQ(45, left['b']);
 }
 
 TEST(CollectorFixtureTest, CollectReducingTest) {
@@ -218,4 +377,449 @@ TEST(CollectorFixtureTest, CollectReducingTest) {
   EXPECT_EQ(((char) 97), result2.b);
   EXPECT_STREQ("def,xyz,ayz,uyz,byz", result2.c.c_str());
 }
+template<typename Collector, typename T>
+auto collectInShards(const Collector &collector, std::vector<T> &input, size_t shards) {
+  std::vector<decltype(collector.supply())> partials;
+  for (size_t shard = 0; shard < shards; shard++) {
+    auto partial = collector.supply();
+    for (size_t i = shard * input.size() / shards; i < (shard + 1) * input.size() / shards; i++) {
+      collector.accumulate(partial, input[i]);
+    }
+    partials.emplace_back(std::move(partial));
+  }
+  for (size_t shard = 1; shard < shards; shard++) {
+    collector.combine(partials.front(), partials[shard]);
+  }
+  return collector.finish(partials.front());
+}
+
+TEST(CollectorFixtureTest, CombinePartialResultsTest) {
+  std::vector vector{12, 12, 13, 13, 5, 4, 5, 5, 5, 5, 4};
+
+  EXPECT_EQ(11, collectInShards(streams::Collectors::counting(), vector, 3));
+  EXPECT_EQ(83, collectInShards(streams::Collectors::summingLong([](int item) { return item; }), vector, 3));
+  EXPECT_EQ(83.0, collectInShards(streams::Collectors::summingDouble([](int item) { return item * 1.0; }), vector, 4));
+  EXPECT_THAT(collectInShards(streams::Collectors::averaging(), vector, 2), ::testing::DoubleEq(83.0 / 11));
+  EXPECT_EQ(13, collectInShards(streams::Collectors::maxBy<int>(std::less<>()), vector, 3).value());
+  EXPECT_EQ(4, collectInShards(streams::Collectors::minBy<int>(std::less<>()), vector, 3).value());
+  EXPECT_EQ(83, collectInShards(streams::Collectors::reducing<int>(std::plus<>()), vector, 5));
+  EXPECT_THAT(collectInShards(streams::Collectors::toVector<int>(), vector, 3), ::testing::ElementsAreArray(vector));
+  EXPECT_THAT(collectInShards(streams::Collectors::toSet<int>(), vector, 3), ::testing::ElementsAre(4, 5, 12, 13));
+
+  auto groups = collectInShards(streams::Collectors::groupingByOrdered<int>([](auto item) { return item % 2; }), vector, 3);
+  EXPECT_THAT(groups[0], ::testing::ElementsAre(12, 12, 4, 4));
+  EXPECT_THAT(groups[1], ::testing::ElementsAre(13, 13, 5, 5, 5, 5, 5));
+
+  auto partitions = collectInShards(streams::Collectors::partitioningBy<int>([](auto item) { return item > 10; }), vector, 2);
+  EXPECT_THAT(partitions[true], ::testing::ElementsAre(12, 12, 13, 13));
+
+  auto totals = collectInShards(streams::Collectors::groupingBy<int>([](auto item) { return item; }, streams::Collectors::counting()), vector, 3);
+  EXPECT_EQ(5, totals[5]);
+}
+
+TEST(CollectorFixtureTest, GroupingByDenseTest) {
+  std::vector vector{12, 12, 13, 13, 5, 4, 5, 5, 5, 5, 4};
+
+  auto groups = streams::Collectors::groupingByDense<int>([](auto item) { return item % 4; }, 3).apply(vector);
+  EXPECT_EQ(4, groups.size());
+  EXPECT_THAT(groups[0], ::testing::ElementsAre(12, 12, 4, 4));
+  EXPECT_THAT(groups[1], ::testing::ElementsAre(13, 13, 5, 5, 5, 5, 5));
+  EXPECT_TRUE(groups[2].empty());
+
+  auto counts = streams::Collectors::groupingByDense<int>([](auto item) { return item; }, 13, streams::Collectors::counting()).apply(vector);
+  EXPECT_EQ(14, counts.size());
+  EXPECT_EQ(5, counts[5]);
+  EXPECT_EQ(2, counts[13]);
+  EXPECT_EQ(0, counts[0]);
+
+  auto shardedCounts = collectInShards(streams::Collectors::groupingByDense<int>([](auto item) { return item % 2; }, 1, streams::Collectors::counting()), vector, 3);
+  EXPECT_THAT(shardedCounts, ::testing::ElementsAre(4, 7));
+  auto shardedGroups = collectInShards(streams::Collectors::groupingByDense<int>([](auto item) { return item % 2; }, 1), vector, 3);
+  EXPECT_THAT(shardedGroups[0], ::testing::ElementsAre(12, 12, 4, 4));
+
+  EXPECT_THROW(streams::Collectors::groupingByDense<int>([](auto item) { return item; }, 12).apply(vector), std::out_of_range);
+}
+
+TEST(CollectorFixtureTest, ApproxDistinctTest) {
+  std::vector<int> vector;
+  for (int i = 0; i < 200000; i++) {
+    vector.emplace_back(i % 50000);
+  }
+  auto collector = streams::Collectors::approxDistinct<int>();
+  auto estimate = static_cast<double>(collector.apply(vector));
+  EXPECT_NEAR(50000, estimate, 50000 * 3 * streams::HyperLogLog().relativeError());
+  EXPECT_EQ(estimate, collectInShards(collector, vector, 4));
+
+  std::vector small{12, 12, 13, 13, 5, 4, 5, 5, 5, 5, 4};
+  EXPECT_EQ(4, streams::Collectors::approxDistinct<int>(10).apply(small));
+  std::vector<int> empty;
+  EXPECT_EQ(0, streams::Collectors::approxDistinct<int>().apply(empty));
+
+  auto sketch = streams::Collectors::toHyperLogLog<int>(14).apply(vector);
+  EXPECT_EQ(16384, sketch.bytes());
+  EXPECT_THROW(sketch.merge(streams::HyperLogLog(12)), std::invalid_argument);
+  EXPECT_THROW(streams::Collectors::approxDistinct<int>(20), std::invalid_argument);
+}
+
+TEST(CollectorFixtureTest, QuantilesTest) {
+  std::vector<int> vector(100000);
+  std::iota(vector.begin(), vector.end(), 1);
+  std::shuffle(vector.begin(), vector.end(), std::mt19937(7));
+
+  auto collector = streams::Collectors::quantiles({0, 0.5, 0.99, 0.999, 1});
+  auto result = collector.apply(vector);
+  EXPECT_EQ(1, result[0]);
+  EXPECT_NEAR(50000, result[1], 500);
+  EXPECT_NEAR(99000, result[2], 100);
+  EXPECT_NEAR(99900, result[3], 20);
+  EXPECT_EQ(100000, result[4]);
+
+  auto sharded = collectInShards(collector, vector, 4);
+  EXPECT_NEAR(50000, sharded[1], 500);
+  EXPECT_NEAR(99900, sharded[3], 50);
+
+  auto digest = streams::Collectors::toTDigest().apply(vector);
+  EXPECT_EQ(100000, digest.count());
+  EXPECT_GE(200, digest.centroids());
+
+  std::vector<int> empty;
+  EXPECT_TRUE(std::isnan(streams::Collectors::quantiles({0.5}).apply(empty)[0]));
+  EXPECT_THROW(streams::Collectors::quantiles({1.5}), std::invalid_argument);
+}
+
+TEST(CollectorFixtureTest, HeavyHittersTest) {
+  std::vector<int> vector;
+  for (int i = 0; i < 20000; i++) {
+    vector.emplace_back(i % 7 == 0 ? 1 : (i % 11 == 0 ? 2 : 100 + i % 5000));
+  }
+  std::shuffle(vector.begin(), vector.end(), std::mt19937(3));
+
+  auto collector = streams::Collectors::heavyHitters<int>(2, 0.01);
+  auto top = collector.apply(vector);
+  ASSERT_EQ(2, top.size());
+  EXPECT_EQ(1, top[0].key);
+  EXPECT_EQ(2, top[1].key);
+  auto exact = static_cast<size_t>(std::count(vector.begin(), vector.end(), 1));
+  EXPECT_LE(top[0].count - top[0].error, exact);
+  EXPECT_GE(top[0].count, exact);
+  EXPECT_LE(top[0].count, exact + 200);
+
+  auto sharded = collectInShards(collector, vector, 4);
+  ASSERT_EQ(2, sharded.size());
+  EXPECT_EQ(1, sharded[0].key);
+  EXPECT_EQ(2, sharded[1].key);
+  EXPECT_GE(sharded[0].count, exact);
+
+  std::vector small{12, 12, 13, 13, 5, 4, 5, 5, 5, 5, 4};
+  auto exactTop = streams::Collectors::heavyHitters<int>(1, 0.5).apply(small);
+  EXPECT_EQ(5, exactTop[0].key);
+  EXPECT_THROW(streams::Collectors::heavyHitters<int>(0, 0.1), std::invalid_argument);
+}
+
+TEST(CollectorFixtureTest, SummarizingTest) {
+  std::vector<double> vector;
+  std::mt19937 random(5);
+  std::normal_distribution<double> distribution(1e6, 3.0);
+  for (int i = 0; i < 1000; i++) {
+    vector.emplace_back(distribution(random));
+  }
+  double mean = std::accumulate(vector.begin(), vector.end(), 0.0) / vector.size();
+  double squaredDeviations = 0;
+  for (auto value : vector) {
+    squaredDeviations += (value - mean) * (value - mean);
+  }
+
+  auto statistics = streams::Collectors::summarizing().apply(vector);
+  EXPECT_EQ(1000, statistics.count());
+  EXPECT_EQ(*std::min_element(vector.begin(), vector.end()), statistics.min());
+  EXPECT_EQ(*std::max_element(vector.begin(), vector.end()), statistics.max());
+  EXPECT_NEAR(mean * 1000, statistics.sum(), 1e-3);
+  EXPECT_NEAR(mean, statistics.mean(), 1e-6);
+  EXPECT_NEAR(squaredDeviations / 1000, statistics.variance(), 1e-6);
+  EXPECT_NEAR(squaredDeviations / 999, statistics.sampleVariance(), 1e-6);
+
+  auto sharded = collectInShards(streams::Collectors::summarizing(), vector, 7);
+  EXPECT_EQ(1000, sharded.count());
+  EXPECT_EQ(statistics.min(), sharded.min());
+  EXPECT_EQ(statistics.max(), sharded.max());
+  EXPECT_NEAR(statistics.mean(), sharded.mean(), 1e-6);
+  EXPECT_NEAR(statistics.variance(), sharded.variance(), 1e-6);
+
+  std::vector small{12, 13, 5, 4, 5};
+  auto lengths = streams::Collectors::summarizing([](int item) { return item * 2; }).apply(small);
+  EXPECT_EQ(5, lengths.count());
+  EXPECT_EQ(8, lengths.min());
+  EXPECT_EQ(26, lengths.max());
+  EXPECT_EQ(78, lengths.sum());
+
+  std::vector<int> none;
+  auto empty = streams::Collectors::summarizing().apply(none);
+  EXPECT_EQ(0, empty.count());
+  EXPECT_EQ(0, empty.mean());
+  EXPECT_EQ(0, empty.variance());
+}
+
+TEST(CollectorFixtureTest, JoiningChunkedTest) {
+  std::vector<std::string> vector;
+  std::string expected;
+  for (int i = 0; i < 10000; i++) {
+    vector.emplace_back(std::to_string(i));
+    expected += (i > 0 ? "," : "") + vector.back();
+  }
+
+  auto collector = streams::Collectors::joiningChunked(",");
+  auto rope = collector.apply(vector);
+  EXPECT_EQ(10000, rope.elements);
+  EXPECT_EQ(expected.size(), rope.length);
+  EXPECT_LT(1, rope.chunks.size());
+  EXPECT_EQ(expected, rope.join("", ""));
+
+  auto sharded = collectInShards(collector, vector, 4);
+  EXPECT_EQ(expected, sharded.join("", ""));
+  EXPECT_EQ("{" + expected + "}", collectInShards(streams::Collectors::joining(",", "{", "}"), vector, 5));
+}
+
+TEST(CollectorFixtureTest, TeeingTest) {
+  std::vector vector{12, 13, 5, 4, 5, 13, 12, 5, 5, 5, 4};
+
+  auto collector = streams::Collectors::teeing(streams::Collectors::counting(),
+                                               streams::Collectors::averaging(),
+                                               streams::Collectors::maxBy<int>(std::less<>()),
+                                               [](size_t count, double average, std::optional<int> max) {
+                                                 return std::make_tuple(count, average, max.value());
+                                               });
+  auto [count, average, max] = collector.apply(vector);
+  EXPECT_EQ(11, count);
+  EXPECT_THAT(average, ::testing::DoubleEq(83.0 / 11));
+  EXPECT_EQ(13, max);
+  EXPECT_TRUE(collector.combinable());
+  EXPECT_FALSE(collector.hasCharacteristics(streams::UNORDERED));
+  EXPECT_EQ(std::make_tuple(size_t(11), 83.0 / 11, 13), collectInShards(collector, vector, 3));
+
+  auto range = streams::Collectors::teeing(streams::Collectors::minBy<int>(std::less<>()),
+                                           streams::Collectors::maxBy<int>(std::less<>()),
+                                           [](auto min, auto max) { return max.value() - min.value(); });
+  EXPECT_EQ(9, range.apply(vector));
+
+  auto duplicates = streams::Collectors::teeing(streams::Collectors::counting(),
+                                                streams::Collectors::toSet<int>(),
+                                                [](auto count, auto distinct) { return count - distinct.size(); });
+  EXPECT_EQ(7, duplicates.apply(vector));
+  EXPECT_TRUE(duplicates.hasCharacteristics(streams::UNORDERED));
+
+  streams::Collector last{[] { return 0; }, [](int &result, int element) { result = element; }, [](int &result) { return result; }};
+  auto firstAndLast = streams::Collectors::teeing(streams::Collectors::toVector<int>(), last, [](auto all, int lastElement) {
+    return all.front() * 100 + lastElement;
+  });
+  EXPECT_FALSE(firstAndLast.combinable());
+  EXPECT_EQ(1204, firstAndLast.apply(vector));
+}
+
+TEST(CollectorFixtureTest, AggregatingByTest) {
+  std::vector<int> vector;
+  for (int i = 0; i < 1000; i++) {
+    vector.emplace_back(i * 37 % 1000);
+  }
+  auto collector = streams::Collectors::aggregatingBy<int>([](auto item) { return item % 7; },
+                                                           streams::Aggregates::count(),
+                                                           streams::Aggregates::sum([](auto item) { return static_cast<long>(item); }),
+                                                           streams::Aggregates::max([](auto item) { return item; }));
+  auto table = collector.apply(vector);
+  auto sharded = collectInShards(collector, vector, 3);
+  ASSERT_EQ(7, table.size());
+  ASSERT_EQ(7, sharded.size());
+  for (size_t group = 0; group < table.size(); group++) {
+    int key = table.keys()[group];
+    long sum = 0;
+    size_t count = 0;
+    for (int item = key; item < 1000; item += 7) {
+      sum += item;
+      count++;
+    }
+    EXPECT_EQ(count, table.column<0>()[group]);
+    EXPECT_EQ(sum, table.column<1>()[group]);
+    EXPECT_EQ(994 + key <= 999 ? 994 + key : 987 + key, table.column<2>()[group]);
+    EXPECT_EQ(table.row(group), sharded.row(group));
+  }
+}
+
+TEST(CollectorFixtureTest, SampleTest) {
+  std::vector<int> vector(100);
+  std::iota(vector.begin(), vector.end(), 0);
+
+  auto sample = streams::Collectors::sample<int>(10, 42).apply(vector);
+  ASSERT_EQ(10, sample.size());
+  EXPECT_EQ(sample, streams::Collectors::sample<int>(10, 42).apply(vector));
+  EXPECT_NE(sample, streams::Collectors::sample<int>(10, 43).apply(vector));
+  std::vector small{1, 2, 3};
+  EXPECT_THAT(streams::Collectors::sampleSkipping<int>(10).apply(small), ::testing::ElementsAre(1, 2, 3));
+  EXPECT_THROW(streams::Collectors::sample<int>(0), std::invalid_argument);
+
+  // every element is kept with probability 10 / 100 in all modes
+  std::vector<size_t> kept(100);
+  std::vector<size_t> keptSkipping(100);
+  std::vector<size_t> keptSharded(100);
+  for (uint64_t seed = 0; seed < 2000; seed++) {
+    for (auto item : streams::Collectors::sample<int>(10, seed).apply(vector)) {
+      kept[item]++;
+    }
+    for (auto item : streams::Collectors::sampleSkipping<int>(10, seed).apply(vector)) {
+      keptSkipping[item]++;
+    }
+    for (auto item : collectInShards(streams::Collectors::sampleSkipping<int>(10, seed), vector, 3)) {
+      keptSharded[item]++;
+    }
+  }
+  for (size_t item = 0; item < 100; item++) {
+    EXPECT_NEAR(200, kept[item], 60) << item;
+    EXPECT_NEAR(200, keptSkipping[item], 60) << item;
+    EXPECT_NEAR(200, keptSharded[item], 60) << item;
+  }
+
+  std::vector<int> skewed;
+  for (int i = 0; i < 1000; i++) {
+    skewed.emplace_back(i % 100 == 0 ? -i : i);
+  }
+  auto strata = streams::Collectors::sampleBy<int>([](auto item) { return item < 0; }, 5, 1).apply(skewed);
+  ASSERT_EQ(2, strata.size());
+  EXPECT_EQ(5, strata[true].size());
+  EXPECT_EQ(5, strata[false].size());
+  EXPECT_TRUE(std::all_of(strata[true].begin(), strata[true].end(), [](auto item) { return item < 0; }));
+  auto shardedStrata = collectInShards(streams::Collectors::sampleBy<int>([](auto item) { return item < 0; }, 5, 1), skewed, 4);
+  EXPECT_EQ(5, shardedStrata[true].size());
+}
+
+TEST(CollectorFixtureTest, HistogramTest) {
+  std::vector<double> vector;
+  for (int i = -5; i < 105; i++) {
+    vector.emplace_back(i + 0.5);
+  }
+  vector.emplace_back(std::nan(""));
+
+  auto histogram = streams::Collectors::histogram(0, 100, 10).apply(vector);
+  ASSERT_EQ(10, histogram.bins());
+  for (size_t bin = 0; bin < 10; bin++) {
+    EXPECT_EQ(10, histogram.count(bin)) << bin;
+  }
+  EXPECT_EQ(6, histogram.underflow());
+  EXPECT_EQ(5, histogram.overflow());
+  EXPECT_EQ(111, histogram.total());
+  EXPECT_DOUBLE_EQ(30, histogram.lowerBound(3));
+  EXPECT_DOUBLE_EQ(50, histogram.quantile(0.5));
+  EXPECT_EQ(histogram.count(4), collectInShards(streams::Collectors::histogram(0, 100, 10), vector, 3).count(4));
+
+  std::vector<int> latencies;
+  for (int i = 0; i < 10000; i++) {
+    latencies.emplace_back(1 + i * i % 99991);
+  }
+  auto log = streams::Collectors::logHistogram([](int latency) { return latency; }, 1, 100000, 2).apply(latencies);
+  EXPECT_EQ(10000, log.total());
+  EXPECT_EQ(0, log.underflow());
+  EXPECT_EQ(0, log.overflow());
+  std::vector<int> sorted(latencies);
+  std::sort(sorted.begin(), sorted.end());
+  for (double fraction : {0.1, 0.5, 0.99}) {
+    double exact = sorted[static_cast<size_t>(std::ceil(fraction * 10000)) - 1];
+    EXPECT_NEAR(exact, log.quantile(fraction), exact * 0.01) << fraction;
+  }
+  for (size_t bin = 0; bin < log.bins(); bin++) {
+    EXPECT_LE(log.upperBound(bin) - log.lowerBound(bin), log.lowerBound(bin) * 0.01);
+  }
+  auto shardedLog = collectInShards(streams::Collectors::logHistogram(1, 100000, 2), latencies, 4);
+  EXPECT_EQ(log.quantile(0.99), shardedLog.quantile(0.99));
+
+  auto tiny = streams::Collectors::logHistogram(1, 1000, 1);
+  std::vector<double> outliers{0, -1, 0.5, 1, 1000, 2000, std::numeric_limits<double>::infinity()};
+  auto outlierCounts = tiny.apply(outliers);
+  EXPECT_EQ(3, outlierCounts.underflow());
+  EXPECT_EQ(2, outlierCounts.overflow());
+  std::vector<double> values;
+  std::mt19937 random(11);
+  std::uniform_real_distribution<double> distribution(-10, 2000);
+  for (int i = 0; i < 1000; i++) {
+    values.emplace_back(distribution(random));
+  }
+  for (auto empty : {streams::Histogram::linear(0, 1000, 7), streams::Histogram::logarithmic(1, 1000, 3)}) {
+    auto blocks = empty;
+    blocks.addBlock(values.data(), values.size());
+    for (auto value : values) {
+      empty.add(value);
+    }
+    EXPECT_EQ(empty.underflow(), blocks.underflow());
+    EXPECT_EQ(empty.overflow(), blocks.overflow());
+    for (size_t bin = 0; bin < empty.bins(); bin++) {
+      EXPECT_EQ(empty.count(bin), blocks.count(bin));
+    }
+  }
+  EXPECT_THROW(streams::Collectors::logHistogram(0, 10), std::invalid_argument);
+  EXPECT_THROW(streams::Collectors::histogram(1, 1, 10), std::invalid_argument);
+  EXPECT_THROW(outlierCounts.merge(histogram), std::invalid_argument);
+}
+
+TEST(CollectorFixtureTest, BloomFilterTest) {
+  std::vector<long> vector;
+  for (long i = 0; i < 10000; i++) {
+    vector.emplace_back(i * 3);
+  }
+  auto collector = streams::Collectors::bloomFilter<long>(10000, 0.01);
+  auto filter = collector.apply(vector);
+  EXPECT_EQ(7, filter.hashes());
+  EXPECT_LE(filter.bytes(), 10000 * 1.25);
+  EXPECT_TRUE(std::all_of(vector.begin(), vector.end(), [&filter](auto item) { return filter.mightContain(item); }));
+  size_t falsePositives = 0;
+  for (long i = 0; i < 100000; i++) {
+    falsePositives += filter.mightContain(i * 3 + 1) ? 1 : 0;
+  }
+  EXPECT_LT(falsePositives, 2000);
+
+  auto sharded = collectInShards(collector, vector, 4);
+  EXPECT_TRUE(std::all_of(vector.begin(), vector.end(), [&sharded](auto item) { return sharded.mightContain(item); }));
+  for (long i = 0; i < 1000; i++) {
+    EXPECT_EQ(filter.mightContain(i), sharded.mightContain(i));
+  }
+  EXPECT_THROW(filter.merge(streams::BloomFilter<long>(100)), std::invalid_argument);
+  EXPECT_THROW(streams::Collectors::bloomFilter<long>(10, 1), std::invalid_argument);
+}
+
+TEST(CollectorFixtureTest, MoveOnlyElementsTest) {
+  auto words = [] {
+    std::vector<std::unique_ptr<std::string>> words;
+    for (const char *word : {"stream", "map", "filter", "reduce", "sum"}) {
+      words.emplace_back(std::make_unique<std::string>(word));
+    }
+    return words;
+  };
+  auto byLength = streams::Collectors::groupingByOrdered<std::unique_ptr<std::string>>([](const auto &word) { return word->size(); }).apply(words());
+  ASSERT_EQ(2, byLength.size());
+  ASSERT_EQ(2, byLength[3].size());
+  EXPECT_EQ("sum", *byLength[3][1]);
+
+  auto longest = streams::Collectors::maxBy<std::unique_ptr<std::string>>([](const auto &left, const auto &right) { return *left < *right; }).apply(words());
+  EXPECT_EQ("sum", *longest.value());
+
+  auto partitions = streams::Collectors::partitioningBy<std::unique_ptr<std::string>>([](const auto &word) { return word->size() > 3; },
+                                                                                      streams::Collectors::toVector<std::unique_ptr<std::string>>())
+                        .apply(words());
+  EXPECT_EQ(3, partitions[true].size());
+
+  auto sampled = streams::Collectors::sample<std::unique_ptr<std::string>>(2, 7).apply(words());
+  ASSERT_EQ(2, sampled.size());
+  EXPECT_NE(nullptr, sampled[0]);
+  EXPECT_NE(nullptr, sampled[1]);
+  EXPECT_EQ(2, streams::Collectors::sampleSkipping<std::unique_ptr<std::string>>(2, 7).apply(words()).size());
+
+  std::vector<std::string> owned{"alpha", "beta", "gamma"};
+  auto moved = streams::Collectors::toVector<std::string>().apply(std::move(owned));
+  EXPECT_THAT(moved, ::testing::ElementsAre("alpha", "beta", "gamma"));
+}
+
+TEST(CollectorFixtureTest, CharacteristicsTest) {
+  EXPECT_TRUE(streams::Collectors::counting().hasCharacteristics(streams::UNORDERED | streams::IDENTITY_FINISH));
+  EXPECT_TRUE(streams::Collectors::toSet<int>().hasCharacteristics(streams::UNORDERED));
+  EXPECT_FALSE(streams::Collectors::toVector<int>().hasCharacteristics(streams::UNORDERED));
+  EXPECT_TRUE(streams::Collectors::toVector<int>().hasCharacteristics(streams::IDENTITY_FINISH));
+  EXPECT_FALSE(streams::Collectors::collectingAndThen(streams::Collectors::counting(), [](auto count) { return count * 2; }).hasCharacteristics(streams::IDENTITY_FINISH));
+  EXPECT_FALSE(streams::Collectors::toVector<int>().hasCharacteristics(streams::CONCURRENT));
+  EXPECT_TRUE(streams::Collectors::counting().combinable());
+}
 }// namespace aalbatross::utils::test
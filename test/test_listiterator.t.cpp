@@ -2,6 +2,7 @@
 
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
+#include <list>
 
 namespace aalbatross::utils::test {
 TEST(ListIteratorFixture, ReturnListOfValues) {
@@ -144,4 +145,16 @@ TEST(ListIteratorFixture, ReturnEmptyListIterator) {
   EXPECT_THAT(out,
               ::testing::UnorderedElementsAre());
 }
+TEST(ListIteratorFixture, ReturnSizeOfSizedSources) {
+  std::vector vec{1, 2, 3, 4, 5};
+  iterators::ListIterator vecIter(vec.begin(), vec.end());
+  EXPECT_EQ(5, vecIter.size().value());
+
+  std::list<int> list{1, 2, 3};
+  iterators::ListIterator listIter(list.begin(), list.end());
+  EXPECT_EQ(3, listIter.size().value());
+  listIter.hasNext();
+  EXPECT_EQ(3, listIter.size().value());
+}
+
 }// namespace aalbatross::utils::test
\ No newline at end of file
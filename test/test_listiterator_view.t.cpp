@@ -180,4 +180,19 @@ TEST(ListIteratorViewFixture, ReturnEmptyListIterator) {
               ::testing::UnorderedElementsAre());
 }
 
+TEST(ListIteratorViewFixture, ReturnConsumableListOnce) {
+  std::vector<std::string> vec{"one", "two", "three"};
+  iterators::ListIteratorView iter(std::move(vec), true);
+
+  std::vector<std::string> out;
+  while (iter.hasNext()) {
+    out.emplace_back(iter.take().value());
+  }
+  EXPECT_THAT(out, ::testing::ElementsAre("one", "two", "three"));
+
+  iter.reset();
+  EXPECT_EQ(0, iter.size().value());
+  EXPECT_FALSE(iter.hasNext());
+}
+
 }// namespace aalbatross::utils::test
\ No newline at end of file
@@ -0,0 +1,104 @@
+#ifndef STREAMS4CPP_PROFILING
+#define STREAMS4CPP_PROFILING
+#endif
+#include <aalbatross/utils/streams/stream.h>
+#include <aalbatross/utils/streams/ub_stream.h>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+namespace aalbatross::utils::test {
+using namespace streams;
+
+std::vector<std::string> stageNames(const PipelineProfile &profile) {
+  std::vector<std::string> names;
+  for (const auto &stage : profile.stages) {
+    names.emplace_back(stage.name);
+  }
+  return names;
+}
+
+TEST(ProfileTestFixture, ReturnExplainOfStream) {
+  std::vector data{1, 2, 3, 4, 5};
+  Stream<int> stream(data.begin(), data.end());
+  auto pipeline = stream.map([](auto element) { return element * 2; }).filter([](auto element) { return element > 4; }).limit(2);
+  EXPECT_THAT(stageNames(pipeline.explain()), ::testing::ElementsAre("source", "map", "filter", "limit"));
+  EXPECT_THAT(stageNames(stream.explain()), ::testing::ElementsAre("source"));
+}
+
+TEST(ProfileTestFixture, ReturnProfileOfStream) {
+  std::vector data{1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+  Stream<int> stream(data.begin(), data.end());
+  auto pipeline = stream.map([](auto element) { return element * 2; }).filter([](auto element) { return element > 4; }).limit(3);
+  auto profile = pipeline.profile();
+  ASSERT_EQ(profile.stages.size(), 4);
+  EXPECT_EQ(profile.stages[0].elementsOut, 5);
+  EXPECT_EQ(profile.stages[1].elementsIn, 5);
+  EXPECT_EQ(profile.stages[1].elementsOut, 5);
+  EXPECT_EQ(profile.stages[2].elementsIn, 5);
+  EXPECT_EQ(profile.stages[2].elementsOut, 3);
+  EXPECT_EQ(profile.stages[3].elementsIn, 3);
+  EXPECT_EQ(profile.stages[3].elementsOut, 3);
+  EXPECT_THAT(pipeline.toVector(), ::testing::ElementsAre(6, 8, 10));
+  EXPECT_EQ(pipeline.profile().stages[3].elementsOut, 3);
+}
+
+TEST(ProfileTestFixture, ReturnStrategyOfAdaptiveStages) {
+  std::vector data{3, 1, 2, 3, 1, 2, 3};
+  Stream<int> stream(data.begin(), data.end());
+  auto pipeline = stream.distinct().map([](auto element) { return element * 2; });
+  EXPECT_EQ("adaptive", pipeline.explain().stages[1].strategy);
+  auto profile = pipeline.profile();
+  ASSERT_EQ(profile.stages.size(), 3);
+  EXPECT_EQ(profile.stages[1].name, "distinct");
+  EXPECT_EQ(profile.stages[1].strategy, "dense");
+  EXPECT_EQ(profile.stages[1].estimatedDistinct, 3);
+  EXPECT_EQ(profile.stages[1].elementsIn, 7);
+  EXPECT_EQ(profile.stages[1].elementsOut, 3);
+  EXPECT_GT(profile.stages[1].wallTime.count(), 0);
+  EXPECT_TRUE(profile.stages[2].strategy.empty());
+  EXPECT_NE(profile.toString().find("dense"), std::string::npos);
+}
+
+TEST(ProfileTestFixture, ReturnCheapStagesCheaperThanSorted) {
+  std::vector<int> data(200000);
+  std::mt19937 generator(7);
+  std::generate(data.begin(), data.end(), [&generator]() { return static_cast<int>(generator()); });
+  Stream<int> stream(data.begin(), data.end());
+  auto pipeline = stream.map([](auto element) { return element + 1; }).sorted(std::less<>());
+  auto profile = pipeline.profile();
+  ASSERT_EQ(profile.stages.size(), 3);
+  EXPECT_EQ(profile.stages[1].name, "map");
+  EXPECT_EQ(profile.stages[2].name, "sorted");
+  EXPECT_EQ(profile.stages[2].elementsIn, data.size());
+  EXPECT_LT(profile.stages[1].wallTime, profile.stages[2].wallTime);
+}
+
+TEST(ProfileTestFixture, ReturnTimeOfDistinct) {
+  std::vector<int> data(100000);
+  std::mt19937 generator(11);
+  std::generate(data.begin(), data.end(), [&generator]() { return static_cast<int>(generator() % 5000); });
+  Stream<int> stream(data.begin(), data.end());
+  auto profile = stream.distinct().profile();
+  ASSERT_EQ(profile.stages.size(), 2);
+  EXPECT_EQ(profile.stages[1].name, "distinct");
+  EXPECT_EQ(profile.stages[1].elementsIn, data.size());
+  EXPECT_GT(profile.stages[1].wallTime.count(), 0);
+}
+
+TEST(ProfileTestFixture, ReturnProfileOfUBStream) {
+  std::vector data{1, 2, 3, 4, 5, 6};
+  UBStream<int> stream(data.begin(), data.end());
+  auto pipeline = stream.filter([](auto element) { return element % 2 == 0; }).map([](auto element) { return element + 1; });
+  EXPECT_THAT(stageNames(pipeline.explain()), ::testing::ElementsAre("source", "filter", "map"));
+  auto profile = pipeline.profile();
+  ASSERT_EQ(profile.stages.size(), 3);
+  EXPECT_EQ(profile.stages[0].elementsOut, 6);
+  EXPECT_EQ(profile.stages[1].elementsIn, 6);
+  EXPECT_EQ(profile.stages[1].elementsOut, 3);
+  EXPECT_EQ(profile.stages[2].elementsIn, 3);
+  EXPECT_EQ(profile.stages[2].elementsOut, 3);
+}
+}// namespace aalbatross::utils::test
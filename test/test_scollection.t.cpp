@@ -1,4 +1,5 @@
 #include <aalbatross/utils/collection/streamabledeque.h>
+#include <aalbatross/utils/collection/streamableflatmap.h>
 #include <aalbatross/utils/collection/streamablelist.h>
 #include <aalbatross/utils/collection/streamablemap.h>
 #include <aalbatross/utils/collection/streamableset.h>
@@ -79,4 +80,62 @@ TEST(SUMapTestFixture, ReturnTransformedStream) {
   EXPECT_TRUE(smap1.empty());
   EXPECT_THAT(smap1.stream().toVector(), ::testing::ElementsAre());
 }
+TEST(SFlatMapTestFixture, ReturnTransformedStream) {
+  collection::SFlatMap<int, std::string> smap{{1, "one"}, {2, "two"}, {3, "three"}};
+  auto stream = smap.stream().map([](auto element) { return element.second; });
+  EXPECT_THAT(stream.toVector(), ::testing::UnorderedElementsAre("one", "two", "three"));
+  collection::SFlatMap<int, std::string> smap1;
+  EXPECT_TRUE(smap1.empty());
+  EXPECT_THAT(smap1.stream().toVector(), ::testing::ElementsAre());
+}
+
+TEST(SFlatMapTestFixture, InsertFindAndErase) {
+  collection::SFlatMap<int, int> smap;
+  for (int i = 0; i < 1000; i++) {
+    smap[i] = i * 2;
+  }
+  EXPECT_EQ(1000, smap.size());
+  EXPECT_FALSE(smap.try_emplace(10, 0).second);
+  EXPECT_EQ(20, smap.at(10));
+  EXPECT_THROW(smap.at(1000), std::out_of_range);
+
+  for (int i = 0; i < 1000; i += 2) {
+    EXPECT_EQ(1, smap.erase(i));
+  }
+  EXPECT_EQ(0, smap.erase(0));
+  EXPECT_EQ(500, smap.size());
+  EXPECT_FALSE(smap.contains(10));
+  EXPECT_TRUE(smap.contains(11));
+  EXPECT_EQ(500, std::distance(smap.begin(), smap.end()));
+
+  // reinserting over tombstones must not grow the table
+  size_t capacity = smap.capacity();
+  for (int repeat = 0; repeat < 10; repeat++) {
+    for (int i = 0; i < 1000; i += 2) {
+      smap.emplace(i, i);
+    }
+    for (int i = 0; i < 1000; i += 2) {
+      smap.erase(i);
+    }
+  }
+  EXPECT_EQ(capacity, smap.capacity());
+  EXPECT_EQ(500 * 500, smap.stream().map([](const auto &entry) { return entry.first; }).sum());
+
+  collection::SFlatMap<int, int> copy = smap;
+  EXPECT_EQ(copy, smap);
+  copy.clear();
+  EXPECT_TRUE(copy.empty());
+  EXPECT_EQ(copy.end(), copy.find(11));
+}
+
+TEST(SFlatMapTestFixture, ReserveAvoidsRehash) {
+  collection::SFlatMap<std::string, int> smap(100);
+  size_t capacity = smap.capacity();
+  EXPECT_LE(100, capacity - capacity / 8);
+  for (int i = 0; i < 100; i++) {
+    smap.insert_or_assign(std::to_string(i), i);
+  }
+  EXPECT_EQ(capacity, smap.capacity());
+  EXPECT_EQ(42, smap["42"]);
+}
 }// namespace aalbatross::utils::test
\ No newline at end of file
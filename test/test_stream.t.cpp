@@ -1,10 +1,14 @@
 #pragma clang diagnostic push
 #pragma ide diagnostic ignored "cppcoreguidelines-avoid-magic-numbers"
 #include <aalbatross/utils/iterators/listiterator.h>
+#include <aalbatross/utils/streams/collectors.h>
 #include <aalbatross/utils/streams/stream.h>
 
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
+#include <list>
+#include <map>
+#include <numeric>
 namespace aalbatross::utils::test {
 using namespace streams;
 using namespace iterators;
@@ -14,6 +18,24 @@ const auto greaterThan4 = [](auto number) { return number > 4; };
 const auto print = [](const auto &element) { std::cout << element << std::endl; };
 const auto toString = [](const auto element) { return std::to_string(element) + " something"; };
 
+struct CopyCounted {
+  static inline size_t copies = 0;
+  int value;
+  std::string payload;
+
+  explicit CopyCounted(int value) : value(value), payload(64, 'x') {}
+  CopyCounted(const CopyCounted &other) : value(other.value), payload(other.payload) { copies++; }
+  CopyCounted(CopyCounted &&) noexcept = default;
+  CopyCounted &operator=(const CopyCounted &other) {
+    value = other.value;
+    payload = other.payload;
+    copies++;
+    return *this;
+  }
+  CopyCounted &operator=(CopyCounted &&) noexcept = default;
+  ~CopyCounted() = default;
+};
+
 TEST(StreamTestFixture, ReturnTransformedStream) {
   std::vector data{1, 2, 3, 4, 5};
   Stream<int> stream(data.begin(), data.end());
@@ -122,5 +144,339 @@ TEST(StreamTestFixture, ReturnStreamViewToStreamTest) {
   EXPECT_THAT(result["even"], ::testing::ElementsAre(20, 10, 16, 40, 50));
   EXPECT_THAT(result["odd"], ::testing::ElementsAre(21, 29, 17));
 }
+TEST(StreamTestFixture, ReturnCountStream) {
+  std::vector data{21, 20, 29, 10, 17, 16, 40, 50};
+  Stream<int> stream(data.begin(), data.end());
+  EXPECT_EQ(8, stream.count());
+  EXPECT_EQ(8, stream.map(doubler).sorted(std::less<>()).reverse().count());
+  EXPECT_EQ(3, stream.limit(3).count());
+  EXPECT_EQ(6, stream.skip(2).count());
+  EXPECT_EQ(0, stream.skip(20).count());
+  EXPECT_EQ(5, stream.filter([](auto number) { return number % 2 == 0; }).count());
+  EXPECT_EQ(2, stream.filter([](auto number) { return number % 2 == 0; }).limit(2).count());
+  EXPECT_EQ(8, stream.collect(Collectors::counting()));
+}
+
+TEST(StreamTestFixture, ReturnCountWithoutVisitingSizedStream) {
+  std::vector data{21, 20, 29, 10, 17, 16, 40, 50};
+  Stream<int> stream(data.begin(), data.end());
+  size_t calls = 0;
+  auto mapped = stream.map([&calls](auto number) {
+                        calls++;
+                        return number * 2;
+                      })
+                    .sorted(std::greater<>())
+                    .reverse();
+  EXPECT_EQ(8, mapped.count());
+  EXPECT_EQ(8, mapped.collect(Collectors::counting()));
+  EXPECT_EQ(0, calls);
+  EXPECT_THAT(mapped.limit(2).toVector(), ::testing::ElementsAre(20, 32));
+  EXPECT_EQ(8, calls);
+}
+
+TEST(StreamTestFixture, ReturnLazyReverseStream) {
+  std::vector data{21, 20, 29, 10, 17, 16, 40, 50};
+  Stream<int> stream(data.begin(), data.end());
+  size_t calls = 0;
+  auto latest = stream.map([&calls](auto number) {
+                        calls++;
+                        return number * 2;
+                      })
+                    .filter([](auto number) { return number > 30; })
+                    .reverse()
+                    .limit(2)
+                    .toVector();
+  EXPECT_THAT(latest, ::testing::ElementsAre(100, 80));
+  EXPECT_EQ(2, calls);
+
+  std::list<int> list{1, 2, 3, 4};
+  Stream<int> listStream(list.begin(), list.end());
+  EXPECT_THAT(listStream.reverse().toVector(), ::testing::ElementsAre(4, 3, 2, 1));
+  EXPECT_THAT(listStream.reverse().reverse().toVector(), ::testing::ElementsAre(1, 2, 3, 4));
+
+  std::map<int, std::string> map{{1, "one"}, {2, "two"}, {3, "three"}};
+  Stream<std::pair<const int, std::string>> mapStream(map.begin(), map.end());
+  EXPECT_THAT(mapStream.map([](auto entry) { return entry.second; }).reverse().toVector(), ::testing::ElementsAre("three", "two", "one"));
+}
+
+TEST(StreamTestFixture, ReturnBufferedReverseStream) {
+  std::vector data{21, 20, 29, 10, 17, 16, 40, 50};
+  Stream<int> stream(data.begin(), data.end());
+  EXPECT_THAT(stream.limit(3).reverse().toVector(), ::testing::ElementsAre(29, 20, 21));
+  EXPECT_THAT(stream.skip(5).reverse().toVector(), ::testing::ElementsAre(50, 40, 16));
+  EXPECT_THAT(stream.sorted(std::less<>()).reverse().limit(3).toVector(), ::testing::ElementsAre(50, 40, 29));
+  EXPECT_THAT(stream.distinct().reverse().limit(2).toVector(), ::testing::ElementsAre(50, 40));
+}
+
+TEST(StreamTestFixture, ReturnChunkedStream) {
+  std::vector data{1, 2, 3, 4, 5, 6, 7};
+  Stream<int> stream(data.begin(), data.end());
+  auto chunks = stream.chunked(3).map([](auto window) { return window.toVector(); }).toVector();
+  EXPECT_EQ(3, chunks.size());
+  EXPECT_THAT(chunks[0], ::testing::ElementsAre(1, 2, 3));
+  EXPECT_THAT(chunks[1], ::testing::ElementsAre(4, 5, 6));
+  EXPECT_THAT(chunks[2], ::testing::ElementsAre(7));
+  EXPECT_EQ(3, stream.chunked(3).count());
+  EXPECT_EQ(7, stream.chunked(1).count());
+  EXPECT_THAT(stream.chunked(7).map([](auto window) { return window.stream().sum(); }).toVector(), ::testing::ElementsAre(28));
+}
+
+TEST(StreamTestFixture, ReturnSlidingStream) {
+  std::vector data{1, 2, 3, 4, 5, 6, 7};
+  Stream<int> stream(data.begin(), data.end());
+  auto sums = stream.sliding(3).map([](auto window) { return std::accumulate(window.begin(), window.end(), 0); });
+  EXPECT_THAT(sums.toVector(), ::testing::ElementsAre(6, 9, 12, 15, 18));
+  EXPECT_EQ(5, sums.count());
+
+  auto stepped = stream.sliding(2, 3).map([](auto window) { return window.toVector(); });
+  EXPECT_THAT(stepped.toVector(), ::testing::ElementsAre(::testing::ElementsAre(1, 2), ::testing::ElementsAre(4, 5)));
+  EXPECT_EQ(2, stepped.count());
+
+  auto overlapping = stream.sliding(4, 2).map([](auto window) { return window.toVector(); });
+  EXPECT_THAT(overlapping.toVector(), ::testing::ElementsAre(::testing::ElementsAre(1, 2, 3, 4), ::testing::ElementsAre(3, 4, 5, 6)));
+  EXPECT_EQ(2, overlapping.count());
+
+  EXPECT_EQ(0, stream.sliding(8).count());
+  EXPECT_THAT(stream.sliding(8).toVector(), ::testing::IsEmpty());
+}
+
+TEST(StreamTestFixture, ReturnSlidingStreamOnUnsizedSource) {
+  std::vector data{110.0, 213.90, 311.69, 412.23, 512.1, 610.03, 1000.0, 2102.12};
+  Stream<double> stream(data.begin(), data.end());
+  auto movingAverage = stream.filter([](auto element) { return element > 0; })
+                           .sliding(2)
+                           .map([](auto window) { return std::accumulate(window.begin(), window.end(), 0.0) / window.size(); });
+  using namespace ::testing;
+  EXPECT_THAT(movingAverage.toVector(), ElementsAre(DoubleEq(161.95), DoubleEq(262.795), DoubleEq(361.96), DoubleEq(462.165), DoubleEq(561.065), DoubleEq(805.015), DoubleEq(1551.06)));
+  EXPECT_EQ(7, movingAverage.count());
+}
+
+TEST(StreamTestFixture, ReturnCachedStream) {
+  std::vector data{1, 2, 3, 4, 5};
+  Stream<int> stream(data.begin(), data.end());
+  size_t evaluations = 0;
+  auto cached = stream.map([&evaluations](auto element) {
+                        evaluations++;
+                        return element * 2;
+                      })
+                    .cache();
+  EXPECT_EQ(0, cached.cachedBytes());
+  EXPECT_EQ(5, cached.count());
+  EXPECT_EQ(5, evaluations);
+  EXPECT_EQ(10, cached.max().value());
+  EXPECT_EQ(30, cached.sum());
+  EXPECT_THAT(cached.filter(greaterThan4).toVector(), ::testing::ElementsAre(6, 8, 10));
+  EXPECT_THAT(cached.reverse().toVector(), ::testing::ElementsAre(10, 8, 6, 4, 2));
+  EXPECT_EQ(5, evaluations);
+  EXPECT_EQ(5 * sizeof(int), cached.cachedBytes());
+  EXPECT_GE(CacheControl::totalBytes().load(), 5 * sizeof(int));
+
+  cached.invalidate();
+  EXPECT_EQ(0, cached.cachedBytes());
+  EXPECT_THAT(cached.toVector(), ::testing::ElementsAre(2, 4, 6, 8, 10));
+  EXPECT_EQ(10, evaluations);
+}
+
+TEST(StreamTestFixture, ReturnCollectedStreamWithoutMaterializing) {
+  std::vector data{1, 2, 3, 4, 5};
+  Stream<int> stream(data.begin(), data.end());
+  size_t evaluations = 0;
+  auto progress = stream.map([&evaluations](auto element) {
+                          evaluations++;
+                          return element;
+                        })
+                      .collect(Collector{[] { return std::vector<size_t>(); },
+                                         [&evaluations](std::vector<size_t> &intermediate, const auto & /*element*/) { intermediate.emplace_back(evaluations); },
+                                         [](std::vector<size_t> &intermediate) { return intermediate; }});
+  EXPECT_THAT(progress, ::testing::ElementsAre(1, 2, 3, 4, 5));
+  EXPECT_EQ(12, stream.filter(greaterThan4).map(doubler).collect(Collectors::summingLong([](auto element) { return element + 2; })));
+}
+
+TEST(StreamTestFixture, ReturnAggregatedStream) {
+  std::vector data{12, 2, 13, 4, 5, 21, 7};
+  Stream<int> stream(data.begin(), data.end());
+  auto table = stream.aggregateBy([](auto element) { return element % 2 == 0 ? "even" : "odd"; },
+                                  Aggregates::count(),
+                                  Aggregates::sum([](auto element) { return element; }),
+                                  Aggregates::average([](auto element) { return element; }),
+                                  Aggregates::min([](auto element) { return element; }),
+                                  Aggregates::max([](auto element) { return element * 10; }));
+  ASSERT_EQ(2, table.size());
+  EXPECT_STREQ("even", table.keys()[0]);
+  EXPECT_THAT(table.column<0>(), ::testing::ElementsAre(3, 4));
+  EXPECT_THAT(table.column<1>(), ::testing::ElementsAre(18, 46));
+  EXPECT_THAT(table.column<2>(), ::testing::ElementsAre(6.0, 11.5));
+  EXPECT_EQ(std::make_tuple("odd", size_t(4), 46, 11.5, 5, 210), table.row(1));
+
+  auto sizes = stream.filter(greaterThan4).aggregateBy([](auto element) { return element / 10; }, Aggregates::count());
+  EXPECT_THAT(sizes.keys(), ::testing::ElementsAre(1, 0, 2));
+  EXPECT_THAT(sizes.column<0>(), ::testing::ElementsAre(2, 2, 1));
+  EXPECT_TRUE(stream.filter([](auto element) { return element > 100; }).aggregateBy(doubler, Aggregates::count()).empty());
+
+  std::vector<CopyCounted> records;
+  for (int i = 0; i < 600; i++) {
+    records.emplace_back(i);
+  }
+  CopyCounted::copies = 0;
+  auto totals = Stream<CopyCounted>::of(std::move(records)).aggregateBy([](const auto &record) { return record.value % 3; }, Aggregates::count(), Aggregates::sum([](const auto &record) { return record.value; }));
+  EXPECT_EQ(0, CopyCounted::copies);
+  EXPECT_THAT(totals.column<0>(), ::testing::ElementsAre(200, 200, 200));
+
+  size_t calls = 0;
+  auto counted = [&calls](auto element) {
+    calls++;
+    return element;
+  };
+  auto extremes = stream.aggregateBy([](auto element) { return element % 2; }, Aggregates::min(counted), Aggregates::max(counted), Aggregates::sum(counted), Aggregates::average(counted));
+  EXPECT_EQ(4 * data.size(), calls);
+  EXPECT_EQ(std::make_tuple(0, 2, 12, 18, 6.0), extremes.row(0));
+}
+
+TEST(StreamTestFixture, ReturnMightContainFilteredStream) {
+  std::vector data{12, 2, 13, 4, 5, 21, 7};
+  std::vector build{2, 4, 21};
+  auto filter = Collectors::bloomFilter<int>(100, 0.0001).apply(build);
+  Stream<int> stream(data.begin(), data.end());
+  auto joined = stream.filterMightContain(filter);
+  EXPECT_THAT(joined.toVector(), ::testing::ElementsAre(2, 4, 21));
+  EXPECT_THAT(joined.map(doubler).toVector(), ::testing::ElementsAre(4, 8, 42));
+}
+
+TEST(StreamTestFixture, ReturnMoveOnlyStream) {
+  std::vector<std::unique_ptr<int>> data;
+  for (int i = 1; i <= 6; i++) {
+    data.emplace_back(std::make_unique<int>(i));
+  }
+  auto stream = Stream<std::unique_ptr<int>>::of(std::move(data))
+                    .filter([](const auto &element) { return *element % 2 == 0; })
+                    .map([](std::unique_ptr<int> element) {
+                      *element *= 10;
+                      return element;
+                    })
+                    .sorted([](const auto &left, const auto &right) { return *left > *right; });
+  auto result = stream.toVector();
+  ASSERT_EQ(3, result.size());
+  EXPECT_EQ(60, *result[0]);
+  EXPECT_EQ(40, *result[1]);
+  EXPECT_EQ(20, *result[2]);
+  EXPECT_TRUE(stream.toVector().empty());
+  EXPECT_EQ(0, stream.count());
+
+  std::vector<std::unique_ptr<int>> more;
+  for (int i = 1; i <= 5; i++) {
+    more.emplace_back(std::make_unique<int>(i));
+  }
+  auto groups = Stream<std::unique_ptr<int>>::of(std::move(more)).collect(Collectors::groupingBy<std::unique_ptr<int>>([](const auto &element) { return *element % 2; }));
+  ASSERT_EQ(3, groups[1].size());
+  EXPECT_EQ(5, *groups[1].back());
+}
+
+TEST(StreamTestFixture, ReturnStreamMovingElementsThroughStages) {
+  std::vector<CopyCounted> data;
+  for (int i = 0; i < 100; i++) {
+    data.emplace_back(i);
+  }
+
+  CopyCounted::copies = 0;
+  Stream<CopyCounted> borrowed(data.begin(), data.end());
+  EXPECT_EQ(100, borrowed.map([](CopyCounted element) { return element; }).toVector().size());
+  EXPECT_EQ(100, CopyCounted::copies);
+
+  CopyCounted::copies = 0;
+  auto groups = Stream<CopyCounted>::of(std::move(data))
+                    .filter([](const auto &element) { return element.value % 3 != 0; })
+                    .map([](CopyCounted element) {
+                      element.value *= 2;
+                      return element;
+                    })
+                    .skip(2)
+                    .limit(50)
+                    .collect(Collectors::groupingByOrdered<CopyCounted>([](const auto &element) { return element.value % 4; }));
+  EXPECT_EQ(0, CopyCounted::copies);
+  ASSERT_EQ(2, groups.size());
+  EXPECT_EQ(25, groups[0].size());
+  EXPECT_EQ(10, groups[2].front().value);
+  EXPECT_EQ(64, groups[2].front().payload.size());
+}
+
+TEST(StreamTestFixture, ReturnAdaptiveDistinctStream) {
+  std::vector<int> repeated(5000);
+  std::iota(repeated.begin(), repeated.end(), 0);
+  auto dense = Stream<int>(repeated.begin(), repeated.end()).map([](auto element) { return element % 100 - 50; }).distinct();
+  EXPECT_EQ("adaptive", dense.explain().stages[2].strategy);
+  auto denseElements = dense.toVector();
+  ASSERT_EQ(100, denseElements.size());
+  EXPECT_EQ(-50, denseElements.front());
+  EXPECT_EQ(49, denseElements.back());
+  EXPECT_EQ("dense", dense.explain().stages[2].strategy);
+  EXPECT_NEAR(100, dense.explain().stages[2].estimatedDistinct, 10);
+
+  auto hashed = Stream<int>(repeated.begin(), repeated.end()).map([](auto element) { return std::to_string(element % 50); }).distinct();
+  auto hashedElements = hashed.toVector();
+  ASSERT_EQ(50, hashedElements.size());
+  EXPECT_TRUE(std::is_sorted(hashedElements.begin(), hashedElements.end()));
+  EXPECT_EQ("hash", hashed.explain().stages[2].strategy);
+
+  auto sorted = Stream<int>(repeated.begin(), repeated.end()).map([](auto element) { return (element * 7919) % 1000003; }).distinct();
+  auto sortedElements = sorted.toVector();
+  EXPECT_EQ(5000, sortedElements.size());
+  EXPECT_TRUE(std::is_sorted(sortedElements.begin(), sortedElements.end()));
+  EXPECT_EQ("sort", sorted.explain().stages[2].strategy);
+
+  repeated.emplace_back(1000000000);
+  repeated.emplace_back(0);
+  auto sparse = Stream<int>(repeated.begin(), repeated.end()).distinct();
+  auto sparseElements = sparse.toVector();
+  ASSERT_EQ(5001, sparseElements.size());
+  EXPECT_EQ(1000000000, sparseElements.back());
+  EXPECT_EQ("sort", sparse.explain().stages[1].strategy);
+}
+
+TEST(StreamTestFixture, ReturnAdaptiveGroupedByStream) {
+  std::vector<int> data(3000);
+  std::iota(data.begin(), data.end(), 0);
+  Stream<int> stream(data.begin(), data.end());
+  auto groups = stream.groupedBy([](auto element) { return element % 10; });
+  ASSERT_EQ(10, groups.size());
+  EXPECT_EQ(300, groups[7].size());
+  EXPECT_EQ(7, groups[7].front());
+  EXPECT_EQ(2997, groups[7].back());
+  auto plan = stream.explain();
+  ASSERT_EQ(2, plan.stages.size());
+  EXPECT_EQ("groupedBy", plan.stages[1].name);
+  EXPECT_EQ("dense", plan.stages[1].strategy);
+
+  auto sparse = stream.groupedBy([](auto element) { return element * 1000; });
+  EXPECT_EQ(3000, sparse.size());
+  EXPECT_EQ("hash", stream.explain().stages[1].strategy);
+}
+
+TEST(StreamTestFixture, ReturnSortedGroupingStream) {
+  std::vector<std::pair<int, int>> trades{{1, 10}, {1, 5}, {2, 7}, {4, 1}, {4, 2}, {4, 3}};
+  Stream<std::pair<int, int>> stream(trades.begin(), trades.end());
+  auto day = [](const auto &trade) { return trade.first; };
+  auto amount = [] { return Collectors::summingLong([](const auto &trade) { return trade.second; }); };
+  EXPECT_THAT(stream.groupingBySorted(day, amount()).toVector(), ::testing::ElementsAre(::testing::Pair(1, 15), ::testing::Pair(2, 7), ::testing::Pair(4, 6)));
+
+  size_t seen = 0;
+  auto first = stream.map([&seen](auto trade) {
+                       seen++;
+                       return trade;
+                     })
+                   .groupingBySorted(day, Collectors::toVector<std::pair<int, int>>())
+                   .limit(1)
+                   .toVector();
+  ASSERT_EQ(1, first.size());
+  EXPECT_EQ(2, first.front().second.size());
+  EXPECT_EQ(3, seen);
+
+  std::vector<std::pair<int, int>> unsorted{{2, 1}, {2, 1}, {1, 1}, {2, 1}};
+  Stream<std::pair<int, int>> unsortedStream(unsorted.begin(), unsorted.end());
+  EXPECT_THAT(unsortedStream.groupingBySorted(day, amount()).toVector(), ::testing::ElementsAre(::testing::Pair(2, 2), ::testing::Pair(1, 1), ::testing::Pair(2, 1)));
+  EXPECT_THROW(unsortedStream.groupingBySorted(day, amount(), true).toVector(), std::invalid_argument);
+  auto descending = unsortedStream.groupingBySorted(day, amount(), true, std::greater<>()).limit(1).toVector();
+  EXPECT_THAT(descending, ::testing::ElementsAre(::testing::Pair(2, 2)));
+}
+
 }// namespace aalbatross::utils::test
 #pragma clang diagnostic pop
\ No newline at end of file
@@ -4,6 +4,24 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 namespace aalbatross::utils::test {
+struct Record {
+  static inline size_t copies = 0;
+  int id;
+  std::vector<std::string> fields;
+
+  explicit Record(int id) : id(id), fields(4, std::string(32, 'f')) {}
+  Record(const Record &other) : id(other.id), fields(other.fields) { copies++; }
+  Record(Record &&) noexcept = default;
+  Record &operator=(const Record &other) {
+    id = other.id;
+    fields = other.fields;
+    copies++;
+    return *this;
+  }
+  Record &operator=(Record &&) noexcept = default;
+  ~Record() = default;
+};
+
 TEST(UBStreamTestFixture, EmptyProcessorTest) {
   std::vector data{1, 2, 3, 4, 5};
   streams::UBStream<int> stream(data.begin(), data.end());
@@ -106,4 +124,107 @@ TEST(UBStreamTestFixture, MovingAverageTest) {
   EXPECT_THAT(elements, ::testing::ElementsAre(DoubleEq(161.95), DoubleEq(262.795), DoubleEq(361.96), DoubleEq(462.165), DoubleEq(561.065), DoubleEq(805.015), DoubleEq(1551.06)));
 }
 
+TEST(UBStreamTestFixture, CollectWithoutMaterializingTest) {
+  std::vector data{1, 2, 3, 4, 5};
+  streams::UBStream<int> stream(data.begin(), data.end());
+  size_t evaluations = 0;
+  auto progress = stream.map([&evaluations](auto element) {
+                          evaluations++;
+                          return element;
+                        })
+                      .collect(streams::Collector{[] { return std::vector<size_t>(); },
+                                                  [&evaluations](std::vector<size_t> &intermediate, const auto & /*element*/) { intermediate.emplace_back(evaluations); },
+                                                  [](std::vector<size_t> &intermediate) { return intermediate; }});
+  EXPECT_THAT(progress, ::testing::ElementsAre(1, 2, 3, 4, 5));
+}
+
+TEST(UBStreamTestFixture, RunningCollectTest) {
+  std::vector data{1, 2, 2, 3, 3, 3, 4, 4, 4, 4};
+  streams::UBStream<int> stream(data.begin(), data.end());
+  EXPECT_THAT(stream.running(streams::Collectors::counting()).toVector(), ::testing::ElementsAre(1, 2, 3, 4, 5, 6, 7, 8, 9, 10));
+  EXPECT_THAT(stream.running(streams::Collectors::approxDistinct<int>(), 3).toVector(), ::testing::ElementsAre(2, 3, 4));
+  EXPECT_THAT(stream.filter([](auto element) { return element % 2 == 0; }).running(streams::Collectors::toVector<int>(), 4).map([](const auto &elements) { return elements.size(); }).toVector(),
+              ::testing::ElementsAre(4));
+  auto topKeys = stream.running(streams::Collectors::heavyHitters<int>(1, 0.5), 5).map([](const auto &top) { return top.front().key; });
+  EXPECT_THAT(topKeys.toVector(), ::testing::ElementsAre(3, 4));
+  auto samples = stream.running(streams::Collectors::sampleSkipping<int>(3, 7), 5).toVector();
+  ASSERT_EQ(2, samples.size());
+  EXPECT_EQ(3, samples[1].size());
+  EXPECT_EQ(samples, stream.running(streams::Collectors::sampleSkipping<int>(3, 7), 5).toVector());
+}
+
+TEST(UBStreamTestFixture, MightContainFilterTest) {
+  std::vector data{1, 2, 3, 4, 5, 6, 7, 8};
+  std::vector build{3, 5, 8};
+  streams::UBStream<int> stream(data.begin(), data.end());
+  auto filter = streams::Collectors::bloomFilter<int>(100, 0.0001).apply(build);
+  EXPECT_THAT(stream.filterMightContain(filter).toVector(), ::testing::ElementsAre(3, 5, 8));
+}
+
+TEST(UBStreamTestFixture, WindowCollectTest) {
+  std::vector data{1, 2, 3, 4, 5, 6, 7, 8};
+  streams::UBStream<int> stream(data.begin(), data.end());
+  auto sum = [] { return streams::Collectors::summingLong([](int element) { return element; }); };
+  EXPECT_THAT(stream.fixed(3, sum()).toVector(), ::testing::ElementsAre(6, 15));
+  EXPECT_THAT(stream.sliding(4, 2, sum()).toVector(), ::testing::ElementsAre(10, 18, 26));
+  EXPECT_THAT(stream.sliding(4, 2, streams::Collectors::quantiles({0.0, 1.0})).toVector(),
+              ::testing::ElementsAre(::testing::ElementsAre(1, 4), ::testing::ElementsAre(3, 6), ::testing::ElementsAre(5, 8)));
+  EXPECT_THROW(stream.sliding(5, 2, sum()), std::invalid_argument);
+  auto histograms = stream.sliding(4, 2, streams::Collectors::histogram(0, 8, 2)).map([](const auto &histogram) { return histogram.count(0); });
+  EXPECT_THAT(histograms.toVector(), ::testing::ElementsAre(3, 1, 0));
+}
+
+TEST(UBStreamTestFixture, SortedGroupingTest) {
+  std::vector<std::pair<int, int>> trades{{1, 10}, {1, 5}, {2, 7}, {4, 1}, {4, 2}, {4, 3}};
+  streams::UBStream<std::pair<int, int>> stream(trades.begin(), trades.end());
+  auto day = [](const auto &trade) { return trade.first; };
+  auto amount = [] { return streams::Collectors::summingLong([](const auto &trade) { return trade.second; }); };
+  EXPECT_THAT(stream.groupingBySorted(day, amount()).toVector(), ::testing::ElementsAre(::testing::Pair(1, 15), ::testing::Pair(2, 7), ::testing::Pair(4, 6)));
+
+  size_t seen = 0;
+  std::vector<size_t> emittedAfter;
+  stream.map([&seen](auto trade) {
+          seen++;
+          return trade;
+        })
+      .groupingBySorted(day, amount())
+      .forEach([&seen, &emittedAfter](const auto & /*group*/) { emittedAfter.emplace_back(seen); });
+  EXPECT_THAT(emittedAfter, ::testing::ElementsAre(3, 4, 6));
+
+  std::vector<std::pair<int, int>> unsorted{{2, 1}, {2, 1}, {1, 1}, {2, 1}};
+  streams::UBStream<std::pair<int, int>> unsortedStream(unsorted.begin(), unsorted.end());
+  EXPECT_THAT(unsortedStream.groupingBySorted(day, amount()).toVector(), ::testing::ElementsAre(::testing::Pair(2, 2), ::testing::Pair(1, 1), ::testing::Pair(2, 1)));
+  auto validated = unsortedStream.groupingBySorted(day, amount(), true);
+  EXPECT_THROW(validated.toVector(), std::invalid_argument);
+  EXPECT_THROW(validated.toVector(), std::invalid_argument);
+  EXPECT_THAT(stream.groupingBySorted(day, amount(), true).toVector(), ::testing::SizeIs(3));
+}
+
+TEST(UBStreamTestFixture, MoveThroughProcessorsTest) {
+  std::vector<Record> data;
+  for (int i = 0; i < 20; i++) {
+    data.emplace_back(i);
+  }
+  streams::UBStream<Record> stream(data.begin(), data.end());
+  Record::copies = 0;
+  auto records = stream.map([](Record record) {
+                         record.fields.emplace_back("mapped");
+                         return record;
+                       })
+                     .filter([](const auto &record) { return record.id % 2 == 0; })
+                     .skip(1)
+                     .limit(5)
+                     .toVector();
+  ASSERT_EQ(5, records.size());
+  EXPECT_EQ(2, records.front().id);
+  EXPECT_EQ(5, records.front().fields.size());
+  // the source is borrowed, every element is copied out of it once and then moved from processor to processor
+  EXPECT_EQ(data.size(), Record::copies);
+
+  Record::copies = 0;
+  auto groups = stream.collect(streams::Collectors::groupingBy<Record>([](const auto &record) { return record.id % 3; }));
+  EXPECT_EQ(7, groups[0].size());
+  EXPECT_EQ(data.size(), Record::copies);
+}
+
 }// namespace aalbatross::utils::test
\ No newline at end of file